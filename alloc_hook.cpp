@@ -0,0 +1,32 @@
+/**
+ * @file alloc_hook.cpp
+ * @brief Replacement of the global operator new that counts the allocations
+ * of the whole program into Polygon::stats(). Not part of polygon_core, a
+ * program opts in by compiling this file into its executable, so programs
+ * with allocation hooks of their own still link against the library.
+ */
+
+#include "instrumentation.h"
+
+#include <cstdlib>
+#include <new>
+
+#if POLYGON_ENABLE_STATS
+/**< The array and nothrow forms forward to it. Like the default one it calls
+ * the new handler until the allocation succeeds or there is no handler. */
+void *operator new(std::size_t size) {
+  count_allocation(size);
+  for (;;) {
+    if (void *memory = std::malloc(size ? size : 1))
+      return memory;
+    const std::new_handler handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+#endif
@@ -0,0 +1,323 @@
+#include "batch.h"
+#include "bounded_queue.h"
+#include "instrumentation.h"
+#include "multi_polygon.h"
+#include "polygon_binary.h"
+#include "polygon_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace { /**< Internal helper functions */
+
+typedef std::chrono::steady_clock Clock;
+
+/**< A job on its way through the pipeline. */
+struct PendingJob {
+  size_t index = 0;              /**< Position in the manifest, 0 based. */
+  BatchJob job;                  /**< What to do. */
+  std::string error;             /**< Set once the job has failed. */
+  std::vector<Polygon> polygons; /**< The inputs, consumed by compute. */
+  size_t verticesIn = 0;         /**< Vertices of all inputs. */
+  MultiPolygon result;           /**< The output rings. */
+  Clock::time_point start;       /**< When the reader took the job. */
+  double readTime = 0.0;         /**< Seconds reading the inputs. */
+  double computeTime = 0.0;      /**< Seconds computing the result. */
+};
+
+typedef BoundedQueue<std::unique_ptr<PendingJob>> JobQueue;
+
+/**
+ * @brief Counting semaphore limiting the jobs between the reader and the
+ * writer. The writer holds finished jobs back until their predecessors are
+ * done, without the limit a single slow job would let it buffer them all.
+ */
+class JobSlots {
+public:
+  explicit JobSlots(size_t count) : available(count) {}
+
+  void acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [this]() { return available > 0; });
+    available--;
+  }
+
+  void release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    available++;
+    released.notify_one();
+  }
+
+private:
+  std::mutex mutex;                 /**< Guards available. */
+  std::condition_variable released; /**< Signalled on release. */
+  size_t available;                 /**< Slots not taken. */
+};
+
+/**< Seconds since a point in time. */
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**< The name of an operation as written in the manifest. */
+const char *operation_name(SetOperation op) {
+  switch (op) {
+  case SetOperation::Union:
+    return "union";
+  case SetOperation::Intersection:
+    return "intersection";
+  case SetOperation::Difference:
+    return "difference";
+  default:
+    return "unknown";
+  }
+}
+
+/**
+ * @brief Read every polygon of a csv or binary file.
+ *
+ * @param filename The name of the file.
+ * @param polygons Output, the polygons are appended.
+ *
+ * @return True if the file could be read.
+ */
+bool read_input(const std::string &filename, std::vector<Polygon> &polygons) {
+  if (is_polygon_binary(filename)) {
+    PolygonFile file;
+    if (!file.open(filename))
+      return false;
+    /**< Stored rings are already in order, they are not sorted again. */
+    for (size_t i = 0; i < file.size(); ++i)
+      polygons.push_back(Polygon::from_ring(
+          std::vector<Point>(file[i].begin(), file[i].end())));
+    return true;
+  }
+
+  std::vector<Polygon> read;
+  if (!Polygon::read_file(filename, read))
+    return false;
+  polygons.insert(polygons.end(), std::make_move_iterator(read.begin()),
+                  std::make_move_iterator(read.end()));
+  return true;
+}
+
+/**< Parse the job and load its polygons. */
+void read_job(PendingJob &pending) {
+  POLYGON_SPAN("read job");
+  const auto start = Clock::now();
+  for (const std::string &input : pending.job.inputs) {
+    if (!read_input(input, pending.polygons)) {
+      pending.error = "cannot read " + input;
+      break;
+    }
+  }
+  for (const Polygon &polygon : pending.polygons)
+    pending.verticesIn += polygon.get_number_of_points();
+  if (pending.error.empty() && pending.polygons.empty())
+    pending.error = "no polygons in the inputs";
+  pending.readTime = seconds_since(start);
+}
+
+/**< Apply the operation, pairwise or reduced over the whole list. */
+void compute_job(PendingJob &pending) {
+  if (!pending.error.empty())
+    return;
+
+  POLYGON_SPAN("compute job");
+  const auto start = Clock::now();
+  std::vector<Polygon> &polygons = pending.polygons;
+  if (polygons.size() == 1)
+    pending.result = MultiPolygon(std::move(polygons.front()));
+  else if (polygons.size() == 2)
+    pending.result =
+        Polygon::compute_boolean(polygons[0], polygons[1], pending.job.op);
+  else
+    pending.result = Polygon::apply_ops_rings_multi_threaded(
+        std::move(polygons), pending.job.op);
+  polygons.clear();
+  pending.computeTime = seconds_since(start);
+}
+
+/**< True if text ends with suffix. */
+bool ends_with(const std::string &text, const std::string &suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * @brief Write the result of a job and report its timing.
+ *
+ * @param pending The computed job.
+ * @param report Output, the timing line.
+ *
+ * @return True if the job succeeded.
+ */
+bool write_job(PendingJob &pending, std::ostream &report) {
+  POLYGON_SPAN("write job");
+  const auto start = Clock::now();
+  const BatchJob &job = pending.job;
+  if (pending.error.empty()) {
+    if (job.output == "-") {
+      std::cout << pending.result << std::flush;
+    } else {
+      const std::vector<PolygonView> rings = pending.result.rings();
+      const bool written = ends_with(job.output, ".bin")
+                               ? write_polygon_binary(job.output, rings)
+                               : write_polygons(job.output, rings);
+      if (!written)
+        pending.error = "cannot write " + job.output;
+    }
+  }
+  const double writeTime = seconds_since(start);
+
+  char line[256];
+  if (!pending.error.empty()) {
+    std::snprintf(line, sizeof(line), "job %zu (line %zu) failed: ",
+                  pending.index + 1, job.line);
+    report << line << pending.error << '\n';
+    return false;
+  }
+
+  std::snprintf(line, sizeof(line),
+                "job %zu (line %zu) %s -> %s: %zu vertices in, %zu out in %zu "
+                "rings, read %.3f ms, compute %.3f ms, write %.3f ms, latency "
+                "%.3f ms\n",
+                pending.index + 1, job.line, operation_name(job.op),
+                job.output.c_str(), pending.verticesIn,
+                pending.result.get_number_of_points(),
+                pending.result.ring_count(), pending.readTime * 1e3,
+                pending.computeTime * 1e3, writeTime * 1e3,
+                seconds_since(pending.start) * 1e3);
+  report << line;
+  return true;
+}
+} // namespace
+
+/**< Whitespace separated fields, the operation name first. */
+bool parse_job(const std::string &text, BatchJob &job, std::string &error) {
+  std::istringstream fields(text);
+  std::string operation;
+  fields >> operation >> job.output;
+
+  job.inputs.clear();
+  std::string input;
+  while (fields >> input)
+    job.inputs.push_back(input);
+
+  if (operation == "union") {
+    job.op = SetOperation::Union;
+  } else if (operation == "intersection") {
+    job.op = SetOperation::Intersection;
+  } else if (operation == "difference") {
+    job.op = SetOperation::Difference;
+  } else {
+    error = "unknown operation '" + operation + "'";
+    return false;
+  }
+
+  if (job.inputs.empty()) {
+    error = "expected <operation> <output> <input> [<input> ...]";
+    return false;
+  }
+  return true;
+}
+
+/**< Reader thread, compute threads and the calling thread as writer. */
+BatchSummary run_batch(std::istream &manifest, std::ostream &report,
+                       const BatchOptions &options) {
+  const auto start = Clock::now();
+  unsigned int computeThreads = options.computeThreads;
+  if (computeThreads == 0)
+    computeThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  /**< The compute threads share the pool of the multi threaded operations
+   * and work on it while they wait, so it only gets the threads of the
+   * budget they leave. The caller's settings come back at the end. */
+  const ParallelOptions callerOptions = Polygon::get_parallel_options();
+  if (computeThreads > 1) {
+    unsigned int budget = callerOptions.threads;
+    if (budget == 0)
+      budget = std::max(1u, std::thread::hardware_concurrency());
+    ParallelOptions shared = callerOptions;
+    shared.threads =
+        (budget > computeThreads) ? budget - computeThreads + 1 : 1;
+    Polygon::set_parallel_options(shared);
+  }
+
+  JobQueue parsed(options.queueCapacity);
+  JobQueue computed(options.queueCapacity);
+  JobSlots slots(2 * options.queueCapacity + computeThreads);
+
+  std::thread reader([&]() {
+    std::string text;
+    size_t lineNumber = 0, index = 0;
+    while (std::getline(manifest, text)) {
+      lineNumber++;
+      const size_t first = text.find_first_not_of(" \t\r");
+      if (first == std::string::npos || text[first] == '#')
+        continue;
+      if (text.back() == '\r')
+        text.pop_back();
+
+      slots.acquire();
+      std::unique_ptr<PendingJob> pending(new PendingJob());
+      pending->index = index++;
+      pending->start = Clock::now();
+      pending->job.line = lineNumber;
+      if (parse_job(text, pending->job, pending->error))
+        read_job(*pending);
+      parsed.push(std::move(pending));
+    }
+    parsed.close();
+  });
+
+  std::atomic<unsigned int> running(computeThreads);
+  std::vector<std::thread> workers;
+  for (unsigned int t = 0; t < computeThreads; ++t) {
+    workers.emplace_back([&]() {
+      std::unique_ptr<PendingJob> pending;
+      while (parsed.pop(pending)) {
+        compute_job(*pending);
+        computed.push(std::move(pending));
+      }
+      if (running.fetch_sub(1) == 1)
+        computed.close(); /**< The last worker ends the writer. */
+    });
+  }
+
+  /**< Jobs finish out of order, they are written in manifest order. */
+  BatchSummary summary;
+  std::map<size_t, std::unique_ptr<PendingJob>> waiting;
+  std::unique_ptr<PendingJob> pending;
+  while (computed.pop(pending)) {
+    waiting[pending->index] = std::move(pending);
+    for (auto next = waiting.find(summary.jobs); next != waiting.end();
+         next = waiting.find(summary.jobs)) {
+      if (!write_job(*next->second, report))
+        summary.failed++;
+      summary.jobs++;
+      waiting.erase(next);
+      slots.release();
+    }
+  }
+
+  reader.join();
+  for (std::thread &worker : workers)
+    worker.join();
+  Polygon::set_parallel_options(callerOptions);
+
+  summary.seconds = seconds_since(start);
+  char line[128];
+  std::snprintf(line, sizeof(line), "%zu jobs, %zu failed, %.3f ms\n",
+                summary.jobs, summary.failed, summary.seconds * 1e3);
+  report << line << std::flush;
+  return summary;
+}
@@ -0,0 +1,83 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One line of a batch manifest,
+ *
+ *   <operation> <output> <input> [<input> ...]
+ *
+ * where the operation is union, intersection or difference. Every polygon of
+ * every input file, csv or binary, takes part in file order: two polygons
+ * are combined with Polygon::compute_boolean, longer lists are reduced with
+ * Polygon::apply_ops_rings_multi_threaded. The result may have several rings,
+ * each hole follows its outer ring. An output of "-" prints them, an output
+ * ending in ".bin" is written in the binary container format, any other one
+ * as csv with one polygon per ring.
+ */
+struct BatchJob {
+  size_t line = 0;                       /**< Line in the manifest, 1 based. */
+  SetOperation op = SetOperation::Union; /**< Operation to apply. */
+  std::string output;                    /**< Where the result goes. */
+  std::vector<std::string> inputs;       /**< Files holding the polygons. */
+};
+
+/**
+ * @brief Parse one manifest line.
+ *
+ * @param text The line, without the line break.
+ * @param job Output, the job.
+ * @param error Output, why the line was rejected.
+ *
+ * @return True if the line holds a job.
+ */
+bool parse_job(const std::string &text, BatchJob &job, std::string &error);
+
+/**
+ * @brief Settings of run_batch.
+ */
+struct BatchOptions {
+  unsigned int computeThreads = 0; /**< 0 for one per hardware thread. The
+                                      threads of ParallelOptions are the
+                                      budget shared with the operations. */
+  size_t queueCapacity = 8;        /**< Jobs waiting between two stages. */
+};
+
+/**
+ * @brief Totals of a batch run.
+ */
+struct BatchSummary {
+  size_t jobs = 0;      /**< Jobs in the manifest. */
+  size_t failed = 0;    /**< Jobs that produced no output. */
+  double seconds = 0.0; /**< Wall time of the whole run. */
+};
+
+/**
+ * @brief Run the jobs of a manifest through a three stage pipeline: one
+ * thread parses the manifest and reads the input files, a group of threads
+ * computes the results and the calling thread writes them. Bounded queues
+ * connect the stages so reading and writing overlap the computation without
+ * holding more than a few jobs in memory. Results are written, and reported,
+ * in manifest order. Blank lines and lines starting with '#' are skipped.
+ *
+ * With several compute threads the threads of Polygon::get_parallel_options
+ * are a budget for the whole run: the pool of the multi threaded operations
+ * is shrunk to what the compute threads leave of it, instead of every job
+ * taking all of it, and the settings are restored when the run ends.
+ *
+ * @param manifest The jobs, one per line.
+ * @param report Output, one timing line per job and a summary.
+ * @param options Thread count and queue capacity.
+ *
+ * @return The totals.
+ */
+BatchSummary run_batch(std::istream &manifest, std::ostream &report,
+                       const BatchOptions &options = BatchOptions());
+
+#endif // BATCH_H
@@ -0,0 +1,662 @@
+#include "polygon.h"
+#include "external.h"
+#include "point_order.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+typedef std::chrono::steady_clock Clock;
+
+/**< Kinds of generated polygons. */
+enum class Shape {
+  Convex,  /**< Vertices on a circle. */
+  Star,    /**< Five smooth lobes, star shaped around the centre. */
+  Concave, /**< A disc with a deep bite taken out of one quarter. */
+};
+
+const Shape all_shapes[] = {Shape::Convex, Shape::Star, Shape::Concave};
+
+const char *shape_name(Shape shape) {
+  switch (shape) {
+  case Shape::Convex:
+    return "convex";
+  case Shape::Star:
+    return "star";
+  default:
+    return "concave";
+  }
+}
+
+/**< Command line settings. */
+struct Settings {
+  unsigned int seed = 42;   /**< Seed of every generator. */
+  size_t maxSize = 1000000; /**< Largest polygon generated. */
+  double overlap = 0.5;     /**< Overlap of neighbouring polygons, 0 to 1. */
+  double minTime = 0.2;     /**< Seconds each measurement runs at least. */
+  bool json = false;        /**< JSON instead of a table. */
+};
+
+/**< One measurement. */
+struct Result {
+  std::string name;      /**< What was measured. */
+  std::string shape;     /**< Kind of polygon, empty if none. */
+  size_t vertices = 0;   /**< Vertices per polygon. */
+  unsigned threads = 1;  /**< Threads the operation could use. */
+  size_t iterations = 0; /**< Calls timed. */
+  double seconds = 0.0;  /**< Mean wall time per call. */
+  std::vector<std::pair<std::string, double>> counters; /**< Extra values. */
+};
+
+/**
+ * @brief Random polygon of a given shape, its vertices in angular order. The
+ * radius only varies smoothly or at a few places, so overlapping polygons
+ * cross in a number of points proportional to their size. Triangles are
+ * always inscribed in the circle.
+ *
+ * @param shape Kind of polygon.
+ * @param count Number of vertices, at least 3.
+ * @param centre Centre of the polygon.
+ * @param radius Outer radius.
+ * @param generator Random source.
+ *
+ * @return The vertices.
+ */
+std::vector<Point> generate_polygon(Shape shape, size_t count,
+                                    const Point &centre, double radius,
+                                    std::mt19937 &generator) {
+  std::uniform_real_distribution<double> jitter(0.0, 0.5);
+  std::uniform_real_distribution<double> phase(0.0, 2.0 * M_PI);
+  const double offset = phase(generator);
+
+  std::vector<Point> points(count);
+  for (size_t i = 0; i < count; ++i) {
+    /**< Jittered but strictly increasing angles keep every vertex apart. */
+    const double a = 2.0 * M_PI * (i + jitter(generator)) / count;
+    double r = radius;
+    if (shape == Shape::Star && count > 3)
+      r *= 0.8 + 0.2 * std::sin(5.0 * a + offset);
+    else if (shape == Shape::Concave && count > 3 && 4 * i >= 3 * count)
+      r *= 0.3;
+    points[i].x = centre.x + r * std::cos(a + offset);
+    points[i].y = centre.y + r * std::sin(a + offset);
+  }
+  return points;
+}
+
+/**
+ * @brief Polygons in a row, each overlapping its neighbours by the given
+ * fraction of their diameter. The pairwise operations run on two of them.
+ *
+ * @param shape Kind of polygon.
+ * @param polygons Number of polygons.
+ * @param vertices Vertices per polygon.
+ * @param overlap Overlap of neighbours, 0 touches, 1 coincides.
+ * @param seed Seed of the generator.
+ *
+ * @return The polygons.
+ */
+std::vector<Polygon> generate_row(Shape shape, size_t polygons,
+                                  size_t vertices, double overlap,
+                                  unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::vector<Polygon> row;
+  row.reserve(polygons);
+  for (size_t i = 0; i < polygons; ++i) {
+    Point centre;
+    centre.x = 2.0 * (1.0 - overlap) * i;
+    row.emplace_back(
+        generate_polygon(shape, vertices, centre, 1.0, generator));
+  }
+  return row;
+}
+
+/**
+ * @brief Polygons whose centres lie in a disc around the origin, the more
+ * they overlap the smaller the disc. Every polygon contains the origin, so
+ * their union and intersection stay star shaped around it.
+ *
+ * @param shape Kind of polygon.
+ * @param polygons Number of polygons.
+ * @param vertices Vertices per polygon.
+ * @param overlap 0 spreads the centres over half the radius, 1 stacks them.
+ * @param seed Seed of the generator.
+ *
+ * @return The polygons.
+ */
+std::vector<Polygon> generate_cluster(Shape shape, size_t polygons,
+                                      size_t vertices, double overlap,
+                                      unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  std::vector<Polygon> cluster;
+  cluster.reserve(polygons);
+  for (size_t i = 0; i < polygons; ++i) {
+    const double a = angle(generator);
+    const double r = 0.25 * (1.0 - overlap) * std::sqrt(unit(generator));
+    Point centre;
+    centre.x = r * std::cos(a);
+    centre.y = r * std::sin(a);
+    cluster.emplace_back(
+        generate_polygon(shape, vertices, centre, 1.0, generator));
+  }
+  return cluster;
+}
+
+/**
+ * @brief Random points on a noisy circle, the shape the polygon code sorts.
+ *
+ * @param count Number of points.
+ * @param seed Seed of the generator.
+ *
+ * @return The points in random order.
+ */
+std::vector<Point> random_ring(size_t count, unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+  std::uniform_real_distribution<double> radius(0.8, 1.0);
+
+  std::vector<Point> points(count);
+  for (Point &point : points) {
+    const double a = angle(generator);
+    const double r = radius(generator);
+    point.x = 1000.0 + r * std::cos(a);
+    point.y = -500.0 + r * std::sin(a);
+  }
+  return points;
+}
+
+/**
+ * @brief Noisy circles of a given size scattered over a square, most pairs
+ * of them are far apart.
+ *
+ * @param count Number of polygons.
+ * @param points Points per polygon.
+ * @param seed Seed of the generator.
+ *
+ * @return The polygons.
+ */
+std::vector<Polygon> scattered_polygons(size_t count, size_t points,
+                                        unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> offset(0.0, 20.0);
+
+  std::vector<Polygon> polygons;
+  for (size_t i = 0; i < count; ++i) {
+    std::vector<Point> ring = random_ring(points, seed + i);
+    const double dx = offset(generator) - 1000.0;
+    const double dy = offset(generator) + 500.0;
+    for (Point &point : ring) {
+      point.x += dx;
+      point.y += dy;
+    }
+    polygons.emplace_back(std::move(ring));
+  }
+  return polygons;
+}
+
+/**
+ * @brief Call a function until the minimum time has passed, at least once.
+ *
+ * @param settings Minimum time.
+ * @param call The function to time.
+ * @param result Output, iterations and mean seconds per call.
+ */
+template <typename Call>
+void measure(const Settings &settings, Call call, Result &result) {
+  size_t iterations = 0;
+  const auto start = Clock::now();
+  double elapsed = 0.0;
+  do {
+    call();
+    iterations++;
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < settings.minTime);
+
+  result.iterations = iterations;
+  result.seconds = elapsed / iterations;
+}
+
+/**< Runs per sort, the best one counts. */
+size_t sort_runs(size_t count) { return count > 100000 ? 3 : 10; }
+
+/**
+ * @brief Best wall time of a sort over several runs on fresh copies.
+ *
+ * @param input Points to sort.
+ * @param sort The sort to time.
+ * @param output The sorted points of the last run.
+ *
+ * @return Seconds.
+ */
+template <typename Sort>
+double time_sort(const std::vector<Point> &input, Sort sort,
+                 std::vector<Point> &output) {
+  double best = 1e300;
+  for (size_t run = 0; run < sort_runs(input.size()); ++run) {
+    output = input;
+    const auto start = Clock::now();
+    sort(output);
+    const auto stop = Clock::now();
+    best = std::min(best, std::chrono::duration<double>(stop - start).count());
+  }
+  return best;
+}
+
+/**< Polygon sizes from 3 up to the configured maximum. */
+std::vector<size_t> polygon_sizes(const Settings &settings) {
+  std::vector<size_t> sizes;
+  for (size_t size = 3; size <= settings.maxSize;
+       size = (size == 3) ? 10 : size * 10)
+    sizes.push_back(size);
+  return sizes;
+}
+
+/**< Thread counts for the multi threaded reductions. */
+std::vector<unsigned int> thread_counts() {
+  const unsigned int hardware =
+      std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned int> counts = {1, 2, 4};
+  if (hardware > 4)
+    counts.push_back(hardware);
+  return counts;
+}
+
+/**< The angular sort against its atan2 reference. */
+void bench_sort(const Settings &settings, std::vector<Result> &results) {
+  for (size_t count = 100; count <= settings.maxSize; count *= 10) {
+    const std::vector<Point> input = random_ring(count, settings.seed);
+    std::vector<Point> reference, kernel;
+
+    Result atan2Sort, pseudoSort;
+    atan2Sort.name = "sort_atan2";
+    pseudoSort.name = "sort_pseudo_angle";
+    atan2Sort.vertices = pseudoSort.vertices = count;
+    atan2Sort.iterations = pseudoSort.iterations = sort_runs(count);
+    atan2Sort.seconds = time_sort(input, sort_by_polar_angle_atan2, reference);
+    pseudoSort.seconds = time_sort(input, sort_by_polar_angle, kernel);
+
+    /**< Positions where the orders differ, only ties may legitimately. */
+    size_t mismatch = 0;
+    for (size_t i = 0; i < count; ++i)
+      if ((reference[i].x != kernel[i].x) || (reference[i].y != kernel[i].y))
+        mismatch++;
+    pseudoSort.counters.emplace_back("mismatch", mismatch);
+
+    results.push_back(atan2Sort);
+    results.push_back(pseudoSort);
+  }
+}
+
+/**< Validity, without the cache, and point in polygon per shape and size. */
+void bench_predicates(const Settings &settings, std::vector<Result> &results) {
+  std::mt19937 generator(settings.seed);
+  for (Shape shape : all_shapes) {
+    for (size_t size : polygon_sizes(settings)) {
+      /**< Ordered the way Polygon orders its vertices. */
+      std::vector<Point> vertices =
+          generate_polygon(shape, size, Point(), 1.0, generator);
+      sort_by_polar_angle(vertices);
+
+      Result valid;
+      valid.name = "is_valid";
+      valid.shape = shape_name(shape);
+      valid.vertices = size;
+      const PolygonView view(vertices);
+      measure(settings, [&]() { return view.is_valid(); }, valid);
+      results.push_back(valid);
+
+      /**< Fewer queries for large polygons, each one walks every edge. */
+      const size_t queryCount = std::max<size_t>(16, 1000000 / size);
+      std::uniform_real_distribution<double> coordinate(-1.1, 1.1);
+      std::vector<Point> queries(std::min<size_t>(queryCount, 4096));
+      for (Point &query : queries) {
+        query.x = coordinate(generator);
+        query.y = coordinate(generator);
+      }
+
+      Result inside;
+      inside.name = "is_point_inside_polygon";
+      inside.shape = shape_name(shape);
+      inside.vertices = size;
+      int sink = 0;
+      measure(settings, [&]() {
+        for (const Point &query : queries)
+          sink += is_point_inside_polygon(query, vertices);
+      }, inside);
+      inside.seconds /= queries.size();
+      inside.counters.emplace_back("queries_per_call", queries.size());
+      inside.counters.emplace_back("checksum", sink);
+      results.push_back(inside);
+    }
+  }
+}
+
+/**< Segment intersection on random segment pairs. */
+void bench_segments(const Settings &settings, std::vector<Result> &results) {
+  std::mt19937 generator(settings.seed);
+  std::uniform_real_distribution<double> coordinate(0.0, 1.0);
+  std::vector<Point> ends(4 * 4096);
+  for (Point &end : ends) {
+    end.x = coordinate(generator);
+    end.y = coordinate(generator);
+  }
+
+  Result segments;
+  segments.name = "do_lines_intersect";
+  segments.vertices = 2;
+  size_t hits = 0;
+  measure(settings, [&]() {
+    Point crossing;
+    for (size_t i = 0; i < ends.size(); i += 4)
+      hits += do_lines_intersect(ends[i], ends[i + 1], ends[i + 2],
+                                 ends[i + 3], crossing);
+  }, segments);
+  segments.seconds /= ends.size() / 4;
+  segments.counters.emplace_back("hits", hits);
+  results.push_back(segments);
+}
+
+/**< Every pairwise operation on two overlapping polygons. */
+void bench_operations(const Settings &settings,
+                      std::vector<Result> &results) {
+  const SetOperation ops[] = {SetOperation::Union, SetOperation::Intersection,
+                              SetOperation::Difference};
+  const char *names[] = {"compute_union", "compute_intersection",
+                         "compute_subtraction"};
+
+  for (Shape shape : all_shapes) {
+    for (size_t size : polygon_sizes(settings)) {
+      const std::vector<Polygon> pair =
+          generate_row(shape, 2, size, settings.overlap, settings.seed);
+      for (int k = 0; k < 3; ++k) {
+        Result operation;
+        operation.name = names[k];
+        operation.shape = shape_name(shape);
+        operation.vertices = size;
+        size_t output = 0;
+        measure(settings, [&]() {
+          output = Polygon::compute_operation(pair[0], pair[1], ops[k])
+                       .get_number_of_points();
+        }, operation);
+        operation.counters.emplace_back("output_vertices", output);
+        results.push_back(operation);
+      }
+    }
+  }
+}
+
+/**< Reductions over a cluster of polygons, sequential and on the pool. */
+void bench_reductions(const Settings &settings,
+                      std::vector<Result> &results) {
+  const size_t polygons = 64;
+  const SetOperation ops[] = {SetOperation::Union,
+                              SetOperation::Intersection};
+  const char *names[] = {"union", "intersection"};
+  const ParallelOptions defaults = Polygon::get_parallel_options();
+
+  for (Shape shape : all_shapes) {
+    for (size_t size : polygon_sizes(settings)) {
+      if (size * polygons > settings.maxSize)
+        break;
+      const std::vector<Polygon> cluster = generate_cluster(
+          shape, polygons, size, settings.overlap, settings.seed);
+
+      for (int k = 0; k < 2; ++k) {
+        Result sequential;
+        sequential.name = std::string("apply_ops_") + names[k];
+        sequential.shape = shape_name(shape);
+        sequential.vertices = size;
+        sequential.counters.emplace_back("polygons", polygons);
+        measure(settings, [&]() { Polygon::apply_ops(cluster, ops[k]); },
+                sequential);
+        results.push_back(sequential);
+
+        for (unsigned int threads : thread_counts()) {
+          ParallelOptions options = defaults;
+          options.threads = threads;
+          Polygon::set_parallel_options(options);
+
+          Result parallel = sequential;
+          parallel.name = std::string("apply_ops_multi_threaded_") + names[k];
+          parallel.threads = threads;
+          measure(settings, [&]() {
+            Polygon::apply_ops_multi_threaded(cluster, ops[k]);
+          }, parallel);
+          results.push_back(parallel);
+        }
+        Polygon::set_parallel_options(defaults);
+      }
+    }
+  }
+}
+
+/**< Independent jobs of very different sizes, in a loop and batched. */
+void bench_batch(const Settings &settings, std::vector<Result> &results) {
+  const size_t jobs = 256;
+  const size_t largest = std::min<size_t>(settings.maxSize, 10000);
+  const SetOperation ops[] = {SetOperation::Union, SetOperation::Intersection,
+                              SetOperation::Difference};
+  const ParallelOptions defaults = Polygon::get_parallel_options();
+
+  /**< Sizes spread log uniformly, a few jobs dominate the total. */
+  std::mt19937 generator(settings.seed);
+  std::uniform_real_distribution<double> exponent(
+      std::log(3.0), std::log(std::max(3.0, static_cast<double>(largest))));
+  std::vector<Polygon> polygons;
+  polygons.reserve(2 * jobs);
+  size_t vertices = 0;
+  for (size_t i = 0; i < jobs; ++i) {
+    const size_t size = static_cast<size_t>(std::exp(exponent(generator)));
+    std::vector<Polygon> pair = generate_row(Shape::Star, 2, size,
+                                             settings.overlap,
+                                             settings.seed + i);
+    polygons.push_back(std::move(pair[0]));
+    polygons.push_back(std::move(pair[1]));
+    vertices += 2 * size;
+  }
+  std::vector<OperationRequest> requests(jobs);
+  for (size_t i = 0; i < jobs; ++i) {
+    requests[i].A = &polygons[2 * i];
+    requests[i].B = &polygons[2 * i + 1];
+    requests[i].op = ops[i % 3];
+  }
+
+  /**< Build the cached indexes first, or the first variant pays for them. */
+  for (const OperationRequest &request : requests)
+    Polygon::compute_operation(*request.A, *request.B, request.op);
+
+  Result loop;
+  loop.name = "compute_operation_loop";
+  loop.shape = "star";
+  loop.vertices = vertices / jobs;
+  loop.counters.emplace_back("jobs", jobs);
+  measure(settings, [&]() {
+    for (const OperationRequest &request : requests)
+      Polygon::compute_operation(*request.A, *request.B, request.op);
+  }, loop);
+  results.push_back(loop);
+
+  for (unsigned int threads : thread_counts()) {
+    ParallelOptions options = defaults;
+    options.threads = threads;
+    Polygon::set_parallel_options(options);
+
+    Result batch = loop;
+    batch.name = "compute_batch";
+    batch.threads = threads;
+    measure(settings, [&]() {
+      Polygon::compute_batch(requests.data(), requests.size());
+    }, batch);
+    results.push_back(batch);
+  }
+  Polygon::set_parallel_options(defaults);
+}
+
+/**< Every pair of a scattered set, to show the bounding box fast paths. */
+void bench_scattered(const Settings &settings, std::vector<Result> &results) {
+  const std::vector<Polygon> polygons =
+      scattered_polygons(40, 200, settings.seed);
+
+  Result scattered;
+  scattered.name = "scattered_pairs";
+  scattered.shape = "star";
+  scattered.vertices = 200;
+  Polygon::reset_stats();
+  measure(settings, [&]() {
+    for (size_t i = 0; i < polygons.size(); ++i) {
+      for (size_t j = i + 1; j < polygons.size(); ++j) {
+        Polygon::compute_union(polygons[i], polygons[j]);
+        Polygon::compute_subtraction(polygons[i], polygons[j]);
+      }
+    }
+  }, scattered);
+
+  const OperationStats stats = Polygon::stats();
+  scattered.counters.emplace_back("operations", stats.operations);
+  scattered.counters.emplace_back("disjoint_operations",
+                                  stats.disjointOperations);
+  scattered.counters.emplace_back("edges_rejected", stats.edgesRejected);
+  scattered.counters.emplace_back("point_tests_rejected",
+                                  stats.pointTestsRejected);
+  results.push_back(scattered);
+}
+
+/**< Append a JSON string, the names here never need escaping. */
+void append_string(std::string &json, const std::string &text) {
+  json.push_back('"');
+  json += text;
+  json.push_back('"');
+}
+
+/**< Append a number, integers without a fraction. */
+void append_number(std::string &json, double value) {
+  char text[32];
+  if (value == std::floor(value) && std::fabs(value) < 1e15)
+    std::snprintf(text, sizeof(text), "%.0f", value);
+  else
+    std::snprintf(text, sizeof(text), "%.9g", value);
+  json += text;
+}
+
+/**< One object per result, with the settings of the run. */
+std::string to_json(const Settings &settings,
+                    const std::vector<Result> &results) {
+  std::string json = "{\n  \"seed\": ";
+  append_number(json, settings.seed);
+  json += ",\n  \"overlap\": ";
+  append_number(json, settings.overlap);
+  json += ",\n  \"hardware_threads\": ";
+  append_number(json, std::thread::hardware_concurrency());
+  json += ",\n  \"results\": [";
+
+  for (size_t r = 0; r < results.size(); ++r) {
+    const Result &result = results[r];
+    json += (r == 0) ? "\n    {" : ",\n    {";
+    json += "\"name\": ";
+    append_string(json, result.name);
+    json += ", \"shape\": ";
+    append_string(json, result.shape);
+    json += ", \"vertices\": ";
+    append_number(json, result.vertices);
+    json += ", \"threads\": ";
+    append_number(json, result.threads);
+    json += ", \"iterations\": ";
+    append_number(json, result.iterations);
+    json += ", \"ns_per_op\": ";
+    append_number(json, result.seconds * 1e9);
+    for (const auto &counter : result.counters) {
+      json += ", ";
+      append_string(json, counter.first);
+      json += ": ";
+      append_number(json, counter.second);
+    }
+    json.push_back('}');
+  }
+  json += "\n  ]\n}\n";
+  return json;
+}
+
+/**< One line per result. */
+void print_table(const std::vector<Result> &results) {
+  std::printf("%-38s %-8s %9s %7s %10s %14s\n", "benchmark", "shape",
+              "vertices", "threads", "iterations", "ns/op");
+  for (const Result &result : results) {
+    std::printf("%-38s %-8s %9zu %7u %10zu %14.1f", result.name.c_str(),
+                result.shape.c_str(), result.vertices, result.threads,
+                result.iterations, result.seconds * 1e9);
+    for (const auto &counter : result.counters)
+      std::printf("  %s=%.0f", counter.first.c_str(), counter.second);
+    std::printf("\n");
+  }
+}
+
+/**< Command line help. */
+void print_usage(const char *program) {
+  std::cerr << "usage: " << program
+            << " [--json] [--seed N] [--max-size N] [--overlap F]"
+               " [--min-time S] [--filter NAME]\n";
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  Settings settings;
+  std::string filter;
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--json") == 0) {
+      settings.json = true;
+    } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+      settings.seed = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--max-size") == 0 && hasValue) {
+      settings.maxSize = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--overlap") == 0 && hasValue) {
+      settings.overlap = std::min(1.0, std::max(0.0, std::atof(argv[++i])));
+    } else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+      settings.minTime = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+      filter = argv[++i];
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  /**< Groups of benchmarks, --filter runs those whose name contains it. */
+  typedef void (*Bench)(const Settings &, std::vector<Result> &);
+  const std::pair<const char *, Bench> benches[] = {
+      {"sort", bench_sort},
+      {"predicates", bench_predicates},
+      {"segments", bench_segments},
+      {"operations", bench_operations},
+      {"reductions", bench_reductions},
+      {"batch", bench_batch},
+      {"scattered", bench_scattered},
+  };
+
+  std::vector<Result> results;
+  for (const auto &bench : benches)
+    if (filter.empty() || std::string(bench.first).find(filter) !=
+                              std::string::npos)
+      bench.second(settings, results);
+
+  if (settings.json)
+    std::cout << to_json(settings, results);
+  else
+    print_table(results);
+
+  return 0;
+}
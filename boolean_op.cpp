@@ -0,0 +1,827 @@
+#include "boolean_op.h"
+#include "predicates.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <set>
+
+namespace { /**< Internal helper functions */
+
+struct SweepEvent;
+
+/**< Order of the edges on the sweep line, bottom to top. */
+struct SegmentOrder {
+  bool operator()(const SweepEvent *a, const SweepEvent *b) const;
+};
+
+typedef std::set<SweepEvent *, SegmentOrder> Status;
+
+/**< Index of an event that is not part of the result. */
+const size_t no_position = static_cast<size_t>(-1);
+
+/**
+ * @brief An endpoint of an edge. The sweep splits edges, so the endpoint an
+ * event is paired with may change until the event is processed.
+ */
+struct SweepEvent {
+  Point point;                      /**< Where the event happens. */
+  bool left = false;                /**< The edge starts here. */
+  SweepEvent *other = nullptr;      /**< The other endpoint of the edge. */
+  bool subject = false;             /**< Edge of the subject region. */
+  size_t id = 0;                    /**< Creation order, breaks ties. */
+
+  /**< Left events only. Edges lying on each other are merged into the
+   * lowest of them, which crosses its own region if an odd number of them
+   * belongs to it, and the other region likewise. The rest cross nothing. */
+  bool crossesOwn = true;
+  bool crossesOther = false;
+
+  /**< Left events only, for a ray going up through the edge: the edge
+   * leaves its own region, and the edge of the other region below it left
+   * the other region, so the point just above it is outside the other. */
+  bool inOut = false;
+  bool otherInOut = false;
+
+  SweepEvent *prevInResult = nullptr; /**< Closest result edge below. */
+  int resultTransition = 0; /**< 0 if dropped, +1 if the result lies above
+                               the edge, -1 if it lies below. */
+  int ring = -1;            /**< Output ring the edge was linked into. */
+  size_t position = no_position; /**< Index among the result events. */
+  bool inStatus = false;         /**< The edge is on the sweep line. */
+  Status::iterator statusPos;    /**< Its node there. */
+
+  /**< Ends of the input edge, left first. Split points are rounded, so the
+   * pieces of an edge are all tested against its original line, which keeps
+   * the tests consistent as the edge is split further. */
+  Point lineStart;
+  Point lineEnd;
+
+  /**< Orientation of p against the line of the edge, positive above. */
+  double side(const Point &p) const { return orient2d(lineStart, lineEnd, p); }
+
+  /**< The edge lies below p, exactly. */
+  bool is_below(const Point &p) const { return side(p) > 0.0; }
+
+  bool is_vertical() const { return point.x == other->point.x; }
+};
+
+bool same_point(const Point &a, const Point &b) {
+  return a.x == b.x && a.y == b.y;
+}
+
+/**
+ * @brief Order of the event queue: left to right, bottom to top, edges
+ * ending at a point before edges starting there, the lower of two edges
+ * first.
+ *
+ * @return True if a is processed after b.
+ */
+bool processed_after(const SweepEvent *a, const SweepEvent *b) {
+  if (a->point.x != b->point.x)
+    return a->point.x > b->point.x;
+  if (a->point.y != b->point.y)
+    return a->point.y > b->point.y;
+  if (a->left != b->left)
+    return a->left;
+
+  if (a->side(b->other->point) != 0.0)
+    return !a->is_below(b->other->point);
+  /**< On one line, subject edges first. */
+  if (a->subject != b->subject)
+    return !a->subject;
+  return a->id > b->id;
+}
+
+/**< Both are left events of edges crossing the sweep line. */
+bool SegmentOrder::operator()(const SweepEvent *a, const SweepEvent *b) const {
+  if (a == b)
+    return false;
+
+  if (a->side(b->lineStart) != 0.0 || a->side(b->lineEnd) != 0.0) {
+    /**< Same start, the direction decides. */
+    if (same_point(a->point, b->point))
+      return a->is_below(b->other->point);
+    if (a->point.x == b->point.x)
+      return a->point.y < b->point.y;
+    /**< Place the edge that starts later against the earlier one, by its
+     * start or, if that lies on the earlier edge, by its end. */
+    const bool aLater = processed_after(a, b);
+    const SweepEvent *early = aLater ? b : a;
+    const SweepEvent *late = aLater ? a : b;
+    double side = early->side(late->point);
+    if (side == 0.0)
+      side = early->side(late->other->point);
+    return aLater ? (side < 0.0) : (side > 0.0);
+  }
+
+  /**< On one line, subject edges first. */
+  if (a->subject != b->subject)
+    return a->subject;
+  if (same_point(a->point, b->point))
+    return a->id < b->id;
+  return !processed_after(a, b);
+}
+
+/**
+ * @brief Where a turn at a vertex ends up, counting clockwise from the
+ * direction back along the incoming edge.
+ *
+ * @return 0 for less than half a turn, 1 for straight on, 2 for more than
+ * half a turn and 3 for straight back.
+ */
+int turn_half(const Point &vertex, const Point &back, const Point &to) {
+  const double side = orient2d(vertex, back, to);
+  if (side != 0.0)
+    return (side < 0.0) ? 0 : 2;
+  /**< On one line, the signs of the differences are exact. */
+  const double dot = (to.x - vertex.x) * (back.x - vertex.x) +
+                     (to.y - vertex.y) * (back.y - vertex.y);
+  return (dot > 0.0) ? 3 : 1;
+}
+
+/**< Turning clockwise from back, edge a comes before edge b. */
+bool turns_before(const Point &vertex, const Point &back, const Point &a,
+                  const Point &b) {
+  const int halfA = turn_half(vertex, back, a);
+  const int halfB = turn_half(vertex, back, b);
+  if (halfA != halfB)
+    return halfA < halfB;
+  return (halfA == 0 || halfA == 2) && orient2d(vertex, a, b) < 0.0;
+}
+
+/**< Inverse of processed_after, the queue yields its largest element. */
+struct LaterEvent {
+  bool operator()(const SweepEvent *a, const SweepEvent *b) const {
+    return processed_after(a, b);
+  }
+};
+
+/**
+ * @brief Where two edges meet, exactly decided, the crossing point itself
+ * is rounded, kept inside both edges' boxes and snapped to an endpoint a
+ * few ulps away.
+ *
+ * @param a Left event of the first edge.
+ * @param b Left event of the second edge.
+ * @param first Output, the meeting point or the start of the overlap.
+ * @param second Output, the end of the overlap.
+ *
+ * @return 0 if the edges are apart, 1 if they share one point, 2 if they
+ * overlap between first and second.
+ */
+int intersect_edges(const SweepEvent *a, const SweepEvent *b, Point &first,
+                    Point &second) {
+  const Point &a1 = a->point, &a2 = a->other->point;
+  const Point &b1 = b->point, &b2 = b->other->point;
+
+  if (a->side(b->lineStart) == 0.0 && a->side(b->lineEnd) == 0.0) {
+    /**< On one line, along which the endpoints sort like the events. */
+    first = (a1 < b1) ? b1 : a1;
+    second = (b2 < a2) ? b2 : a2;
+    if (second < first)
+      return 0;
+    return same_point(first, second) ? 1 : 2;
+  }
+
+  const double b1Side = a->side(b1);
+  const double b2Side = a->side(b2);
+  if ((b1Side > 0.0 && b2Side > 0.0) || (b1Side < 0.0 && b2Side < 0.0))
+    return 0;
+
+  const double a1Side = b->side(a1);
+  const double a2Side = b->side(a2);
+  if ((a1Side > 0.0 && a2Side > 0.0) || (a1Side < 0.0 && a2Side < 0.0))
+    return 0;
+
+  /**< An endpoint on the other edge is the meeting point as is. */
+  if (b1Side == 0.0)
+    first = b1;
+  else if (b2Side == 0.0)
+    first = b2;
+  else if (a1Side == 0.0)
+    first = a1;
+  else if (a2Side == 0.0)
+    first = a2;
+  else {
+    /**< Where the lines cross, clamped to the pieces. */
+    const Point &start = a->lineStart, &end = a->lineEnd;
+    const double startSide = b->side(start);
+    const double t = startSide / (startSide - b->side(end));
+    first.x = start.x + t * (end.x - start.x);
+    first.y = start.y + t * (end.y - start.y);
+    first.x = std::max(first.x, std::max(a1.x, b1.x));
+    first.x = std::min(first.x, std::min(a2.x, b2.x));
+    first.y = std::max(first.y, std::max(std::min(a1.y, a2.y),
+                                         std::min(b1.y, b2.y)));
+    first.y = std::min(first.y, std::min(std::max(a1.y, a2.y),
+                                         std::max(b1.y, b2.y)));
+
+    /**< An endpoint a few ulps off the other line is still where the edges
+     * meet, do not make a new point next to it. */
+    double scale = 0.0;
+    for (const Point *end : {&a1, &a2, &b1, &b2})
+      scale = std::max(scale, std::max(std::abs(end->x), std::abs(end->y)));
+    const double tolerance = 16.0 * unit_roundoff * scale;
+    for (const Point *end : {&a1, &a2, &b1, &b2}) {
+      if (std::abs(first.x - end->x) <= tolerance &&
+          std::abs(first.y - end->y) <= tolerance) {
+        first = *end;
+        break;
+      }
+    }
+  }
+  return 1;
+}
+
+/**< Whether a point is in the result, given whether it is in the subject
+ * and in the clipping region. */
+bool in_operation(SetOperation op, bool inSubject, bool inClipping) {
+  switch (op) {
+  case SetOperation::Union:
+    return inSubject || inClipping;
+  case SetOperation::Intersection:
+    return inSubject && inClipping;
+  case SetOperation::Difference:
+    return inSubject && !inClipping;
+  case SetOperation::Xor:
+    return inSubject != inClipping;
+  }
+  return false;
+}
+
+/**
+ * @brief Whether an edge bounds the result.
+ *
+ * @param event Left event of the edge.
+ * @param op The operation.
+ *
+ * @return 0 if it does not, +1 if the result lies above the edge, -1 if it
+ * lies below.
+ */
+int result_transition(const SweepEvent *event, SetOperation op) {
+  const bool ownBelow = event->inOut;
+  const bool otherBelow = !event->otherInOut;
+  const bool ownAbove = ownBelow != event->crossesOwn;
+  const bool otherAbove = otherBelow != event->crossesOther;
+  const bool below = event->subject ? in_operation(op, ownBelow, otherBelow)
+                                    : in_operation(op, otherBelow, ownBelow);
+  const bool above = event->subject ? in_operation(op, ownAbove, otherAbove)
+                                    : in_operation(op, otherAbove, ownAbove);
+  if (below == above)
+    return 0;
+  return above ? 1 : -1;
+}
+
+/**
+ * @brief The sweep over the edges of both regions, splitting them where
+ * they meet and marking which pieces bound the result.
+ */
+class BooleanSweep {
+public:
+  explicit BooleanSweep(SetOperation op) : op(op) {}
+
+  /**
+   * @brief Queue the edges of a region.
+   *
+   * @param rings Rings of the region.
+   * @param subject True for the subject region.
+   */
+  void add_region(const std::vector<PolygonView> &rings, bool subject) {
+    for (const PolygonView &ring : rings) {
+      if (ring.size() < 3)
+        continue;
+      for (size_t i = 0; i < ring.size(); ++i) {
+        const Point &start = ring[i];
+        const Point &end = ring[(i + 1) % ring.size()];
+        if (same_point(start, end))
+          continue;
+        SweepEvent *a = new_event(start, false, nullptr, subject);
+        SweepEvent *b = new_event(end, false, a, subject);
+        a->other = b;
+        (end < start ? b : a)->left = true;
+        a->lineStart = b->lineStart = std::min(start, end);
+        a->lineEnd = b->lineEnd = std::max(start, end);
+        queue.push(a);
+        queue.push(b);
+      }
+    }
+  }
+
+  /**
+   * @brief Process the events left to right.
+   *
+   * @param stopX Events right of it cannot change the result.
+   */
+  void run(double stopX) {
+    while (!queue.empty()) {
+      SweepEvent *event = queue.top();
+      queue.pop();
+      processed.push_back(event);
+      if (event->point.x > stopX)
+        break;
+
+      if (event->left)
+        insert(event);
+      else
+        remove(event->other);
+    }
+  }
+
+  /**
+   * @brief Link the edges of the result into rings.
+   *
+   * @param rings Output, in the order their lowest left vertices are swept.
+   * The result lies left of every ring, so outer rings run counter
+   * clockwise and holes clockwise.
+   */
+  void connect(std::vector<ResultRing> &rings);
+
+private:
+  SweepEvent *new_event(const Point &point, bool left, SweepEvent *other,
+                        bool subject) {
+    events.emplace_back();
+    SweepEvent *event = &events.back();
+    event->point = point;
+    event->left = left;
+    event->other = other;
+    event->subject = subject;
+    event->id = events.size();
+    return event;
+  }
+
+  /**< The edge starts, set its flags from the edge below it. */
+  void compute_fields(SweepEvent *event, const SweepEvent *prev) const {
+    if (!prev) {
+      event->inOut = false;
+      event->otherInOut = true;
+      event->prevInResult = nullptr;
+    } else {
+      if (event->subject == prev->subject) {
+        event->inOut = !prev->inOut;
+        event->otherInOut = prev->otherInOut;
+      } else {
+        event->inOut = !prev->otherInOut;
+        event->otherInOut = prev->is_vertical() ? !prev->inOut : prev->inOut;
+      }
+      event->prevInResult =
+          (prev->resultTransition == 0 || prev->is_vertical())
+              ? prev->prevInResult
+              : const_cast<SweepEvent *>(prev);
+    }
+    event->resultTransition = result_transition(event, op);
+  }
+
+  /**< Split an edge at a point strictly inside it. */
+  void divide(SweepEvent *event, const Point &point) {
+    SweepEvent *right = new_event(point, false, event, event->subject);
+    SweepEvent *left = new_event(point, true, event->other, event->subject);
+    right->lineStart = left->lineStart = event->lineStart;
+    right->lineEnd = left->lineEnd = event->lineEnd;
+
+    /**< Rounding put the point past the end, swap the roles. */
+    if (processed_after(left, event->other)) {
+      event->other->left = true;
+      left->left = false;
+    }
+    event->other->other = left;
+    event->other = right;
+    queue.push(left);
+    queue.push(right);
+  }
+
+  /**
+   * @brief Split two edges neighbouring on the sweep line where they meet.
+   * Edges lying on each other are cut to pieces that start and end
+   * together, see merge_overlaps.
+   */
+  void possible_intersection(SweepEvent *a, SweepEvent *b) {
+    Point first, second;
+    const int found = intersect_edges(a, b, first, second);
+    if (found == 0)
+      return;
+    if (found == 1 && (same_point(a->point, b->point) ||
+                       same_point(a->other->point, b->other->point)))
+      return;
+    if (found == 1) {
+      if (!same_point(a->point, first) && !same_point(a->other->point, first))
+        divide(a, first);
+      if (!same_point(b->point, first) && !same_point(b->other->point, first))
+        divide(b, first);
+      return;
+    }
+
+    /**< The edges overlap, sort their four endpoints. */
+    SweepEvent *sorted[4];
+    int count = 0;
+    const bool leftCoincide = same_point(a->point, b->point);
+    const bool rightCoincide = same_point(a->other->point, b->other->point);
+    if (!leftCoincide) {
+      const bool swap = processed_after(a, b);
+      sorted[count++] = swap ? b : a;
+      sorted[count++] = swap ? a : b;
+    }
+    if (!rightCoincide) {
+      const bool swap = processed_after(a->other, b->other);
+      sorted[count++] = swap ? b->other : a->other;
+      sorted[count++] = swap ? a->other : b->other;
+    }
+
+    if (leftCoincide) {
+      if (!rightCoincide)
+        divide(sorted[1]->other, sorted[0]->point);
+      return;
+    }
+    if (rightCoincide) {
+      divide(sorted[0], sorted[1]->point);
+      return;
+    }
+    if (sorted[0] != sorted[3]->other) {
+      /**< Neither contains the other. */
+      divide(sorted[0], sorted[1]->point);
+      divide(sorted[1], sorted[2]->point);
+      return;
+    }
+    /**< One contains the other. */
+    divide(sorted[0], sorted[1]->point);
+    divide(sorted[3]->other, sorted[2]->point);
+    return;
+  }
+
+  /**< Neighbours of an edge on the sweep line, null if none. */
+  SweepEvent *below(Status::iterator it) const {
+    return (it == status.begin()) ? nullptr : *std::prev(it);
+  }
+  SweepEvent *above(Status::iterator it) const {
+    ++it;
+    return (it == status.end()) ? nullptr : *it;
+  }
+
+  /**< An edge starts. */
+  void insert(SweepEvent *event) {
+    event->statusPos = status.insert(event).first;
+    event->inStatus = true;
+    SweepEvent *prev = below(event->statusPos);
+    SweepEvent *next = above(event->statusPos);
+
+    compute_fields(event, prev);
+    if (next)
+      possible_intersection(event, next);
+    if (prev)
+      possible_intersection(prev, event);
+
+    /**< A neighbour was split where this edge starts, it was placed against
+     * a rounded line. Retry once the piece ending here has left. */
+    if ((next && same_point(next->other->point, event->point)) ||
+        (prev && same_point(prev->other->point, event->point))) {
+      status.erase(event->statusPos);
+      event->inStatus = false;
+      processed.pop_back();
+      queue.push(event);
+      return;
+    }
+    merge_overlaps(event);
+  }
+
+  /**< The edges starting at the point of an edge on its line, which lie on
+   * each other. They are cut at the nearest end and merged into the lowest,
+   * so that any number of them counts once per region and parity. */
+  void merge_overlaps(SweepEvent *event) {
+    auto overlaps = [event](const SweepEvent *edge) {
+      return same_point(edge->point, event->point) &&
+             event->side(edge->lineStart) == 0.0 &&
+             event->side(edge->lineEnd) == 0.0;
+    };
+    Status::iterator first = event->statusPos;
+    Status::iterator last = std::next(first);
+    while (first != status.begin() && overlaps(*std::prev(first)))
+      --first;
+    while (last != status.end() && overlaps(*last))
+      ++last;
+    if (std::next(first) == last)
+      return;
+
+    const SweepEvent *nearest = *first;
+    for (Status::iterator it = first; it != last; ++it) {
+      if (processed_after(nearest->other, (*it)->other))
+        nearest = *it;
+    }
+    const Point end = nearest->other->point;
+    SweepEvent *lowest = *first;
+    bool ownOdd = false, otherOdd = false;
+    for (Status::iterator it = first; it != last; ++it) {
+      if (!same_point((*it)->other->point, end))
+        divide(*it, end);
+      if ((*it)->subject == lowest->subject)
+        ownOdd = !ownOdd;
+      else
+        otherOdd = !otherOdd;
+    }
+
+    const SweepEvent *prev = below(first);
+    for (Status::iterator it = first; it != last; ++it) {
+      (*it)->crossesOwn = (*it == lowest) && ownOdd;
+      (*it)->crossesOther = (*it == lowest) && otherOdd;
+      compute_fields(*it, prev);
+      prev = *it;
+    }
+  }
+
+  /**< An edge ends, its neighbours become adjacent. */
+  void remove(SweepEvent *event) {
+    if (!event->inStatus)
+      return;
+    SweepEvent *prev = below(event->statusPos);
+    SweepEvent *next = above(event->statusPos);
+    status.erase(event->statusPos);
+    event->inStatus = false;
+    if (prev && next)
+      possible_intersection(prev, next);
+  }
+
+  /**< The result edge of an event is directed away from it, so that the
+   * result lies to its left. */
+  static bool is_start(const SweepEvent *event) {
+    const SweepEvent *edge = event->left ? event : event->other;
+    return event->left == (edge->resultTransition > 0);
+  }
+
+  SetOperation op;                  /**< The operation. */
+  std::deque<SweepEvent> events;    /**< Every event, stable addresses. */
+  std::priority_queue<SweepEvent *, std::vector<SweepEvent *>, LaterEvent>
+      queue;                           /**< Events not yet processed. */
+  Status status;                       /**< Edges on the sweep line. */
+  std::vector<SweepEvent *> processed; /**< Events in processing order. */
+  std::vector<SweepEvent *> resultEvents; /**< Endpoints of result edges. */
+};
+
+/**< Walks from the lowest left vertex of every unlinked ring. */
+void BooleanSweep::connect(std::vector<ResultRing> &rings) {
+  for (SweepEvent *event : processed) {
+    const SweepEvent *edge = event->left ? event : event->other;
+    if (edge->resultTransition != 0)
+      resultEvents.push_back(event);
+  }
+  /**< Pieces of overlapping edges may have been queued out of order. */
+  std::stable_sort(resultEvents.begin(), resultEvents.end(),
+                   [](const SweepEvent *a, const SweepEvent *b) {
+                     return processed_after(b, a);
+                   });
+  const size_t count = resultEvents.size();
+  for (size_t i = 0; i < count; ++i)
+    resultEvents[i]->position = i;
+
+  /**< The events of one point are adjacent, [runStart, runEnd). */
+  std::vector<size_t> runStart(count), runEnd(count);
+  for (size_t i = 0; i < count;) {
+    size_t j = i + 1;
+    while (j < count &&
+           same_point(resultEvents[j]->point, resultEvents[i]->point))
+      ++j;
+    for (size_t k = i; k < j; ++k) {
+      runStart[k] = i;
+      runEnd[k] = j;
+    }
+    i = j;
+  }
+
+  std::vector<bool> linked(count, false);
+  for (size_t origin = 0; origin < count; ++origin) {
+    if (linked[origin])
+      continue;
+
+    /**< Everything before is linked, so this point is the lowest left
+     * vertex of every ring through it. */
+    size_t start = no_position;
+    for (size_t k = runStart[origin]; k < runEnd[origin]; ++k) {
+      if (!linked[k] && is_start(resultEvents[k])) {
+        start = k;
+        break;
+      }
+    }
+    if (start == no_position) {
+      linked[origin] = true;
+      continue;
+    }
+
+    const int index = static_cast<int>(rings.size());
+    rings.emplace_back();
+    ResultRing &ring = rings.back();
+
+    size_t lowest = start; /**< Lowest edge of the ring at its vertex. */
+    size_t position = start;
+    while (true) {
+      SweepEvent *from = resultEvents[position];
+      linked[position] = true;
+      from->ring = index;
+      ring.points.push_back(from->point);
+      const size_t end = from->other->position;
+      if (end == no_position)
+        break;
+      linked[end] = true;
+      resultEvents[end]->ring = index;
+      if (runStart[end] == runStart[start])
+        lowest = std::min(lowest, end);
+
+      /**< Take the first edge clockwise from the one we came along, which
+       * keeps rings that touch at a vertex apart. */
+      const Point &vertex = resultEvents[end]->point;
+      size_t next = no_position;
+      for (size_t k = runStart[end]; k < runEnd[end]; ++k) {
+        if (!is_start(resultEvents[k]) || (linked[k] && k != start))
+          continue;
+        if (next == no_position ||
+            turns_before(vertex, from->point, resultEvents[k]->other->point,
+                         resultEvents[next]->other->point))
+          next = k;
+      }
+      if (next == no_position || next == start)
+        break;
+      position = next;
+    }
+
+    /**< The result lies below the lowest edge of a hole, the closest
+     * result edge below that belongs to its outer ring or to a sibling. */
+    const SweepEvent *edge = resultEvents[lowest];
+    if (!edge->left)
+      edge = edge->other;
+    const SweepEvent *lower = edge->prevInResult;
+    if (edge->resultTransition < 0 && lower && lower->ring >= 0 &&
+        lower->ring != index) {
+      const int parent = rings[lower->ring].holeOf;
+      ring.holeOf = (parent >= 0) ? parent : lower->ring;
+    }
+  }
+}
+
+/**< Vertex b lies on the segment a -> c, or repeats a. */
+bool is_redundant(const Point &a, const Point &b, const Point &c) {
+  if (same_point(a, b))
+    return true;
+  if (orient2d(a, b, c) != 0.0)
+    return false;
+  return (a < b && b < c) || (c < b && b < a);
+}
+
+/**< Drop repeated vertices and vertices inside a straight run. */
+void remove_redundant_vertices(std::vector<Point> &ring) {
+  bool removed = true;
+  while (removed && ring.size() >= 3) {
+    removed = false;
+    std::vector<Point> kept;
+    kept.reserve(ring.size());
+    for (size_t i = 0; i < ring.size(); ++i) {
+      const Point &prev = kept.empty() ? ring.back() : kept.back();
+      if (is_redundant(prev, ring[i], ring[(i + 1) % ring.size()])) {
+        removed = true;
+        continue;
+      }
+      kept.push_back(ring[i]);
+    }
+    ring.swap(kept);
+  }
+}
+
+/**< Twice the signed area, positive counter clockwise. */
+double twice_signed_area(const std::vector<Point> &ring) {
+  double sum = 0.0;
+  for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+    sum += (ring[j].x - ring[i].x) * (ring[j].y + ring[i].y);
+  return sum;
+}
+
+/**
+ * @brief Cut a ring that passes a vertex more than once into loops that do
+ * not. Linking keeps the parts of the result that touch at a vertex apart,
+ * so a hole touching its outer ring, or another hole, comes out as one ring
+ * through the vertex twice.
+ *
+ * @param ring The ring, the result lies to its left.
+ * @param loops Output, the loops in the order they close, each running the
+ * way it ran in the ring.
+ */
+void split_at_repeated_vertices(const std::vector<Point> &ring,
+                                std::vector<std::vector<Point>> &loops) {
+  loops.clear();
+  std::vector<Point> sorted(ring);
+  std::sort(sorted.begin(), sorted.end());
+  const bool repeats =
+      std::adjacent_find(sorted.begin(), sorted.end(),
+                         [](const Point &a, const Point &b) {
+                           return same_point(a, b);
+                         }) != sorted.end();
+  if (!repeats) {
+    loops.push_back(ring);
+    return;
+  }
+
+  /**< Walk the ring, closing a loop whenever the path comes back. */
+  std::vector<Point> path;
+  std::map<Point, size_t> onPath; /**< Index of each vertex of the path. */
+  for (const Point &vertex : ring) {
+    auto found = onPath.find(vertex);
+    if (found == onPath.end()) {
+      onPath.emplace(vertex, path.size());
+      path.push_back(vertex);
+      continue;
+    }
+    const size_t start = found->second;
+    for (size_t i = start + 1; i < path.size(); ++i)
+      onPath.erase(path[i]);
+    loops.emplace_back(path.begin() + start, path.end());
+    path.resize(start + 1);
+  }
+  loops.push_back(std::move(path));
+}
+} // namespace
+
+/**< Sweep, link, then orient and order the rings. */
+void boolean_operation(const std::vector<PolygonView> &subject,
+                       const std::vector<PolygonView> &clipping,
+                       SetOperation op, std::vector<ResultRing> &rings) {
+  rings.clear();
+
+  /**< Right of both regions nothing is left to intersect, right of the
+   * subject nothing is left to subtract from. */
+  double subjectMaxX = -HUGE_VAL, clippingMaxX = -HUGE_VAL;
+  for (const PolygonView &ring : subject)
+    if (ring.size() > 0)
+      subjectMaxX = std::max(subjectMaxX, ring.get_bounding_box().maxX);
+  for (const PolygonView &ring : clipping)
+    if (ring.size() > 0)
+      clippingMaxX = std::max(clippingMaxX, ring.get_bounding_box().maxX);
+  double stopX = HUGE_VAL;
+  if (op == SetOperation::Intersection)
+    stopX = std::min(subjectMaxX, clippingMaxX);
+  else if (op == SetOperation::Difference)
+    stopX = subjectMaxX;
+
+  BooleanSweep sweep(op);
+  sweep.add_region(subject, true);
+  sweep.add_region(clipping, false);
+  sweep.run(stopX);
+
+  std::vector<ResultRing> pinched;
+  sweep.connect(pinched);
+
+  /**< Split pinched rings, a loop that turns the other way than its ring
+   * is a hole of the ring's outer ring or, in a hole, a part of its own.
+   * Outer loops come first so every hole follows its outer ring. */
+  std::vector<ResultRing> linked;
+  std::vector<int> outerLoop(pinched.size(), -1);
+  std::vector<std::vector<Point>> loops;
+  for (size_t i = 0; i < pinched.size(); ++i) {
+    split_at_repeated_vertices(pinched[i].points, loops);
+    const bool isHole = pinched[i].holeOf >= 0;
+    double largest = 0.0;
+    for (std::vector<Point> &loop : loops) {
+      const double area = twice_signed_area(loop);
+      if (area <= 0.0)
+        continue;
+      if (!isHole && area > largest) {
+        largest = area;
+        outerLoop[i] = static_cast<int>(linked.size());
+      }
+      linked.push_back(ResultRing{std::move(loop), -1});
+    }
+    const int parent = isHole ? outerLoop[pinched[i].holeOf] : outerLoop[i];
+    for (std::vector<Point> &loop : loops) {
+      if (parent >= 0 && !loop.empty() && twice_signed_area(loop) < 0.0)
+        linked.push_back(ResultRing{std::move(loop), parent});
+    }
+  }
+
+  /**< Drop degenerate rings, orient the others. */
+  std::vector<bool> kept(linked.size(), false);
+  for (size_t i = 0; i < linked.size(); ++i) {
+    ResultRing &ring = linked[i];
+    if (ring.holeOf >= 0 && !kept[ring.holeOf])
+      continue;
+    remove_redundant_vertices(ring.points);
+    if (ring.points.size() < 3)
+      continue;
+    const double area = twice_signed_area(ring.points);
+    if (area == 0.0)
+      continue;
+    if ((area > 0.0) == (ring.holeOf >= 0))
+      std::reverse(ring.points.begin(), ring.points.end());
+    kept[i] = true;
+  }
+
+  /**< Every outer ring followed by its holes. */
+  std::vector<std::vector<size_t>> holes(linked.size());
+  for (size_t i = 0; i < linked.size(); ++i)
+    if (kept[i] && linked[i].holeOf >= 0)
+      holes[linked[i].holeOf].push_back(i);
+  for (size_t i = 0; i < linked.size(); ++i) {
+    if (!kept[i] || linked[i].holeOf >= 0)
+      continue;
+    const int outer = static_cast<int>(rings.size());
+    rings.push_back(ResultRing{std::move(linked[i].points), -1});
+    for (size_t hole : holes[i])
+      rings.push_back(ResultRing{std::move(linked[hole].points), outer});
+  }
+}
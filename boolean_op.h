@@ -0,0 +1,42 @@
+#ifndef BOOLEAN_OP_H
+#define BOOLEAN_OP_H
+
+#include "polygon.h"
+
+#include <vector>
+
+/**
+ * @brief One ring of the result of boolean_operation.
+ */
+struct ResultRing {
+  std::vector<Point> points; /**< Vertices, the last connects to the first. */
+  int holeOf = -1; /**< Index of the outer ring a hole lies in, -1 for outer
+                      rings. */
+};
+
+/**
+ * @brief Set operation on two regions with the sweep of Martinez, Rueda and
+ * Feito, "A simple algorithm for Boolean operations on polygons" (2013).
+ * Every edge is split where it crosses or overlaps another edge, each piece
+ * is kept or dropped by what lies below it on the sweep line and the kept
+ * pieces are linked into rings. Runs in O((n + m + k) log(n + m)) for n and
+ * m edges and k crossings, the orientation tests are exact (see
+ * predicates.h).
+ *
+ * A region is given as one or more closed rings under the even-odd rule, so
+ * a ring inside another one is a hole whatever its orientation. The rings
+ * may be concave and cross each other.
+ *
+ * @param subject Rings of the first region.
+ * @param clipping Rings of the second region.
+ * @param op Union, Intersection, Difference (subject - clipping) or Xor.
+ * @param rings Output, cleared and filled with the rings of the result.
+ * Outer rings run counter clockwise, holes clockwise and are listed after the
+ * outer ring they lie in. No ring passes a vertex twice, rings may touch
+ * each other at vertices. Collinear vertices are removed.
+ */
+void boolean_operation(const std::vector<PolygonView> &subject,
+                       const std::vector<PolygonView> &clipping,
+                       SetOperation op, std::vector<ResultRing> &rings);
+
+#endif // BOOLEAN_OP_H
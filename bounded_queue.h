@@ -0,0 +1,84 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/**
+ * @brief Blocking first in first out queue of limited capacity connecting
+ * two pipeline stages. A full queue stalls the producer, so a fast stage
+ * cannot run arbitrarily far ahead of a slow one.
+ */
+template <typename T> class BoundedQueue {
+public:
+  /**
+   * @brief Empty queue.
+   *
+   * @param limit Most items held at once, at least one.
+   */
+  explicit BoundedQueue(size_t limit) : capacity(limit > 0 ? limit : 1) {}
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  /**
+   * @brief Append an item, waiting while the queue is full.
+   *
+   * @param item The item.
+   *
+   * @return False if the queue was closed, the item is dropped then.
+   */
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+    if (closed)
+      return false;
+
+    items.push_back(std::move(item));
+    notEmpty.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest item, waiting while the queue is empty.
+   *
+   * @param item Output, the item.
+   *
+   * @return False once the queue is closed and drained.
+   */
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+    if (items.empty())
+      return false;
+
+    item = std::move(items.front());
+    items.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Refuse further items and wake every waiting thread. Items
+   * already queued can still be popped.
+   */
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    notEmpty.notify_all();
+    notFull.notify_all();
+  }
+
+private:
+  const size_t capacity;            /**< Most items held at once. */
+  std::mutex mutex;                 /**< Guards the members below. */
+  std::condition_variable notEmpty; /**< Signalled on push and close. */
+  std::condition_variable notFull;  /**< Signalled on pop and close. */
+  std::deque<T> items;              /**< Queued items, oldest first. */
+  bool closed = false;              /**< No more pushes accepted. */
+};
+
+#endif // BOUNDED_QUEUE_H
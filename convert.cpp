@@ -0,0 +1,59 @@
+#include "polygon.h"
+#include "polygon_binary.h"
+#include "polygon_io.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**< Converts between the csv text format and the binary container, the
+ * direction follows from the input file. */
+int main(int argc, char **argv) {
+  CoordinateType type = CoordinateType::Float64;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--f32") == 0)
+      type = CoordinateType::Float32;
+    else
+      files.emplace_back(argv[i]);
+  }
+
+  if (files.size() != 2) {
+    std::cerr << "usage: " << argv[0] << " [--f32] <input> <output>\n"
+              << "  csv input is written as binary, binary input as csv\n";
+    return 1;
+  }
+  const std::string &input = files[0];
+  const std::string &output = files[1];
+
+  if (is_polygon_binary(input)) {
+    PolygonFile file;
+    if (!file.open(input)) {
+      std::cerr << "Malformed binary polygon file: " << input << std::endl;
+      return 2;
+    }
+
+    std::vector<PolygonView> views;
+    views.reserve(file.size());
+    for (size_t i = 0; i < file.size(); ++i)
+      views.push_back(file[i]);
+    if (!write_polygons(output, views)) {
+      std::cerr << "Error opening file for writing: " << output << std::endl;
+      return 3;
+    }
+    return 0;
+  }
+
+  /**< Stored sorted, as Polygon keeps them, so loading skips the sort. */
+  std::vector<Polygon> polygons;
+  if (!Polygon::read_file(input, polygons))
+    return 2;
+
+  const std::vector<PolygonView> views(polygons.begin(), polygons.end());
+  if (!write_polygon_binary(output, views, type)) {
+    std::cerr << "Error opening file for writing: " << output << std::endl;
+    return 3;
+  }
+  return 0;
+}
@@ -0,0 +1,326 @@
+#include "convex.h"
+#include "predicates.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace { /**< Internal helper functions */
+
+/**
+ * @brief A ring read in counter clockwise order, backwards if its vertices
+ * run clockwise, the order Polygon keeps them in.
+ */
+struct CounterClockwise {
+  const Point *points; /**< First vertex. */
+  size_t n;            /**< Number of vertices. */
+  bool reversed;       /**< True if the ring runs clockwise. */
+
+  explicit CounterClockwise(const PolygonView &ring)
+      : points(ring.data()), n(ring.size()),
+        reversed(twice_signed_area(ring) < 0.0) {}
+
+  /**< Vertex i in counter clockwise order. */
+  const Point &operator[](size_t i) const {
+    return points[reversed ? n - 1 - i : i];
+  }
+
+  /**< Vertex before i, wrapping around. */
+  const Point &previous(size_t i) const { return (*this)[(i + n - 1) % n]; }
+
+  /**< Shoelace sum, positive for counter clockwise rings. */
+  static double twice_signed_area(const PolygonView &ring) {
+    double area = 0.0;
+    const size_t n = ring.size();
+    for (size_t i = 0; i < n; ++i) {
+      const Point &current = ring[i];
+      const Point &next = ring[(i + 1) % n];
+      area += current.x * next.y - next.x * current.y;
+    }
+    return area;
+  }
+};
+
+/**< Sign of an orientation, -1, 0 or 1. */
+inline int sign_of(double value) { return (value > 0.0) - (value < 0.0); }
+
+/**< True if a - b rounds to itself. */
+inline bool exact_difference(double a, double b) {
+  const double x = a - b;
+  const double bVirtual = a - x;
+  const double aVirtual = x + bVirtual;
+  return (a - aVirtual) + (bVirtual - b) == 0.0;
+}
+
+/**
+ * @brief Sign of the cross product of the directions of the edges a0 -> a1
+ * and b0 -> b1. Exact when the directions are, otherwise only trusted
+ * outside the rounding error of the differences.
+ *
+ * @return -1, 0 or 1, or 2 if the sign is unknown.
+ */
+int turn_of_edges(const Point &a0, const Point &a1, const Point &b0,
+                  const Point &b1) {
+  const Point u{a1.x - a0.x, a1.y - a0.y};
+  const Point v{b1.x - b0.x, b1.y - b0.y};
+  if (exact_difference(a1.x, a0.x) && exact_difference(a1.y, a0.y) &&
+      exact_difference(b1.x, b0.x) && exact_difference(b1.y, b0.y))
+    return sign_of(orient2d(u, v, Point()));
+
+  const double left = u.x * v.y;
+  const double right = u.y * v.x;
+  const double cross = left - right;
+  if (std::abs(cross) <= 8.0 * DBL_EPSILON * (std::abs(left) + std::abs(right)))
+    return 2;
+  return sign_of(cross);
+}
+
+/**< True if the boxes of two segments share a point. */
+inline bool segment_boxes_meet(const Point &a0, const Point &a1,
+                               const Point &b0, const Point &b1) {
+  return std::max(a0.x, a1.x) >= std::min(b0.x, b1.x) &&
+         std::max(b0.x, b1.x) >= std::min(a0.x, a1.x) &&
+         std::max(a0.y, a1.y) >= std::min(b0.y, b1.y) &&
+         std::max(b0.y, b1.y) >= std::min(a0.y, a1.y);
+}
+
+/**
+ * @brief Locate a point against a counter clockwise convex ring.
+ *
+ * @return 1 inside, 0 on the boundary, -1 outside.
+ */
+int locate_in_convex(const Point &point, const CounterClockwise &ring) {
+  int result = 1;
+  for (size_t i = 0; i < ring.n; ++i) {
+    const int side = sign_of(orient2d(ring.previous(i), ring[i], point));
+    if (side < 0)
+      return -1;
+    if (side == 0)
+      result = 0;
+  }
+  return result;
+}
+
+/**
+ * @brief Append the vertices of a counter clockwise convex ring in
+ * ascending Point order, by merging the chains below and above the line
+ * from its smallest to its largest vertex.
+ *
+ * @param ring The ring.
+ * @param sorted Output, the vertices are appended.
+ */
+void append_sorted(const CounterClockwise &ring,
+                   std::pmr::vector<Point> &sorted) {
+  size_t low = 0;
+  size_t high = 0;
+  for (size_t i = 1; i < ring.n; ++i) {
+    if (ring[i] < ring[low])
+      low = i;
+    if (ring[high] < ring[i])
+      high = i;
+  }
+
+  /**< The lower chain runs forwards from low to high, the upper one
+   * backwards, both without the shared end points. */
+  const size_t start = sorted.size();
+  for (size_t i = low; i != high; i = (i + 1) % ring.n)
+    sorted.push_back(ring[i]);
+  sorted.push_back(ring[high]);
+  const size_t middle = sorted.size();
+  for (size_t i = (low + ring.n - 1) % ring.n; i != high;
+       i = (i + ring.n - 1) % ring.n)
+    sorted.push_back(ring[i]);
+
+  if (std::is_sorted(sorted.begin() + middle, sorted.end()))
+    std::inplace_merge(sorted.begin() + start, sorted.begin() + middle,
+                       sorted.end());
+  else
+    std::sort(sorted.begin() + start, sorted.end()); /**< Never for valid. */
+}
+} // namespace
+
+/**< Same rules as Polygon::update_geometry applies to its points. */
+bool is_convex_ring(const PolygonView &ring) {
+  const size_t n = ring.size();
+  if (n < 3)
+    return false;
+
+  int turnSign = 0;     /**< Sign of the first non collinear turn. */
+  int xFlips = 0;       /**< Sign changes of the edge x direction. */
+  int previousXDir = 0; /**< Sign of the last non vertical edge dx. */
+  for (size_t i = 0; i < n; ++i) {
+    const Point &current = ring[i];
+    const Point &next = ring[(i + 1) % n];
+    const Point &after = ring[(i + 2) % n];
+
+    /**< Every turn must bend the same way ... */
+    const double turn = (next.x - current.x) * (after.y - next.y) -
+                        (next.y - current.y) * (after.x - next.x);
+    const int sign = sign_of(turn);
+    if (sign != 0) {
+      if (turnSign == 0)
+        turnSign = sign;
+      else if (sign != turnSign)
+        return false;
+    }
+
+    /**< ... and the boundary may only wind around once. */
+    const int xDir = sign_of(next.x - current.x);
+    if (xDir != 0) {
+      if (previousXDir != 0 && xDir != previousXDir)
+        xFlips++;
+      previousXDir = xDir;
+    }
+  }
+
+  /**< The wrap around from the last edge to the first counts as well. */
+  for (size_t i = 0; i < n; ++i) {
+    const int xDir = sign_of(ring[(i + 1) % n].x - ring[i].x);
+    if (xDir != 0) {
+      if (xDir != previousXDir)
+        xFlips++;
+      break;
+    }
+  }
+
+  return (turnSign != 0) && (xFlips <= 2);
+}
+
+/**< Walks both boundaries at once, see O'Rourke, "Computational Geometry
+ * in C" (1998), section 7.6. */
+bool convex_intersection(const PolygonView &A, const PolygonView &B,
+                         std::pmr::vector<Point> &result) {
+  result.clear();
+  const CounterClockwise P(A);
+  const CounterClockwise Q(B);
+  const size_t n = P.n;
+  const size_t m = Q.n;
+  if (n < 3 || m < 3)
+    return false;
+
+  enum class Inside { Unknown, P, Q } inside = Inside::Unknown;
+  size_t a = 0;      /**< Head of the current edge of P. */
+  size_t b = 0;      /**< Head of the current edge of Q. */
+  size_t aSteps = 0; /**< Advances on P since the first crossing. */
+  size_t bSteps = 0; /**< Advances on Q since the first crossing. */
+  bool crossed = false;
+  size_t firstA = 0; /**< Edges of the first crossing. */
+  size_t firstB = 0;
+
+  while ((aSteps < n || bSteps < m) && aSteps < 2 * n && bSteps < 2 * m) {
+    const Point &a0 = P.previous(a);
+    const Point &a1 = P[a];
+    const Point &b0 = Q.previous(b);
+    const Point &b1 = Q[b];
+
+    const double a0Side = orient2d(b0, b1, a0);
+    const double a1Side = orient2d(b0, b1, a1);
+    const double b0Side = orient2d(a0, a1, b0);
+    const double b1Side = orient2d(a0, a1, b1);
+    const int aHB = sign_of(a1Side); /**< Head of a against edge b. */
+    const int bHA = sign_of(b1Side); /**< Head of b against edge a. */
+
+    /**< A vertex on the other edge, or edges along one line. */
+    if ((a0Side == 0.0 || a1Side == 0.0 || b0Side == 0.0 || b1Side == 0.0) &&
+        segment_boxes_meet(a0, a1, b0, b1))
+      return false;
+
+    if (sign_of(a0Side) * aHB < 0 && sign_of(b0Side) * bHA < 0) {
+      if (crossed && a == firstA && b == firstB)
+        break; /**< Around the ring and back at the first crossing. */
+      if (!crossed) {
+        crossed = true;
+        firstA = a;
+        firstB = b;
+        aSteps = bSteps = 0;
+      }
+      const double t = a0Side / (a0Side - a1Side);
+      result.push_back({a0.x + t * (a1.x - a0.x), a0.y + t * (a1.y - a0.y)});
+      inside = (aHB > 0) ? Inside::P : Inside::Q;
+    }
+
+    const int turn = turn_of_edges(a0, a1, b0, b1);
+    if (turn == 2 || (turn == 0 && aHB == 0 && bHA == 0))
+      return false; /**< Nearly parallel, or on one line. */
+    if (turn == 0 && aHB < 0 && bHA < 0)
+      return true; /**< Parallel with the rings on either side, disjoint. */
+
+    /**< Advance the edge that points towards the other one, emitting its
+     * head when it lies inside the result. */
+    const bool advanceA = (turn >= 0) ? (bHA > 0) : (aHB <= 0);
+    if (advanceA) {
+      if (inside == Inside::P)
+        result.push_back(a1);
+      a = (a + 1) % n;
+      aSteps++;
+    } else {
+      if (inside == Inside::Q)
+        result.push_back(b1);
+      b = (b + 1) % m;
+      bSteps++;
+    }
+  }
+
+  if (!crossed) {
+    /**< No crossing, one ring contains the other or they are apart. */
+    const int pInQ = locate_in_convex(P[0], Q);
+    if (pInQ == 0)
+      return false;
+    if (pInQ > 0) {
+      for (size_t i = 0; i < n; ++i)
+        result.push_back(P[i]);
+      return true;
+    }
+    const int qInP = locate_in_convex(Q[0], P);
+    if (qInP == 0)
+      return false;
+    if (qInP > 0)
+      for (size_t i = 0; i < m; ++i)
+        result.push_back(Q[i]);
+    return true;
+  }
+
+  /**< The walk may pass the first crossing again before it stops. */
+  result.erase(std::unique(result.begin(), result.end(),
+                           [](const Point &p, const Point &q) {
+                             return p.x == q.x && p.y == q.y;
+                           }),
+               result.end());
+  while (result.size() > 1 && result.front().x == result.back().x &&
+         result.front().y == result.back().y)
+    result.pop_back();
+
+  /**< Crossing edges in general position always enclose some area. */
+  return result.size() >= 3;
+}
+
+/**< Andrew's monotone chain over the merged vertices. */
+void convex_hull_merge(const PolygonView &A, const PolygonView &B,
+                       std::pmr::vector<Point> &hull) {
+  std::pmr::vector<Point> sorted(hull.get_allocator());
+  sorted.reserve(A.size() + B.size());
+  append_sorted(CounterClockwise(A), sorted);
+  const size_t middle = sorted.size();
+  append_sorted(CounterClockwise(B), sorted);
+  std::inplace_merge(sorted.begin(), sorted.begin() + middle, sorted.end());
+
+  hull.clear();
+  hull.resize(2 * sorted.size());
+  size_t k = 0;
+  for (size_t i = 0; i < sorted.size(); ++i) { /**< Lower hull. */
+    while (k >= 2 && orient2d(hull[k - 2], hull[k - 1], sorted[i]) <= 0.0)
+      k--;
+    hull[k++] = sorted[i];
+  }
+  for (size_t i = sorted.size() - 1, lower = k + 1; i-- > 0;) { /**< Upper. */
+    while (k >= lower && orient2d(hull[k - 2], hull[k - 1], sorted[i]) <= 0.0)
+      k--;
+    hull[k++] = sorted[i];
+  }
+  hull.resize(k - 1); /**< The last point repeats the first. */
+}
+
+/**< Shoelace formula. */
+double ring_area(const PolygonView &ring) {
+  return std::abs(CounterClockwise::twice_signed_area(ring)) / 2.0;
+}
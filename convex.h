@@ -0,0 +1,65 @@
+#ifndef CONVEX_H
+#define CONVEX_H
+
+#include "polygon.h"
+
+#include <memory_resource>
+#include <vector>
+
+/**
+ * @brief Check if a ring is convex, with the rules of Polygon::is_convex:
+ * every turn bends the same way or not at all and the boundary winds around
+ * once, so collinear vertices are allowed and self intersecting rings are
+ * not. Runs in O(n).
+ *
+ * @param ring Vertices of the ring, the last connects to the first.
+ *
+ * @return True if the ring is convex.
+ */
+bool is_convex_ring(const PolygonView &ring);
+
+/**
+ * @brief Intersection of two convex rings with the edge chasing algorithm of
+ * O'Rourke, Chien, Olson and Naddor, "A new linear algorithm for intersecting
+ * convex polygons" (1982). The boundaries are walked together, always
+ * advancing the edge that points towards the other one, so the work is
+ * O(n + m). Either orientation is accepted.
+ *
+ * Only crossings in general position are handled. When edges touch at a
+ * vertex, run along each other or are too close to parallel for the floating
+ * point turn test, nothing is decided and the caller has to take the general
+ * path.
+ *
+ * @param A The first ring, convex.
+ * @param B The second ring, convex.
+ * @param result Output, cleared and filled with the counter clockwise ring
+ * of the intersection, empty if the rings are disjoint.
+ *
+ * @return False if the configuration is degenerate and result is unusable.
+ */
+bool convex_intersection(const PolygonView &A, const PolygonView &B,
+                         std::pmr::vector<Point> &result);
+
+/**
+ * @brief Convex hull of two convex rings in O(n + m). Each ring splits at
+ * its lowest and highest vertex into two chains that are already sorted, the
+ * four chains are merged and closed with Andrew's monotone chain.
+ *
+ * @param A The first ring, convex.
+ * @param B The second ring, convex.
+ * @param hull Output, cleared and filled with the counter clockwise hull,
+ * collinear vertices removed. Temporaries come from its memory resource.
+ */
+void convex_hull_merge(const PolygonView &A, const PolygonView &B,
+                       std::pmr::vector<Point> &hull);
+
+/**
+ * @brief Area enclosed by a ring, whatever its orientation.
+ *
+ * @param ring Vertices of the ring.
+ *
+ * @return The unsigned area.
+ */
+double ring_area(const PolygonView &ring);
+
+#endif // CONVEX_H
@@ -0,0 +1,246 @@
+#include "edit_index.h"
+#include "external.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace { /**< Internal helper functions */
+
+/**< Edges reaching into more cells are kept in a list of their own. */
+const int64_t max_edge_cells = 64;
+
+/**< Cell coordinate of a coordinate, clamped so far away points share the
+ * outermost cells instead of overflowing. */
+int64_t cell_of(double coordinate) {
+  const double cell = std::floor(coordinate);
+  if (!(cell > -1e15))
+    return -1000000000000000;
+  if (cell > 1e15)
+    return 1000000000000000;
+  return static_cast<int64_t>(cell);
+}
+
+/**< Hash key of a cell, distant cells may share one. */
+inline uint64_t cell_key(int64_t x, int64_t y) {
+  return (static_cast<uint64_t>(x) << 32) ^ static_cast<uint32_t>(y);
+}
+
+/**< Twice the signed area of the triangle of the origin and the edge. */
+inline double shoelace(const Point &start, const Point &end) {
+  return start.x * end.y - end.x * start.y;
+}
+} // namespace
+
+/**< Cells as wide as the average edge, every edge counted against the ones
+ * before it. */
+EditIndex::EditIndex(const std::vector<Point> &ring) {
+  const size_t n = ring.size();
+  double extent = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    const Point &start = ring[i];
+    const Point &end = ring[(i + 1) % n];
+    extent += std::max(std::abs(end.x - start.x), std::abs(end.y - start.y));
+  }
+  const double cellSize = extent / static_cast<double>(n);
+  if (cellSize > 0.0 && std::isfinite(cellSize))
+    inverseCellSize = 1.0 / cellSize;
+
+  vertexIds.resize(n);
+  edges.resize(n);
+  seen.assign(n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    vertexIds[i] = static_cast<uint32_t>(i);
+    xs.insert(ring[i].x);
+    ys.insert(ring[i].y);
+  }
+  for (size_t i = 0; i < n; ++i)
+    add_edge(static_cast<uint32_t>(i), ring[i],
+             static_cast<uint32_t>((i + 1) % n), ring[(i + 1) % n]);
+}
+
+/**< The edge into the slot is split in two. */
+void EditIndex::insert(const std::vector<Point> &ring, size_t index) {
+  const size_t n = ring.size();
+  const size_t previous = (index + n - 1) % n;
+  const uint32_t previousId = vertexIds[(index + n - 2) % (n - 1)];
+  const uint32_t nextId = vertexIds[index % (n - 1)];
+  const uint32_t id = take_id();
+
+  remove_edge(previousId);
+  vertexIds.insert(vertexIds.begin() + index, id);
+  add_edge(previousId, ring[previous], id, ring[index]);
+  add_edge(id, ring[index], nextId, ring[(index + 1) % n]);
+  xs.insert(ring[index].x);
+  ys.insert(ring[index].y);
+}
+
+/**< Both edges at the vertex are replaced, its number stays. */
+void EditIndex::move(const std::vector<Point> &ring, size_t index,
+                     const Point &from) {
+  const size_t n = ring.size();
+  const size_t previous = (index + n - 1) % n;
+  const size_t next = (index + 1) % n;
+  const uint32_t id = vertexIds[index];
+
+  remove_edge(vertexIds[previous]);
+  remove_edge(id);
+  add_edge(vertexIds[previous], ring[previous], id, ring[index]);
+  add_edge(id, ring[index], vertexIds[next], ring[next]);
+  xs.erase(xs.find(from.x));
+  ys.erase(ys.find(from.y));
+  xs.insert(ring[index].x);
+  ys.insert(ring[index].y);
+}
+
+/**< Both edges at the vertex become one. */
+void EditIndex::remove(const std::vector<Point> &ring, size_t index,
+                       const Point &removed) {
+  const size_t n = ring.size();
+  const uint32_t id = vertexIds[index];
+  const uint32_t previousId = vertexIds[(index + n) % (n + 1)];
+  const uint32_t nextId = vertexIds[(index + 1) % (n + 1)];
+
+  remove_edge(previousId);
+  remove_edge(id);
+  vertexIds.erase(vertexIds.begin() + index);
+  freeIds.push_back(id);
+  add_edge(previousId, ring[(index + n - 1) % n], nextId, ring[index % n]);
+  xs.erase(xs.find(removed.x));
+  ys.erase(ys.find(removed.y));
+}
+
+/**< Smallest and largest coordinates. */
+BoundingBox EditIndex::get_bounding_box() const {
+  BoundingBox box;
+  box.minX = *xs.begin();
+  box.maxX = *xs.rbegin();
+  box.minY = *ys.begin();
+  box.maxY = *ys.rbegin();
+  return box;
+}
+
+/**< Numbers of removed vertices are used again. */
+uint32_t EditIndex::take_id() {
+  if (!freeIds.empty()) {
+    const uint32_t id = freeIds.back();
+    freeIds.pop_back();
+    return id;
+  }
+  edges.emplace_back();
+  seen.push_back(0);
+  return static_cast<uint32_t>(edges.size() - 1);
+}
+
+/**< Counted before it is filed, so it does not meet itself. */
+void EditIndex::add_edge(uint32_t id, const Point &start, uint32_t endVertex,
+                         const Point &end) {
+  Edge &edge = edges[id];
+  edge.start = start;
+  edge.end = end;
+  edge.endVertex = endVertex;
+  crossings += count_crossings(id);
+  twiceArea += shoelace(start, end);
+
+  if (!for_each_cell(edge, [this, id](uint64_t key) {
+        cells[key].push_back(id);
+      }))
+    longEdges.push_back(id);
+  edge.filed = true;
+}
+
+/**< Taken out of its cells before its crossings are counted. */
+void EditIndex::remove_edge(uint32_t id) {
+  Edge &edge = edges[id];
+  edge.filed = false;
+  auto take_out = [id](std::vector<uint32_t> &list) {
+    auto it = std::find(list.begin(), list.end(), id);
+    *it = list.back();
+    list.pop_back();
+  };
+
+  if (!for_each_cell(edge, [this, &take_out](uint64_t key) {
+        auto cell = cells.find(key);
+        take_out(cell->second);
+        if (cell->second.empty())
+          cells.erase(cell);
+      }))
+    take_out(longEdges);
+
+  crossings -= count_crossings(id);
+  twiceArea -= shoelace(edge.start, edge.end);
+}
+
+/**< Edges sharing a cell with it, or all of them for a long edge. */
+uint64_t EditIndex::count_crossings(uint32_t id) {
+  if (++stamp == 0) { /**< Wrapped around, forget the old stamps. */
+    std::fill(seen.begin(), seen.end(), 0);
+    stamp = 1;
+  }
+  seen[id] = stamp;
+
+  const Edge &edge = edges[id];
+  BoundingBox box;
+  box.minX = std::min(edge.start.x, edge.end.x);
+  box.maxX = std::max(edge.start.x, edge.end.x);
+  box.minY = std::min(edge.start.y, edge.end.y);
+  box.maxY = std::max(edge.start.y, edge.end.y);
+
+  uint64_t count = 0;
+  auto test = [this, &edge, &box, id, &count](uint32_t other) {
+    if (seen[other] == stamp)
+      return;
+    seen[other] = stamp;
+
+    /**< Edges at the same vertex never count, as in has_self_intersection. */
+    const Edge &candidate = edges[other];
+    if (!candidate.filed || edge.endVertex == other ||
+        candidate.endVertex == id)
+      return;
+    if (std::max(candidate.start.x, candidate.end.x) < box.minX ||
+        std::min(candidate.start.x, candidate.end.x) > box.maxX ||
+        std::max(candidate.start.y, candidate.end.y) < box.minY ||
+        std::min(candidate.start.y, candidate.end.y) > box.maxY)
+      return;
+    /**< Always in the same order, so a pair is found alike when its second
+     * edge is added and when its first edge is removed. */
+    const Edge &first = (id < other) ? edge : candidate;
+    const Edge &second = (id < other) ? candidate : edge;
+    Point intersection;
+    if (do_lines_intersect(first.start, first.end, second.start, second.end,
+                           intersection))
+      count++;
+  };
+
+  if (for_each_cell(edge, [this, &test](uint64_t key) {
+        auto cell = cells.find(key);
+        if (cell != cells.end())
+          for (uint32_t other : cell->second)
+            test(other);
+      })) {
+    for (uint32_t other : longEdges)
+      test(other);
+  } else {
+    /**< Every other edge of the ring starts at one of its vertices. */
+    for (uint32_t other : vertexIds)
+      test(other);
+  }
+  return count;
+}
+
+/**< Cells of the box of the edge. */
+template <typename Visit>
+bool EditIndex::for_each_cell(const Edge &edge, Visit visit) {
+  const double scale = inverseCellSize;
+  const int64_t minX = cell_of(std::min(edge.start.x, edge.end.x) * scale);
+  const int64_t maxX = cell_of(std::max(edge.start.x, edge.end.x) * scale);
+  const int64_t minY = cell_of(std::min(edge.start.y, edge.end.y) * scale);
+  const int64_t maxY = cell_of(std::max(edge.start.y, edge.end.y) * scale);
+  if (maxX - minX >= max_edge_cells || maxY - minY >= max_edge_cells ||
+      (maxX - minX + 1) * (maxY - minY + 1) > max_edge_cells)
+    return false;
+
+  for (int64_t x = minX; x <= maxX; ++x)
+    for (int64_t y = minY; y <= maxY; ++y)
+      visit(cell_key(x, y));
+  return true;
+}
@@ -0,0 +1,154 @@
+#ifndef EDIT_INDEX_H
+#define EDIT_INDEX_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief What Polygon keeps up to date while its vertices are edited one at
+ * a time, see Polygon::insert_vertex. The edges are hashed into square cells
+ * about as wide as an average edge, so the edges near an edit are found
+ * without looking at the others. The index counts the pairs of non adjacent
+ * edges that intersect, the ring is simple while there are none, and keeps
+ * the coordinates sorted and the shoelace sum for the bounds and the area.
+ *
+ * Edges are named after the vertex they start at. Vertices get a number when
+ * they are added that stays with them while others come and go, so an edit
+ * only touches the two or three edges at its vertex.
+ */
+class EditIndex {
+public:
+  /**
+   * @brief Index a ring and count its intersecting edge pairs.
+   *
+   * @param ring Vertices of the ring, at least three.
+   */
+  explicit EditIndex(const std::vector<Point> &ring);
+
+  /**
+   * @brief Follow the insertion of a vertex, ring already holds it.
+   *
+   * @param ring Vertices after the edit.
+   * @param index Position of the new vertex.
+   */
+  void insert(const std::vector<Point> &ring, size_t index);
+
+  /**
+   * @brief Follow the move of a vertex, ring already holds the new position.
+   *
+   * @param ring Vertices after the edit.
+   * @param index Position of the moved vertex.
+   * @param from Where the vertex was before.
+   */
+  void move(const std::vector<Point> &ring, size_t index, const Point &from);
+
+  /**
+   * @brief Follow the removal of a vertex, ring no longer holds it.
+   *
+   * @param ring Vertices after the edit, at least three.
+   * @param index Position the vertex had.
+   * @param removed The removed vertex.
+   */
+  void remove(const std::vector<Point> &ring, size_t index,
+              const Point &removed);
+
+  /**
+   * @brief Check the ring for self intersections, same result as
+   * has_self_intersection.
+   *
+   * @return True if no two non adjacent edges intersect.
+   */
+  bool is_simple() const { return crossings == 0; }
+
+  /**
+   * @brief Bounds of the vertices.
+   *
+   * @return The bounding box.
+   */
+  BoundingBox get_bounding_box() const;
+
+  /**
+   * @brief Signed area from the shoelace sum kept per edge.
+   *
+   * @return Area, positive if the points run counter clockwise.
+   */
+  double get_signed_area() const { return twiceArea / 2.0; }
+
+private:
+  /**
+   * @brief An edge as it was added, never changed afterwards.
+   */
+  struct Edge {
+    Point start;            /**< First vertex. */
+    Point end;              /**< Second vertex. */
+    uint32_t endVertex = 0; /**< Number of the second vertex. */
+    bool filed = false;     /**< True while the edge is in the index. */
+  };
+
+  std::vector<uint32_t> vertexIds; /**< Number of each vertex, ring order. */
+  std::vector<uint32_t> freeIds;   /**< Numbers of removed vertices. */
+  std::vector<Edge> edges;         /**< Edge starting at each number. */
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells; /**< Edges per
+                                                                cell. */
+  std::vector<uint32_t> longEdges; /**< Edges over too many cells, checked
+                                      against everything. */
+  std::vector<uint32_t> seen;      /**< Query stamp of each edge. */
+  uint32_t stamp = 0;              /**< Stamp of the current query. */
+  double inverseCellSize = 1.0;    /**< Cells per unit of length. */
+  uint64_t crossings = 0;          /**< Intersecting non adjacent pairs. */
+  double twiceArea = 0.0;          /**< Shoelace sum of the edges. */
+  std::multiset<double> xs;        /**< x-coordinates of the vertices. */
+  std::multiset<double> ys;        /**< y-coordinates of the vertices. */
+
+  /**
+   * @brief Give a new vertex a number.
+   *
+   * @return The number.
+   */
+  uint32_t take_id();
+
+  /**
+   * @brief Add the edge starting at a vertex and count what it crosses.
+   *
+   * @param id Number of the first vertex.
+   * @param start First vertex.
+   * @param endVertex Number of the second vertex.
+   * @param end Second vertex.
+   */
+  void add_edge(uint32_t id, const Point &start, uint32_t endVertex,
+                const Point &end);
+
+  /**
+   * @brief Remove the edge starting at a vertex, with what it crosses.
+   *
+   * @param id Number of the first vertex.
+   */
+  void remove_edge(uint32_t id);
+
+  /**
+   * @brief Count the edges in the index that intersect an edge without
+   * sharing a vertex with it.
+   *
+   * @param id Number of the edge, it may be in the index itself.
+   *
+   * @return The count.
+   */
+  uint64_t count_crossings(uint32_t id);
+
+  /**
+   * @brief Visit the cells an edge reaches into.
+   *
+   * @param edge The edge.
+   * @param visit Called with the key of every cell.
+   *
+   * @return False, visiting nothing, if the edge covers too many cells.
+   */
+  template <typename Visit> bool for_each_cell(const Edge &edge, Visit visit);
+};
+
+#endif // EDIT_INDEX_H
@@ -1,6 +1,14 @@
+#ifndef EXTERNAL_H
+#define EXTERNAL_H
+
+#include "instrumentation.h"
+#include "predicates.h"
+
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 /**< place to dump code snippets adapted from the web. */
 
@@ -20,8 +28,8 @@ const double epsilon = 1e-10; /**< Minimum error. */
  *
  * @return: True if point lies within range.
  */
-bool point_on_line_segment(const Point &point, const Point &start,
-                           const Point &end) {
+inline bool point_on_line_segment(const Point &point, const Point &start,
+                                  const Point &end) {
   return (point.x >= std::min(start.x, end.x) - epsilon &&
           point.x <= std::max(start.x, end.x) + epsilon &&
           point.y >= std::min(start.y, end.y) - epsilon &&
@@ -32,6 +40,8 @@ bool point_on_line_segment(const Point &point, const Point &start,
  * @brief Checks if the lines formed by p1->p2 and p3->p4 intersect. Function
  * logic is adapted from
  * https://paulbourke.net/geometry/pointlineplane/Helpers.cs
+ * The decision uses the exact orientation signs of predicates.h, only the
+ * intersection point itself is rounded.
  *
  * @param p1: Line A start point.
  * @param p2: Line A end point.
@@ -41,41 +51,57 @@ bool point_on_line_segment(const Point &point, const Point &start,
  *
  * @return: True if lines intersect, false otherwise.
  */
-bool do_lines_intersect(const Point &p1, const Point &p2, const Point &p3,
-                        const Point &p4, Point &ptIntersection) {
+inline bool do_lines_intersect(const Point &p1, const Point &p2,
+                               const Point &p3, const Point &p4,
+                               Point &ptIntersection) {
+  POLYGON_COUNT(segmentTests, 1);
+
   /**< Denominator for ua and ub are the same, so store this calculation */
-  double denom = (p4.y - p3.y) * (p2.x - p1.x) - (p4.x - p3.x) * (p2.y - p1.y);
+  const double denomLeft = (p4.y - p3.y) * (p2.x - p1.x);
+  const double denomRight = (p4.x - p3.x) * (p2.y - p1.y);
+  const double denom = denomLeft - denomRight;
 
   /**< normalA and normalB are calculated as separate values for readability */
-  double normalA =
-      (p4.x - p3.x) * (p1.y - p3.y) - (p4.y - p3.y) * (p1.x - p3.x);
-
-  double normalB =
-      (p2.x - p1.x) * (p1.y - p3.y) - (p2.y - p1.y) * (p1.x - p3.x);
-
-  /**< Make sure there is not a division by zero - this also indicates that
-   * the lines are parallel.
-   * If normalA and normalB were both equal to zero, the lines would be on top
-   * of each other (coincidental).  This check is not done because it is not
-   * necessary for this implementation (the parallel check accounts for this).*/
-  if (denom == 0)
-    return false;
-
-  /**< Calculate the intermediate fractional point that the lines potentially
-   * intersect. */
-  double fractA = normalA / denom;
-  double fractB = normalB / denom;
-
-  /**< The fractional point will be between 0 and 1 inclusive if the lines
-   * intersect.  If the fractional calculation is larger than 1 or smaller
-   * than 0, the lines would need to be longer to intersect.*/
-  if (fractA >= 0.0 && fractA <= 1.0 && fractB >= 0.0 && fractB <= 1.0) {
-    ptIntersection.x = p1.x + (fractA * (p2.x - p1.x));
-    ptIntersection.y = p1.y + (fractA * (p2.y - p1.y));
-    return true;
+  const double normalALeft = (p4.x - p3.x) * (p1.y - p3.y);
+  const double normalARight = (p4.y - p3.y) * (p1.x - p3.x);
+  const double normalA = normalALeft - normalARight;
+
+  const double normalBLeft = (p2.x - p1.x) * (p1.y - p3.y);
+  const double normalBRight = (p2.y - p1.y) * (p1.x - p3.x);
+  const double normalB = normalBLeft - normalBRight;
+
+  /**< Each determinant has a rounding error below the filter bound of
+   * predicates.h times the sum of its products. The answer depends on the
+   * signs of normalA, normalB, denom - normalA and denom - normalB, when all
+   * four clear their bounds the textbook test below is exact. */
+  const double errorD =
+      orient2d_filter_bound * (std::abs(denomLeft) + std::abs(denomRight));
+  const double errorA = orient2d_filter_bound *
+                        (std::abs(normalALeft) + std::abs(normalARight));
+  const double errorB = orient2d_filter_bound *
+                        (std::abs(normalBLeft) + std::abs(normalBRight));
+  double fractA;
+  if (!((std::abs(normalA) > errorA) & (std::abs(normalB) > errorB) &
+        (std::abs(denom - normalA) > 2.0 * (errorD + errorA)) &
+        (std::abs(denom - normalB) > 2.0 * (errorD + errorB)))) {
+    /**< Rare, near a vertex or nearly parallel. */
+    if (!segments_meet_exact(p1, p2, p3, p4, fractA))
+      return false;
+  } else {
+    /**< Calculate the intermediate fractional point that the lines
+     * potentially intersect. The fractional point will be between 0 and 1
+     * inclusive if the lines intersect. Parallel lines have a zero denom and
+     * never get here. */
+    fractA = normalA / denom;
+    const double fractB = normalB / denom;
+    if (!(fractA >= 0.0 && fractA <= 1.0 && fractB >= 0.0 && fractB <= 1.0))
+      return false;
   }
 
-  return false;
+  ptIntersection.x = p1.x + (fractA * (p2.x - p1.x));
+  ptIntersection.y = p1.y + (fractA * (p2.y - p1.y));
+  POLYGON_COUNT(segmentHits, 1);
+  return true;
 }
 
 /**
@@ -83,6 +109,7 @@ bool do_lines_intersect(const Point &p1, const Point &p2, const Point &p3,
  * or right side of the line formed by pt1 and pt2 when viewed in anticlockwise
  * direction. Taken from
  * https://github.com/anirudhtopiwala/OpenSource_Problems/blob/2fd0f600cdded7b86c7c4d6609884b7da1abda36/Point_In_Polygon/src/point_in_polygon.cpp
+ * The sign is exact, see predicates.h.
  *
  * @param pt1: First point to form equation of line.
  * @param pt2: Second point to form equation of line.
@@ -94,8 +121,9 @@ bool do_lines_intersect(const Point &p1, const Point &p2, const Point &p3,
  */
 double inline substitute_point_in_line(const Point &pt1, const Point &pt2,
                                        const Point &queryPoint) {
-  return ((queryPoint.y - pt1.y) * (pt2.x - pt1.x)) -
-         ((queryPoint.x - pt1.x) * (pt2.y - pt1.y));
+  /**< Rotated arguments, the fast path computes the same products as
+   * (q.y - pt1.y) * (pt2.x - pt1.x) - (q.x - pt1.x) * (pt2.y - pt1.y). */
+  return orient2d(pt2, queryPoint, pt1);
 }
 
 /**
@@ -110,10 +138,11 @@ double inline substitute_point_in_line(const Point &pt1, const Point &pt2,
  *          = 0: queryPpoint lies on the polygon.
  *          =-1: queryPpoint lies outside the polygon.
  */
-int is_point_inside_polygon(const Point &queryPpoint,
-                            std::vector<Point> &vertices) {
+inline int is_point_inside_polygon(const Point &queryPpoint,
+                                   const std::vector<Point> &vertices) {
   int windingNumber = 0; /**< the winding number counter */
   const int num_sides_of_polygon = vertices.size();
+  POLYGON_COUNT(pointInPolygonCalls, 1);
 
   for (size_t i = 0; i < num_sides_of_polygon; ++i) {
     const auto point_in_line = substitute_point_in_line(
@@ -124,7 +153,13 @@ int is_point_inside_polygon(const Point &queryPpoint,
       /**< Check collinear points iff they are within line bounds */
       bool onSegment = point_on_line_segment(
           queryPpoint, vertices[i], vertices[(i + 1) % num_sides_of_polygon]);
-      return onSegment ? 0 : -1;
+      if (onSegment) {
+        POLYGON_COUNT(edgesVisited, i + 1);
+        return 0;
+      }
+
+      /**< On the extension of the edge, which cannot cross the ray. */
+      continue;
     }
 
     if (vertices[i].y <= queryPpoint.y) {
@@ -136,14 +171,17 @@ int is_point_inside_polygon(const Point &queryPpoint,
       }
     } else {
       /**< Downward crossing. */
-      if (vertices[(i + 1) % num_sides_of_polygon].y < queryPpoint.y) {
+      if (vertices[(i + 1) % num_sides_of_polygon].y <= queryPpoint.y) {
         if (point_in_line < -epsilon) {
           --windingNumber; /**< query point is right of edge */
         }
       }
     }
   }
+  POLYGON_COUNT(edgesVisited, num_sides_of_polygon);
   return (windingNumber != 0)
              ? 1
              : -1; /**< Point is inside polygon only if windingNumber != 0 */
 }
+
+#endif // EXTERNAL_H
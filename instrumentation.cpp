@@ -0,0 +1,214 @@
+#include "instrumentation.h"
+#include "polygon.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> statsEnabled(false);
+std::atomic<bool> traceEnabled(false);
+
+namespace { /**< Internal helper functions */
+
+/**< One finished span. */
+struct TraceEvent {
+  const char *name;  /**< Event name. */
+  uint64_t start;    /**< Start in nanoseconds. */
+  uint64_t duration; /**< Length in nanoseconds. */
+};
+
+/**< Counters and spans of one thread. Blocks are never freed, a block whose
+ * thread ended is handed to the next new thread, so there are never more
+ * blocks than threads alive at once. */
+struct ThreadBlock {
+  ThreadCounters counters;        /**< Written by the owning thread only. */
+  std::mutex eventsMutex;         /**< Guards events. */
+  std::vector<TraceEvent> events; /**< Spans not yet written. */
+  bool inUse = false;             /**< Owned by a running thread. */
+};
+
+std::mutex registryMutex;                         /**< Guards blocks. */
+std::vector<std::unique_ptr<ThreadBlock>> blocks; /**< All blocks so far. */
+
+std::atomic<uint64_t> allocations(0);    /**< count_allocation calls. */
+std::atomic<uint64_t> allocatedBytes(0); /**< Bytes they asked for. */
+
+/**< Take a free block or make a new one. */
+ThreadBlock *acquire_block() {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (const auto &block : blocks) {
+    if (!block->inUse) {
+      block->inUse = true;
+      return block.get();
+    }
+  }
+  blocks.emplace_back(new ThreadBlock());
+  blocks.back()->counters.thread = blocks.size() - 1;
+  blocks.back()->inUse = true;
+  return blocks.back().get();
+}
+
+/**< Hands the block back when its thread ends. */
+struct BlockOwner {
+  ThreadBlock *block = nullptr;
+  ~BlockOwner() {
+    if (block) {
+      std::lock_guard<std::mutex> lock(registryMutex);
+      block->inUse = false;
+    }
+  }
+};
+
+thread_local BlockOwner owner; /**< Block of the calling thread. */
+
+ThreadBlock &thread_block() {
+  if (!owner.block)
+    owner.block = acquire_block();
+  return *owner.block;
+}
+
+/**< Read a counter of another thread. */
+uint64_t load(const std::atomic<uint64_t> &counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+/**< Append a JSON string, escaping quotes and backslashes. */
+void append_string(std::string &json, const char *text) {
+  json.push_back('"');
+  for (; *text; ++text) {
+    if (*text == '"' || *text == '\\')
+      json.push_back('\\');
+    json.push_back(*text);
+  }
+  json.push_back('"');
+}
+} // namespace
+
+/**< Registered on first use. */
+ThreadCounters &thread_counters() { return thread_block().counters; }
+
+uint64_t instrumentation_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+TraceSpan::TraceSpan(const char *name,
+                     std::atomic<uint64_t> ThreadCounters::*timer,
+                     std::atomic<uint64_t> ThreadCounters::*calls)
+    : name(name), timer(timer), calls(calls) {
+  tracing = traceEnabled.load(std::memory_order_relaxed);
+  timing = (timer || calls) && statsEnabled.load(std::memory_order_relaxed);
+  if (tracing || timing)
+    start = instrumentation_now();
+}
+
+TraceSpan::~TraceSpan() {
+  if (!tracing && !timing)
+    return;
+
+  const uint64_t duration = instrumentation_now() - start;
+  ThreadBlock &block = thread_block();
+  if (timing) {
+    if (timer)
+      add_count(block.counters.*timer, duration);
+    if (calls)
+      add_count(block.counters.*calls, 1);
+  }
+  if (tracing) {
+    std::lock_guard<std::mutex> lock(block.eventsMutex);
+    block.events.push_back(TraceEvent{name, start, duration});
+  }
+}
+
+/**< Complete events ("ph": "X") with microsecond times. */
+bool write_trace_events(const std::string &filename) {
+  std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool first = true;
+  char number[96];
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (const auto &block : blocks) {
+    std::vector<TraceEvent> events;
+    {
+      std::lock_guard<std::mutex> eventsLock(block->eventsMutex);
+      events.swap(block->events);
+    }
+    for (const TraceEvent &event : events) {
+      json += first ? "\n" : ",\n";
+      first = false;
+      json += "{\"name\": ";
+      append_string(json, event.name);
+      std::snprintf(number, sizeof(number),
+                    ", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, "
+                    "\"dur\": %.3f}",
+                    block->counters.thread, event.start / 1e3,
+                    event.duration / 1e3);
+      json += number;
+    }
+  }
+  json += "\n]}\n";
+
+  std::ofstream outputFile(filename, std::ios::binary);
+  if (!outputFile.is_open())
+    return false;
+  outputFile.write(json.data(), json.size());
+  return static_cast<bool>(outputFile);
+}
+
+/**< Sum of every thread block and the allocation totals. */
+void add_thread_counters(OperationStats &stats) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (const auto &block : blocks) {
+    const ThreadCounters &counters = block->counters;
+    stats.segmentTests += load(counters.segmentTests);
+    stats.segmentHits += load(counters.segmentHits);
+    stats.predicateFallbacks += load(counters.predicateFallbacks);
+    stats.pointInPolygonCalls += load(counters.pointInPolygonCalls);
+    stats.edgesVisited += load(counters.edgesVisited);
+    stats.validityChecks += load(counters.validityChecks);
+    stats.validityComputed += load(counters.validityComputed);
+    stats.sorts += load(counters.sorts);
+    stats.sortSeconds += load(counters.sortNanoseconds) / 1e9;
+
+    ThreadStats thread;
+    thread.thread = counters.thread;
+    thread.tasks = load(counters.reduceTasks);
+    thread.busySeconds = load(counters.reduceNanoseconds) / 1e9;
+    if (thread.tasks > 0)
+      stats.threads.push_back(thread);
+  }
+  stats.allocations += load(allocations);
+  stats.allocatedBytes += load(allocatedBytes);
+}
+
+/**< Counters of running threads may still be added to meanwhile. */
+void reset_thread_counters() {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (const auto &block : blocks) {
+    ThreadCounters &counters = block->counters;
+    counters.segmentTests.store(0, std::memory_order_relaxed);
+    counters.segmentHits.store(0, std::memory_order_relaxed);
+    counters.predicateFallbacks.store(0, std::memory_order_relaxed);
+    counters.pointInPolygonCalls.store(0, std::memory_order_relaxed);
+    counters.edgesVisited.store(0, std::memory_order_relaxed);
+    counters.validityChecks.store(0, std::memory_order_relaxed);
+    counters.validityComputed.store(0, std::memory_order_relaxed);
+    counters.sorts.store(0, std::memory_order_relaxed);
+    counters.sortNanoseconds.store(0, std::memory_order_relaxed);
+    counters.reduceTasks.store(0, std::memory_order_relaxed);
+    counters.reduceNanoseconds.store(0, std::memory_order_relaxed);
+  }
+  allocations.store(0, std::memory_order_relaxed);
+  allocatedBytes.store(0, std::memory_order_relaxed);
+}
+
+void count_allocation(std::size_t bytes) {
+  if (statsEnabled.load(std::memory_order_relaxed)) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+}
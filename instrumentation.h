@@ -0,0 +1,162 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct OperationStats;
+
+/**
+ * Hot path counters and trace spans. Both cost one relaxed load and a branch
+ * while switched off at runtime (see Polygon::set_stats_enabled), and
+ * nothing at all when the library is built with POLYGON_ENABLE_STATS=0.
+ * Counters live in a per thread block that only its thread writes, the
+ * snapshot in Polygon::stats() sums the blocks of all threads.
+ */
+#ifndef POLYGON_ENABLE_STATS
+#define POLYGON_ENABLE_STATS 1
+#endif
+
+/**
+ * @brief Counters of one thread, see OperationStats for their meaning.
+ */
+struct ThreadCounters {
+  std::atomic<uint64_t> segmentTests{0};
+  std::atomic<uint64_t> segmentHits{0};
+  std::atomic<uint64_t> predicateFallbacks{0};
+  std::atomic<uint64_t> pointInPolygonCalls{0};
+  std::atomic<uint64_t> edgesVisited{0};
+  std::atomic<uint64_t> validityChecks{0};
+  std::atomic<uint64_t> validityComputed{0};
+  std::atomic<uint64_t> sorts{0};
+  std::atomic<uint64_t> sortNanoseconds{0};
+  std::atomic<uint64_t> reduceTasks{0};
+  std::atomic<uint64_t> reduceNanoseconds{0};
+  unsigned int thread = 0; /**< Registration order, 0 for the first. */
+};
+
+extern std::atomic<bool> statsEnabled; /**< Counters and timers. */
+extern std::atomic<bool> traceEnabled; /**< Trace spans. */
+
+/**
+ * @brief Get the counters of the calling thread, registering them on first
+ * use.
+ *
+ * @return The counters.
+ */
+ThreadCounters &thread_counters();
+
+/**
+ * @brief Nanoseconds on a steady clock.
+ *
+ * @return The time.
+ */
+uint64_t instrumentation_now();
+
+/**
+ * @brief Add to a counter of the calling thread.
+ *
+ * @param counter The counter.
+ * @param amount Amount to add.
+ */
+inline void add_count(std::atomic<uint64_t> &counter, uint64_t amount) {
+  counter.fetch_add(amount, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Records the time between its construction and destruction as a
+ * complete event of the Chrome trace, and optionally adds it to a counter.
+ */
+class TraceSpan {
+public:
+  /**
+   * @brief Start the span.
+   *
+   * @param name Name of the event, must outlive the trace.
+   * @param timer Counter of the calling thread the duration is added to, or
+   * null.
+   * @param calls Counter of the calling thread incremented once, or null.
+   */
+  explicit TraceSpan(const char *name,
+                     std::atomic<uint64_t> ThreadCounters::*timer = nullptr,
+                     std::atomic<uint64_t> ThreadCounters::*calls = nullptr);
+
+  /**
+   * @brief End the span.
+   */
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+  const char *name; /**< Event name. */
+  std::atomic<uint64_t> ThreadCounters::*timer; /**< Duration counter. */
+  std::atomic<uint64_t> ThreadCounters::*calls; /**< Call counter. */
+  bool tracing = false; /**< Tracing was on at the start. */
+  bool timing = false;  /**< Counters were on at the start. */
+  uint64_t start = 0;   /**< Start time in nanoseconds. */
+};
+
+/**
+ * @brief Write the spans recorded so far as Chrome trace JSON, loadable in
+ * chrome://tracing or Perfetto, and forget them.
+ *
+ * @param filename The name of the file.
+ *
+ * @return True if the file was written.
+ */
+bool write_trace_events(const std::string &filename);
+
+/**
+ * @brief Add the counters of all threads and the allocation totals.
+ *
+ * @param stats Output, the counters are added to it.
+ */
+void add_thread_counters(OperationStats &stats);
+
+/**
+ * @brief Set the counters of all threads and the allocation totals back to
+ * zero.
+ */
+void reset_thread_counters();
+
+/**
+ * @brief Count a heap allocation while the stats are enabled. The library
+ * itself never calls it, programs that want their allocations in the stats
+ * compile alloc_hook.cpp in, which calls it from operator new. It does not
+ * allocate.
+ *
+ * @param bytes Bytes asked for.
+ */
+void count_allocation(std::size_t bytes);
+
+#if POLYGON_ENABLE_STATS
+/**< Add amount to the named counter of the calling thread. */
+#define POLYGON_COUNT(counter, amount)                                         \
+  do {                                                                         \
+    if (statsEnabled.load(std::memory_order_relaxed))                          \
+      add_count(thread_counters().counter, (amount));                         \
+  } while (0)
+
+/**< Trace the rest of the scope as a span of the given name. */
+#define POLYGON_SPAN(name) TraceSpan polygonSpan(name)
+
+/**< Same, also adding the duration and one call to the named counters. */
+#define POLYGON_TIMED_SPAN(name, timer, calls)                                 \
+  TraceSpan polygonSpan(name, &ThreadCounters::timer, &ThreadCounters::calls)
+#else
+#define POLYGON_COUNT(counter, amount)                                         \
+  do {                                                                         \
+  } while (0)
+#define POLYGON_SPAN(name)                                                     \
+  do {                                                                         \
+  } while (0)
+#define POLYGON_TIMED_SPAN(name, timer, calls)                                 \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#endif // INSTRUMENTATION_H
@@ -1,18 +1,26 @@
+#include "batch.h"
 #include "polygon.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <vector>
 
-int main() {
-  /**<  Example usage of the Polygon class */
+namespace { /**< Internal helper functions */
+
+/**< Example usage of the Polygon class on the two sample files
+ * (square.csv and triangle.csv), the union of both goes to outputName. */
+int run_demo(const char *squareName, const char *triangleName,
+             const char *outputName) {
   Polygon triangle, square, result;
 
-  if (!square.read_file("/home/hammad/workspace/polgons/square.csv")) {
+  if (!square.read_file(squareName)) {
     std::cout << "Failed to read square data ! \n";
     return -1;
   }
 
-  if (!triangle.read_file("/home/hammad/workspace/polgons/triangle.csv")) {
+  if (!triangle.read_file(triangleName)) {
     std::cout << "Failed to read triangle data ! \n";
     return -2;
   }
@@ -37,7 +45,7 @@ int main() {
   list.emplace_back(triangle);
   list.emplace_back(square);
   result = result.apply_ops(list, SetOperation::Union);
-  result.write_file("/home/hammad/workspace/polgons/output.csv");
+  result.write_file(outputName);
 
   if (square == triangle) {
     std::cout << "Polygons are equal." << std::endl;
@@ -54,3 +62,81 @@ int main() {
 
   return 0;
 }
+
+/**< Command line help. */
+void print_usage(const char *program) {
+  std::cerr << "usage: " << program
+            << " [--threads N] [--queue N] [--simplify T] [--cache MB] "
+               "[--stats] [--trace file] [manifest]\n"
+            << "       " << program << " --demo <square> <triangle> <output>\n"
+            << "Runs the jobs of the manifest, or of stdin if it is missing "
+               "or \"-\", one per line:\n"
+            << "  <union|intersection|difference> <output> <input> "
+               "[<input> ...]\n"
+            << "--simplify drops vertices closer than T to the simplified "
+               "boundary before every operation.\n"
+            << "--cache keeps up to MB megabytes of results, repeated pairs "
+               "are not computed again.\n"
+            << "--stats prints the operation counters to stderr, --trace "
+               "writes a Chrome trace of the run.\n";
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  BatchOptions options;
+  const char *manifestName = nullptr;
+  const char *traceName = nullptr;
+  bool printStats = false;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--demo") == 0 && i + 3 < argc) {
+      return run_demo(argv[i + 1], argv[i + 2], argv[i + 3]);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      options.computeThreads = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--queue") == 0 && i + 1 < argc) {
+      options.queueCapacity = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--simplify") == 0 && i + 1 < argc) {
+      SimplifyOptions simplify;
+      simplify.enabled = true;
+      simplify.tolerance = std::strtod(argv[++i], nullptr);
+      Polygon::set_simplify_options(simplify);
+    } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+      ResultCacheOptions cache;
+      cache.enabled = true;
+      cache.maxBytes = std::strtoul(argv[++i], nullptr, 10) << 20;
+      Polygon::set_result_cache_options(cache);
+    } else if (std::strcmp(argv[i], "--stats") == 0) {
+      printStats = true;
+    } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      traceName = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      print_usage(argv[0]);
+      return 1;
+    } else {
+      manifestName = argv[i];
+    }
+  }
+
+  Polygon::set_stats_enabled(printStats);
+  Polygon::set_trace_enabled(traceName != nullptr);
+
+  BatchSummary summary;
+  if (manifestName && std::strcmp(manifestName, "-") != 0) {
+    std::ifstream manifest(manifestName);
+    if (!manifest.is_open()) {
+      std::cerr << "Error opening file: " << manifestName << std::endl;
+      return 1;
+    }
+    summary = run_batch(manifest, std::cout, options);
+  } else {
+    summary = run_batch(std::cin, std::cout, options);
+  }
+
+  if (printStats)
+    std::cerr << Polygon::stats();
+  if (traceName && !Polygon::write_trace(traceName)) {
+    std::cerr << "Error writing file: " << traceName << std::endl;
+    return 1;
+  }
+
+  return summary.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+#include "multi_polygon.h"
+#include "boolean_op.h"
+#include "instrumentation.h"
+#include "polygon_io.h"
+#include "predicates.h"
+#include "sweep_line.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace { /**< Internal helper functions */
+
+/**< Twice the signed area of a ring, positive counter clockwise. */
+double twice_signed_area(const PolygonView &ring) {
+  double sum = 0.0;
+  for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+    sum += (ring[j].x - ring[i].x) * (ring[j].y + ring[i].y);
+  return sum;
+}
+
+/**< Some vertex of a ring lies in another ring with the given code. */
+bool any_vertex_classified(const PolygonView &ring, const PolygonView &other,
+                           int code) {
+  std::vector<int8_t> codes(ring.size());
+  other.classify(ring.data(), ring.size(), codes.data());
+  return std::find(codes.begin(), codes.end(), code) != codes.end();
+}
+
+/**< Edges meeting at a vertex of either one are rings touching, anything
+ * else that is not inside is caught by the vertex tests. */
+bool rings_cross(const PolygonView &a, const PolygonView &b) {
+  std::vector<EdgeCrossing> crossings;
+  find_edge_crossings(a, b, crossings);
+  for (const EdgeCrossing &crossing : crossings) {
+    const Point &a1 = a[crossing.edgeA];
+    const Point &a2 = a[(crossing.edgeA + 1) % a.size()];
+    const Point &b1 = b[crossing.edgeB];
+    const Point &b2 = b[(crossing.edgeB + 1) % b.size()];
+    if (orient2d(a1, a2, b1) != 0.0 && orient2d(a1, a2, b2) != 0.0 &&
+        orient2d(b1, b2, a1) != 0.0 && orient2d(b1, b2, a2) != 0.0)
+      return true;
+  }
+  return false;
+}
+} // namespace
+
+/**< No rings, the offset arrays hold the end only. */
+MultiPolygon::MultiPolygon() : ringOffsets(1, 0), partOffsets(1, 0) {}
+
+/**< Copies the vertices in the order the polygon keeps them. */
+MultiPolygon::MultiPolygon(const Polygon &polygon) : MultiPolygon() {
+  add_part(PolygonView(polygon));
+}
+
+/**< The vertex vector becomes the coordinate buffer. */
+MultiPolygon::MultiPolygon(Polygon &&polygon) : MultiPolygon() {
+  if (polygon.points.empty())
+    return;
+  const BoundingBox bounds = polygon.get_bounding_box();
+  points = std::move(polygon.points);
+  polygon.invalidate_cache();
+  ringOffsets.push_back(points.size());
+  ringBounds.push_back(bounds);
+  partOffsets.push_back(1);
+}
+
+/**< Starts a part with its outer ring. */
+void MultiPolygon::add_part(const PolygonView &outer) {
+  append_ring(outer);
+  partOffsets.push_back(ring_count());
+}
+
+/**< Extends the last part. */
+bool MultiPolygon::add_hole(const PolygonView &hole) {
+  if (part_count() == 0)
+    return false;
+  append_ring(hole);
+  partOffsets.back() = ring_count();
+  return true;
+}
+
+/**< Copies the vertices to the end of the buffer. */
+void MultiPolygon::append_ring(const PolygonView &ring) {
+  points.insert(points.end(), ring.begin(), ring.end());
+  ringOffsets.push_back(points.size());
+  ringBounds.push_back(ring.get_bounding_box());
+}
+
+/**< Points into the buffer. */
+PolygonView MultiPolygon::ring(size_t ring) const {
+  return PolygonView(points.data() + ringOffsets[ring],
+                     ringOffsets[ring + 1] - ringOffsets[ring],
+                     ringBounds[ring]);
+}
+
+std::vector<PolygonView> MultiPolygon::rings() const {
+  std::vector<PolygonView> views;
+  views.reserve(ring_count());
+  for (size_t i = 0; i < ring_count(); ++i)
+    views.push_back(ring(i));
+  return views;
+}
+
+/**< Union of the ring boxes. */
+BoundingBox MultiPolygon::get_bounding_box() const {
+  if (ringBounds.empty())
+    return BoundingBox();
+  BoundingBox box = ringBounds.front();
+  for (const BoundingBox &bounds : ringBounds) {
+    box.minX = std::min(box.minX, bounds.minX);
+    box.minY = std::min(box.minY, bounds.minY);
+    box.maxX = std::max(box.maxX, bounds.maxX);
+    box.maxY = std::max(box.maxY, bounds.maxY);
+  }
+  return box;
+}
+
+/**< Outer rings count positive, holes negative, whatever their direction. */
+double MultiPolygon::get_area() const {
+  double area = 0.0;
+  for (size_t part = 0; part < part_count(); ++part) {
+    for (size_t i = partOffsets[part]; i < partOffsets[part + 1]; ++i) {
+      const double ringArea = std::abs(twice_signed_area(ring(i))) / 2.0;
+      area += (i == partOffsets[part]) ? ringArea : -ringArea;
+    }
+  }
+  return area;
+}
+
+/**< Inside the outer ring and outside every hole. */
+bool MultiPolygon::part_contains_vertex(size_t part,
+                                        const PolygonView &ring) const {
+  const size_t outer = partOffsets[part];
+  std::vector<int8_t> inside(ring.size()), codes(ring.size());
+  this->ring(outer).classify(ring.data(), ring.size(), inside.data());
+  for (size_t hole = outer + 1; hole < partOffsets[part + 1]; ++hole) {
+    this->ring(hole).classify(ring.data(), ring.size(), codes.data());
+    for (size_t i = 0; i < ring.size(); ++i)
+      if (codes[i] != -1)
+        inside[i] = -1;
+  }
+  return std::find(inside.begin(), inside.end(), 1) != inside.end();
+}
+
+/**< Rings first on their own, then pairwise where their boxes meet. */
+bool MultiPolygon::is_valid() const {
+  POLYGON_SPAN("is_valid");
+  for (size_t i = 0; i < ring_count(); ++i)
+    if (!ring(i).is_valid())
+      return false;
+
+  for (size_t i = 0; i < ring_count(); ++i) {
+    for (size_t j = i + 1; j < ring_count(); ++j) {
+      if (ringBounds[i].overlaps(ringBounds[j]) &&
+          rings_cross(ring(i), ring(j)))
+        return false;
+    }
+  }
+
+  for (size_t part = 0; part < part_count(); ++part) {
+    const size_t outer = partOffsets[part];
+    const size_t end = partOffsets[part + 1];
+    for (size_t hole = outer + 1; hole < end; ++hole) {
+      if (any_vertex_classified(ring(hole), ring(outer), -1))
+        return false;
+      for (size_t other = hole + 1; other < end; ++other) {
+        if (ringBounds[hole].overlaps(ringBounds[other]) &&
+            (any_vertex_classified(ring(hole), ring(other), 1) ||
+             any_vertex_classified(ring(other), ring(hole), 1)))
+          return false;
+      }
+    }
+  }
+
+  for (size_t part = 0; part < part_count(); ++part) {
+    for (size_t other = part + 1; other < part_count(); ++other) {
+      const size_t a = partOffsets[part], b = partOffsets[other];
+      if (ringBounds[a].overlaps(ringBounds[b]) &&
+          (part_contains_vertex(part, ring(b)) ||
+           part_contains_vertex(other, ring(a))))
+        return false;
+    }
+  }
+  return true;
+}
+
+/**< Even-odd over the rings, any boundary hit wins. */
+void MultiPolygon::classify(const Point *pts, size_t n, int8_t *out) const {
+  std::fill(out, out + n, -1);
+  std::vector<int8_t> codes(n);
+  std::vector<bool> boundary(n, false);
+  for (size_t i = 0; i < ring_count(); ++i) {
+    ring(i).classify(pts, n, codes.data());
+    for (size_t k = 0; k < n; ++k) {
+      if (codes[k] == 0)
+        boundary[k] = true;
+      else if (codes[k] == 1)
+        out[k] = -out[k];
+    }
+  }
+  for (size_t k = 0; k < n; ++k)
+    if (boundary[k])
+      out[k] = 0;
+}
+
+/**< Every ring of both as one region each. */
+MultiPolygon MultiPolygon::compute_operation(const MultiPolygon &A,
+                                             const MultiPolygon &B,
+                                             SetOperation op) {
+  return compute_operation(A.rings(), B.rings(), op);
+}
+
+/**< The result rings come outer ring first, then its holes. */
+MultiPolygon
+MultiPolygon::compute_operation(const std::vector<PolygonView> &subject,
+                                const std::vector<PolygonView> &clipping,
+                                SetOperation op) {
+  POLYGON_SPAN("boolean");
+  std::vector<ResultRing> rings;
+  boolean_operation(subject, clipping, op, rings);
+
+  MultiPolygon result;
+  size_t count = 0;
+  for (const ResultRing &ring : rings)
+    count += ring.points.size();
+  result.points.reserve(count);
+  for (const ResultRing &ring : rings) {
+    if (ring.holeOf < 0)
+      result.add_part(PolygonView(ring.points));
+    else
+      result.add_hole(PolygonView(ring.points));
+  }
+  return result;
+}
+
+/**< Same coordinate format as the Polygon output. */
+std::ostream &operator<<(std::ostream &os, const MultiPolygon &multiPolygon) {
+  std::string text = "MultiPolygon coordinates:\n";
+  for (size_t part = 0; part < multiPolygon.part_count(); ++part) {
+    size_t first, last;
+    multiPolygon.part_rings(part, first, last);
+    for (size_t r = first; r < last; ++r) {
+      if (r != first)
+        text += "  ";
+      const PolygonView ring = multiPolygon.ring(r);
+      for (size_t i = 0; i < ring.size(); ++i) {
+        text.push_back('(');
+        format_double(text, ring[i].x);
+        text.push_back(',');
+        format_double(text, ring[i].y);
+        text.push_back(')');
+        text.push_back(i + 1 == ring.size() ? '\n' : ',');
+      }
+    }
+  }
+  return os.write(text.data(), text.size());
+}
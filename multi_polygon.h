@@ -0,0 +1,217 @@
+#ifndef MULTI_POLYGON_H
+#define MULTI_POLYGON_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+/**
+ * @brief Several polygons with holes in one flat layout. The vertices of
+ * every ring of every part follow each other in a single array, ring r owns
+ * the vertices [ringOffsets[r], ringOffsets[r + 1]) and part p the rings
+ * [partOffsets[p], partOffsets[p + 1]). The first ring of a part is its
+ * outer boundary, the others are its holes. Rings may run either way, the
+ * inside is decided by the even-odd rule over all rings, which for a valid
+ * multi polygon is the outer rings minus their holes.
+ */
+class MultiPolygon {
+public:
+  /**
+   * @brief Empty multi polygon, the empty set.
+   */
+  MultiPolygon();
+
+  /**
+   * @brief One part without holes, the vertices are copied.
+   *
+   * @param polygon The polygon.
+   */
+  explicit MultiPolygon(const Polygon &polygon);
+
+  /**
+   * @brief One part without holes, taking over the storage of the polygon's
+   * vertices instead of copying them.
+   *
+   * @param polygon The polygon, left empty.
+   */
+  explicit MultiPolygon(Polygon &&polygon);
+
+  /**
+   * @brief Append a part.
+   *
+   * @param outer Vertices of its outer ring, copied.
+   */
+  void add_part(const PolygonView &outer);
+
+  /**
+   * @brief Append a hole to the last part.
+   *
+   * @param hole Vertices of the hole, copied.
+   *
+   * @return False if there is no part yet, nothing is added then.
+   */
+  bool add_hole(const PolygonView &hole);
+
+  /**
+   * @brief Get the number of parts.
+   *
+   * @return Number of parts.
+   */
+  size_t part_count() const { return partOffsets.size() - 1; }
+
+  /**
+   * @brief Get the number of rings of all parts.
+   *
+   * @return Number of rings.
+   */
+  size_t ring_count() const { return ringOffsets.size() - 1; }
+
+  /**
+   * @brief Get the total number of vertices of all rings.
+   *
+   * @return Number of vertices.
+   */
+  size_t get_number_of_points() const { return points.size(); }
+
+  /**
+   * @brief Get the rings of a part, the outer ring first.
+   *
+   * @param part Index of the part.
+   * @param first Output, index of its outer ring.
+   * @param last Output, one past the index of its last hole.
+   */
+  void part_rings(size_t part, size_t &first, size_t &last) const {
+    first = partOffsets[part];
+    last = partOffsets[part + 1];
+  }
+
+  /**
+   * @brief View one ring without copying it.
+   *
+   * @param ring Index of the ring.
+   *
+   * @return The vertices of the ring, valid until the multi polygon changes.
+   */
+  PolygonView ring(size_t ring) const;
+
+  /**
+   * @brief View every ring, in part order.
+   *
+   * @return The rings, valid until the multi polygon changes.
+   */
+  std::vector<PolygonView> rings() const;
+
+  /**
+   * @brief Get the vertices of all rings, one ring after the other.
+   *
+   * @return The vertices.
+   */
+  const std::vector<Point> &get_points() const { return points; }
+
+  /**
+   * @brief Get the axis aligned bounding box of all rings.
+   *
+   * @return The bounding box, all zero if there are no rings.
+   */
+  BoundingBox get_bounding_box() const;
+
+  /**
+   * @brief Get the area covered, the outer rings minus their holes.
+   *
+   * @return The area, not negative.
+   */
+  double get_area() const;
+
+  /**
+   * @brief Check that the rings form polygons with holes: every ring is
+   * valid on its own (see Polygon::is_valid), rings meet at most at
+   * vertices, holes lie in their outer ring and apart from each other, and
+   * the parts do not overlap. A part may lie in a hole of another one.
+   * Pairs of rings whose boxes miss are not compared.
+   *
+   * @return True if the multi polygon is valid, false otherwise.
+   */
+  bool is_valid() const;
+
+  /**
+   * @brief Classify many points against the region, with the codes of
+   * Polygon::classify. A point on any ring is on the boundary.
+   *
+   * @param pts Points to classify.
+   * @param n Number of points.
+   * @param out Output per point: 1 inside, 0 on the boundary, -1 outside.
+   */
+  void classify(const Point *pts, size_t n, int8_t *out) const;
+
+  /**
+   * @brief Apply a set operation to two multi polygons with the sweep of
+   * boolean_op.h.
+   *
+   * @param A The first multi polygon.
+   * @param B The second multi polygon.
+   * @param op The specified operation eg Union, Intersection, Difference or
+   * Xor.
+   *
+   * @return The resulting multi polygon. Outer rings run counter clockwise,
+   * holes clockwise.
+   */
+  static MultiPolygon compute_operation(const MultiPolygon &A,
+                                        const MultiPolygon &B,
+                                        SetOperation op);
+
+  /**
+   * @brief Apply a set operation to two regions given as rings under the
+   * even-odd rule, for example the rings of polygons or of a binary file.
+   *
+   * @param subject Rings of the first region.
+   * @param clipping Rings of the second region.
+   * @param op The specified operation eg Union, Intersection, Difference or
+   * Xor.
+   *
+   * @return The resulting multi polygon, as for the overload above.
+   */
+  static MultiPolygon
+  compute_operation(const std::vector<PolygonView> &subject,
+                    const std::vector<PolygonView> &clipping, SetOperation op);
+
+  /**
+   * @brief Overloaded stream insertion operator, one line per ring with the
+   * holes indented.
+   *
+   * @param os The output stream.
+   * @param multiPolygon The multi polygon to output.
+   *
+   * @return Reference to the output stream.
+   */
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const MultiPolygon &multiPolygon);
+
+private:
+  std::vector<Point> points;           /**< Vertices of all rings. */
+  std::vector<size_t> ringOffsets;     /**< First vertex per ring, + end. */
+  std::vector<size_t> partOffsets;     /**< First ring per part, + end. */
+  std::vector<BoundingBox> ringBounds; /**< Box of each ring. */
+
+  /**
+   * @brief Append a ring to the last part.
+   *
+   * @param ring Vertices of the ring.
+   */
+  void append_ring(const PolygonView &ring);
+
+  /**
+   * @brief Check whether a vertex of a ring lies strictly inside a part,
+   * that is inside its outer ring and outside its holes.
+   *
+   * @param part Index of the part.
+   * @param ring The ring.
+   *
+   * @return True if at least one vertex does.
+   */
+  bool part_contains_vertex(size_t part, const PolygonView &ring) const;
+};
+
+#endif // MULTI_POLYGON_H
@@ -0,0 +1,424 @@
+#include "point_in_polygon.h"
+#include "external.h"
+#include "instrumentation.h"
+#include "predicates.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define POLYGON_AVX2_DISPATCH 1 /**< AVX2 path chosen at runtime. */
+#endif
+
+namespace { /**< Internal helper functions */
+
+/**
+ * @brief One edge of the winding number test of is_point_inside_polygon.
+ *
+ * @param edges Edge table of the polygon.
+ * @param i Index of the edge.
+ * @param query Point to classify.
+ * @param windingNumber Running winding number, updated for this edge.
+ *
+ * @return True if the point lies on the edge, which settles the test.
+ */
+inline bool winding_step(const EdgeTable &edges, size_t i, const Point &query,
+                         int &windingNumber) {
+  const double left = (query.y - edges.startY[i]) * edges.deltaX[i];
+  const double right = (query.x - edges.startX[i]) * edges.deltaY[i];
+  double side = left - right;
+
+  /**< Outside the tolerance but within the rounding error of the products,
+   * the sign is decided exactly from the vertices (predicates.h). */
+  const double detsum = std::abs(left) + std::abs(right);
+  if (std::abs(side) >= epsilon &&
+      std::abs(side) <= orient2d_filter_bound * detsum)
+    side = orient2d_adaptive(Point{edges.endX[i], edges.endY[i]}, query,
+                             Point{edges.startX[i], edges.startY[i]}, detsum);
+
+  /**< Collinear with the edge, on it if within its bounds. */
+  if (std::abs(side) < epsilon)
+    return query.x >= edges.minX[i] && query.x <= edges.maxX[i] &&
+           query.y >= edges.minY[i] && query.y <= edges.maxY[i];
+
+  if (edges.startY[i] <= query.y) {
+    if (edges.endY[i] > query.y && side > epsilon)
+      ++windingNumber; /**< Upward crossing, point left of edge. */
+  } else {
+    if (edges.endY[i] <= query.y && side < -epsilon)
+      --windingNumber; /**< Downward crossing, point right of edge. */
+  }
+  return false;
+}
+
+/**
+ * @brief Winding number test of one point against the edge table, the
+ * scalar twin of is_point_inside_polygon.
+ */
+int8_t classify_scalar(const EdgeTable &edges, const Point &query) {
+  int windingNumber = 0;
+
+  for (size_t i = 0; i < edges.size(); ++i)
+    if (winding_step(edges, i, query, windingNumber))
+      return 0;
+
+  return (windingNumber != 0) ? 1 : -1;
+}
+
+/**
+ * @brief Bound on the rounding error of the edge test of a point against any
+ * edge of the table, twice the filter bound of the largest products the test
+ * can form. Vector lanes whose side lies between epsilon and this bound are
+ * tested again by classify_scalar.
+ */
+inline double rounding_bound(const EdgeTable &edges, const Point &query) {
+  const BoundingBox &box = edges.vertexBounds;
+  const double reachX =
+      std::max(std::abs(query.x - box.minX), std::abs(query.x - box.maxX));
+  const double reachY =
+      std::max(std::abs(query.y - box.minY), std::abs(query.y - box.maxY));
+  return 2.0 * orient2d_filter_bound *
+         (reachY * edges.maxDeltaX + reachX * edges.maxDeltaY);
+}
+
+#if defined(__SSE2__)
+/**< Lane select, mask ? a : b. */
+inline __m128d select(__m128d mask, __m128d a, __m128d b) {
+  return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+/**
+ * @brief Two points per iteration with SSE2.
+ *
+ * @return Number of points classified, the rest is left to the caller.
+ */
+size_t classify_sse2(const EdgeTable &edges, const Point *points,
+                     size_t count, int8_t *codes) {
+  const __m128d signMask = _mm_set1_pd(-0.0);
+  const __m128d eps = _mm_set1_pd(epsilon);
+  const __m128d negEps = _mm_set1_pd(-epsilon);
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d minusOne = _mm_set1_pd(-1.0);
+  const __m128d zero = _mm_setzero_pd();
+
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m128d qx = _mm_set_pd(points[i + 1].x, points[i].x);
+    const __m128d qy = _mm_set_pd(points[i + 1].y, points[i].y);
+    const __m128d bound = _mm_set_pd(rounding_bound(edges, points[i + 1]),
+                                     rounding_bound(edges, points[i]));
+    __m128d winding = zero;
+    __m128d done = zero;   /**< Lanes found on an edge. */
+    __m128d unsure = zero; /**< Lanes with a side test of unproven sign. */
+
+    for (size_t e = 0; e < edges.size(); ++e) {
+      const __m128d x0 = _mm_set1_pd(edges.startX[e]);
+      const __m128d y0 = _mm_set1_pd(edges.startY[e]);
+      const __m128d side = _mm_sub_pd(
+          _mm_mul_pd(_mm_sub_pd(qy, y0), _mm_set1_pd(edges.deltaX[e])),
+          _mm_mul_pd(_mm_sub_pd(qx, x0), _mm_set1_pd(edges.deltaY[e])));
+
+      /**< Collinear lanes never count a crossing, the side tests below
+       * fail for them, they only need the on segment check. */
+      const __m128d magnitude = _mm_andnot_pd(signMask, side);
+      const __m128d collinear = _mm_cmplt_pd(magnitude, eps);
+      unsure = _mm_or_pd(
+          unsure, _mm_andnot_pd(collinear, _mm_cmple_pd(magnitude, bound)));
+      if (_mm_movemask_pd(collinear) != 0) {
+        const __m128d onSegment = _mm_and_pd(
+            _mm_and_pd(_mm_cmpge_pd(qx, _mm_set1_pd(edges.minX[e])),
+                       _mm_cmple_pd(qx, _mm_set1_pd(edges.maxX[e]))),
+            _mm_and_pd(_mm_cmpge_pd(qy, _mm_set1_pd(edges.minY[e])),
+                       _mm_cmple_pd(qy, _mm_set1_pd(edges.maxY[e]))));
+        done = _mm_or_pd(done, _mm_and_pd(collinear, onSegment));
+        if (_mm_movemask_pd(done) == 0x3)
+          break;
+      }
+
+      const __m128d y1 = _mm_set1_pd(edges.endY[e]);
+      const __m128d startBelow = _mm_cmple_pd(y0, qy);
+      const __m128d up =
+          _mm_and_pd(startBelow, _mm_and_pd(_mm_cmpgt_pd(y1, qy),
+                                            _mm_cmpgt_pd(side, eps)));
+      const __m128d down =
+          _mm_andnot_pd(startBelow, _mm_and_pd(_mm_cmple_pd(y1, qy),
+                                               _mm_cmplt_pd(side, negEps)));
+      winding = _mm_add_pd(winding, _mm_and_pd(up, one));
+      winding = _mm_sub_pd(winding, _mm_and_pd(down, one));
+    }
+
+    const __m128d wound =
+        select(_mm_cmpneq_pd(winding, zero), one, minusOne);
+    double result[2];
+    _mm_storeu_pd(result, _mm_andnot_pd(done, wound));
+    codes[i] = static_cast<int8_t>(result[0]);
+    codes[i + 1] = static_cast<int8_t>(result[1]);
+
+    const int recheck = _mm_movemask_pd(_mm_andnot_pd(done, unsure));
+    for (int lane = 0; lane < 2; ++lane)
+      if (recheck & (1 << lane))
+        codes[i + lane] = classify_scalar(edges, points[i + lane]);
+  }
+  return i;
+}
+#endif
+
+#if defined(POLYGON_AVX2_DISPATCH)
+/**
+ * @brief Four points per iteration with AVX2. Compiled for AVX2 only (no
+ * FMA) so every lane rounds exactly like the scalar code.
+ *
+ * @return Number of points classified, the rest is left to the caller.
+ */
+__attribute__((target("avx2"))) size_t
+classify_avx2(const EdgeTable &edges, const Point *points, size_t count,
+              int8_t *codes) {
+  const __m256d signMask = _mm256_set1_pd(-0.0);
+  const __m256d eps = _mm256_set1_pd(epsilon);
+  const __m256d negEps = _mm256_set1_pd(-epsilon);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d minusOne = _mm256_set1_pd(-1.0);
+  const __m256d zero = _mm256_setzero_pd();
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d qx = _mm256_set_pd(points[i + 3].x, points[i + 2].x,
+                                     points[i + 1].x, points[i].x);
+    const __m256d qy = _mm256_set_pd(points[i + 3].y, points[i + 2].y,
+                                     points[i + 1].y, points[i].y);
+    const __m256d bound = _mm256_set_pd(rounding_bound(edges, points[i + 3]),
+                                        rounding_bound(edges, points[i + 2]),
+                                        rounding_bound(edges, points[i + 1]),
+                                        rounding_bound(edges, points[i]));
+    __m256d winding = zero;
+    __m256d done = zero;   /**< Lanes found on an edge. */
+    __m256d unsure = zero; /**< Lanes with a side test of unproven sign. */
+
+    for (size_t e = 0; e < edges.size(); ++e) {
+      const __m256d x0 = _mm256_broadcast_sd(&edges.startX[e]);
+      const __m256d y0 = _mm256_broadcast_sd(&edges.startY[e]);
+      const __m256d side = _mm256_sub_pd(
+          _mm256_mul_pd(_mm256_sub_pd(qy, y0),
+                        _mm256_broadcast_sd(&edges.deltaX[e])),
+          _mm256_mul_pd(_mm256_sub_pd(qx, x0),
+                        _mm256_broadcast_sd(&edges.deltaY[e])));
+
+      /**< Collinear lanes never count a crossing, the side tests below
+       * fail for them, they only need the on segment check. */
+      const __m256d magnitude = _mm256_andnot_pd(signMask, side);
+      const __m256d collinear = _mm256_cmp_pd(magnitude, eps, _CMP_LT_OQ);
+      unsure = _mm256_or_pd(
+          unsure, _mm256_andnot_pd(collinear, _mm256_cmp_pd(magnitude, bound,
+                                                            _CMP_LE_OQ)));
+      if (!_mm256_testz_pd(collinear, collinear)) {
+        const __m256d onSegment = _mm256_and_pd(
+            _mm256_and_pd(
+                _mm256_cmp_pd(qx, _mm256_broadcast_sd(&edges.minX[e]),
+                              _CMP_GE_OQ),
+                _mm256_cmp_pd(qx, _mm256_broadcast_sd(&edges.maxX[e]),
+                              _CMP_LE_OQ)),
+            _mm256_and_pd(
+                _mm256_cmp_pd(qy, _mm256_broadcast_sd(&edges.minY[e]),
+                              _CMP_GE_OQ),
+                _mm256_cmp_pd(qy, _mm256_broadcast_sd(&edges.maxY[e]),
+                              _CMP_LE_OQ)));
+        done = _mm256_or_pd(done, _mm256_and_pd(collinear, onSegment));
+        if (_mm256_movemask_pd(done) == 0xF)
+          break;
+      }
+
+      const __m256d y1 = _mm256_broadcast_sd(&edges.endY[e]);
+      const __m256d startBelow = _mm256_cmp_pd(y0, qy, _CMP_LE_OQ);
+      const __m256d up = _mm256_and_pd(
+          startBelow, _mm256_and_pd(_mm256_cmp_pd(y1, qy, _CMP_GT_OQ),
+                                    _mm256_cmp_pd(side, eps, _CMP_GT_OQ)));
+      const __m256d down = _mm256_andnot_pd(
+          startBelow, _mm256_and_pd(_mm256_cmp_pd(y1, qy, _CMP_LE_OQ),
+                                    _mm256_cmp_pd(side, negEps, _CMP_LT_OQ)));
+      winding = _mm256_add_pd(winding, _mm256_and_pd(up, one));
+      winding = _mm256_sub_pd(winding, _mm256_and_pd(down, one));
+    }
+
+    const __m256d wound = _mm256_blendv_pd(
+        minusOne, one, _mm256_cmp_pd(winding, zero, _CMP_NEQ_UQ));
+    double result[4];
+    _mm256_storeu_pd(result, _mm256_andnot_pd(done, wound));
+    for (int lane = 0; lane < 4; ++lane)
+      codes[i + lane] = static_cast<int8_t>(result[lane]);
+
+    const int recheck = _mm256_movemask_pd(_mm256_andnot_pd(done, unsure));
+    for (int lane = 0; lane < 4; ++lane)
+      if (recheck & (1 << lane))
+        codes[i + lane] = classify_scalar(edges, points[i + lane]);
+  }
+  return i;
+}
+
+/**< CPU feature check, done once. */
+bool has_avx2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+#endif
+} // namespace
+
+/**< Edge table in the order of the vertices. */
+EdgeTable::EdgeTable(const PolygonView &vertices) {
+  const size_t n = vertices.size();
+  startX.resize(n);
+  startY.resize(n);
+  deltaX.resize(n);
+  deltaY.resize(n);
+  endX.resize(n);
+  endY.resize(n);
+  minX.resize(n);
+  maxX.resize(n);
+  minY.resize(n);
+  maxY.resize(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    const Point &start = vertices[i];
+    const Point &end = vertices[(i + 1) % n];
+    startX[i] = start.x;
+    startY[i] = start.y;
+    deltaX[i] = end.x - start.x;
+    deltaY[i] = end.y - start.y;
+    endX[i] = end.x;
+    endY[i] = end.y;
+    minX[i] = std::min(start.x, end.x) - epsilon;
+    maxX[i] = std::max(start.x, end.x) + epsilon;
+    minY[i] = std::min(start.y, end.y) - epsilon;
+    maxY[i] = std::max(start.y, end.y) + epsilon;
+    maxDeltaX = std::max(maxDeltaX, std::abs(deltaX[i]));
+    maxDeltaY = std::max(maxDeltaY, std::abs(deltaY[i]));
+  }
+  if (n > 0)
+    vertexBounds = vertices.get_bounding_box();
+}
+
+/**< Widest available vector path first, scalar loop for the tail. */
+void classify_points(const EdgeTable &edges, const Point *points, size_t count,
+                     int8_t *codes) {
+  POLYGON_COUNT(pointInPolygonCalls, count);
+  POLYGON_COUNT(edgesVisited, count * edges.size());
+  size_t done = 0;
+
+#if defined(POLYGON_AVX2_DISPATCH)
+  if (has_avx2())
+    done = classify_avx2(edges, points, count, codes);
+#endif
+#if defined(__SSE2__)
+  done += classify_sse2(edges, points + done, count - done, codes + done);
+#endif
+
+  for (size_t i = done; i < count; ++i)
+    codes[i] = classify_scalar(edges, points[i]);
+}
+
+/**< Slabs of equal height, one per edge, each listing its edges. */
+PreparedPolygon::PreparedPolygon(const Polygon &polygon)
+    : PreparedPolygon(polygon.get_edge_table()) {}
+
+/**< Same index over an edge table of its own. */
+PreparedPolygon::PreparedPolygon(const PolygonView &polygon)
+    : PreparedPolygon(std::make_shared<const EdgeTable>(polygon)) {}
+
+PreparedPolygon::PreparedPolygon(std::shared_ptr<const EdgeTable> shared)
+    : edges(std::move(shared)) {
+  const size_t n = edges->size();
+  if (n == 0)
+    return;
+
+  bounds.minX = *std::min_element(edges->minX.begin(), edges->minX.end());
+  bounds.maxX = *std::max_element(edges->maxX.begin(), edges->maxX.end());
+  bounds.minY = *std::min_element(edges->minY.begin(), edges->minY.end());
+  bounds.maxY = *std::max_element(edges->maxY.begin(), edges->maxY.end());
+
+  /**< One slab per edge, fewer if tall edges would be listed in so many
+   * slabs that the index outgrows about four entries per edge. */
+  const double height = bounds.maxY - bounds.minY;
+  double edgeHeights = 0.0;
+  for (size_t i = 0; i < n; ++i)
+    edgeHeights += edges->maxY[i] - edges->minY[i];
+  slabCount = n;
+  if (edgeHeights > 2.0 * height)
+    slabCount = std::max<size_t>(
+        1, static_cast<size_t>(2.0 * n * height / edgeHeights));
+  inverseSlabHeight = (height > 0.0) ? slabCount / height : 0.0;
+
+  /**< Count, then place, every edge in the slabs its y range touches. */
+  slabStart.assign(slabCount + 1, 0);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t s = slab_of(edges->minY[i]); s <= slab_of(edges->maxY[i]); ++s)
+      slabStart[s + 1]++;
+  std::partial_sum(slabStart.begin(), slabStart.end(), slabStart.begin());
+
+  slabEdges.resize(slabStart.back());
+  std::vector<uint32_t> fill(slabStart.begin(), slabStart.end() - 1);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t s = slab_of(edges->minY[i]); s <= slab_of(edges->maxY[i]); ++s)
+      slabEdges[fill[s]++] = static_cast<uint32_t>(i);
+
+  /**< Rightmost edges first so a query stops at the first edge left of it. */
+  const EdgeTable &table = *edges;
+  for (size_t s = 0; s < slabCount; ++s)
+    std::sort(slabEdges.begin() + slabStart[s],
+              slabEdges.begin() + slabStart[s + 1],
+              [&table](uint32_t a, uint32_t b) {
+                if (table.maxX[a] != table.maxX[b])
+                  return table.maxX[a] > table.maxX[b];
+                return a < b;
+              });
+}
+
+/**< Slab holding y, clamped to the valid range. Monotone in y, so an edge
+ * whose y range contains y is always listed in this slab. */
+size_t PreparedPolygon::slab_of(double y) const {
+  const double offset = (y - bounds.minY) * inverseSlabHeight;
+  if (!(offset > 0.0))
+    return 0;
+  return std::min(slabCount - 1, static_cast<size_t>(offset));
+}
+
+/**< Winding number over the edges of one slab. */
+int PreparedPolygon::classify(const Point &query) const {
+  POLYGON_COUNT(pointInPolygonCalls, 1);
+  /**< No edge is near a point outside the bounds, it cannot be wound. */
+  if (slabCount == 0 || query.x < bounds.minX || query.x > bounds.maxX ||
+      query.y < bounds.minY || query.y > bounds.maxY)
+    return -1;
+
+  const EdgeTable &table = *edges;
+  const size_t s = slab_of(query.y);
+  int windingNumber = 0;
+  bool onEdge = false;
+
+  uint32_t k = slabStart[s];
+  for (; k < slabStart[s + 1]; ++k) {
+    const uint32_t i = slabEdges[k];
+    /**< Edges entirely left of the point neither touch nor cross the ray. */
+    if (table.maxX[i] < query.x)
+      break;
+    if (winding_step(table, i, query, windingNumber)) {
+      onEdge = true;
+      break;
+    }
+  }
+  POLYGON_COUNT(edgesVisited, k - slabStart[s] + onEdge);
+
+  if (onEdge)
+    return 0;
+  return (windingNumber != 0) ? 1 : -1;
+}
+
+/**< One index lookup per point. */
+void PreparedPolygon::classify(const Point *pts, size_t n, int8_t *out) const {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = static_cast<int8_t>(classify(pts[i]));
+}
@@ -0,0 +1,130 @@
+#ifndef POINT_IN_POLYGON_H
+#define POINT_IN_POLYGON_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief The edges of a polygon in structure of arrays layout, the form the
+ * batched winding number test streams through. Edge i runs from vertex i to
+ * vertex (i + 1) % n.
+ */
+struct EdgeTable {
+  std::vector<double> startX; /**< x of the first vertex. */
+  std::vector<double> startY; /**< y of the first vertex. */
+  std::vector<double> deltaX; /**< End x minus start x. */
+  std::vector<double> deltaY; /**< End y minus start y. */
+  std::vector<double> endX;   /**< x of the second vertex. */
+  std::vector<double> endY;   /**< y of the second vertex. */
+  std::vector<double> minX;   /**< Edge bounds widened by epsilon. */
+  std::vector<double> maxX;   /**< Edge bounds widened by epsilon. */
+  std::vector<double> minY;   /**< Edge bounds widened by epsilon. */
+  std::vector<double> maxY;   /**< Edge bounds widened by epsilon. */
+  BoundingBox vertexBounds;   /**< Bounds of the vertices. */
+  double maxDeltaX = 0.0;     /**< Largest absolute deltaX. */
+  double maxDeltaY = 0.0;     /**< Largest absolute deltaY. */
+
+  /**
+   * @brief Build the table for a ring of vertices.
+   *
+   * @param vertices Vertices of the polygon.
+   */
+  explicit EdgeTable(const PolygonView &vertices);
+
+  /**
+   * @brief Get the number of edges.
+   *
+   * @return Number of edges.
+   */
+  size_t size() const { return startX.size(); }
+};
+
+/**
+ * @brief Classify many points against one polygon with the winding number
+ * algorithm of is_point_inside_polygon, returning the same codes. Several
+ * points are tested per iteration with AVX2 or SSE2 when the CPU has them,
+ * the scalar loop handles the rest. Points for which the vector test cannot
+ * prove the sign of an edge test are classified again with the exact scalar
+ * test.
+ *
+ * @param edges Edge table of the polygon.
+ * @param points Points to classify.
+ * @param count Number of points.
+ * @param codes Output per point: 1 inside, 0 on the boundary, -1 outside.
+ */
+void classify_points(const EdgeTable &edges, const Point *points, size_t count,
+                     int8_t *codes);
+
+/**
+ * @brief A polygon prepared for many containment queries. The y range of the
+ * polygon is cut into as many slabs as it has edges and each slab lists the
+ * edges reaching into it, ordered from right to left. A query only walks the
+ * edges of its own slab up to the first one left of the point, so its cost
+ * is close to the number of edges around the point instead of all of them.
+ * The codes are those of is_point_inside_polygon.
+ */
+class PreparedPolygon {
+public:
+  /**
+   * @brief Build the index, in O(n log n) for a polygon whose edges are short
+   * compared to its height.
+   *
+   * @param polygon The polygon to prepare, its edge table is shared.
+   */
+  explicit PreparedPolygon(const Polygon &polygon);
+
+  /**
+   * @brief Build the index for a view, with an edge table of its own.
+   *
+   * @param polygon The polygon to prepare.
+   */
+  explicit PreparedPolygon(const PolygonView &polygon);
+
+  /**
+   * @brief Build the index over an existing edge table.
+   *
+   * @param shared Edges of the polygon.
+   */
+  explicit PreparedPolygon(std::shared_ptr<const EdgeTable> shared);
+
+  /**
+   * @brief Check if a point lies inside, on or outside the polygon.
+   *
+   * @param query Point to check.
+   *
+   * @return 1 inside, 0 on the boundary, -1 outside.
+   */
+  int classify(const Point &query) const;
+
+  /**
+   * @brief Classify many points, same codes as the single point version.
+   *
+   * @param pts Points to classify.
+   * @param n Number of points.
+   * @param out Output per point: 1 inside, 0 on the boundary, -1 outside.
+   */
+  void classify(const Point *pts, size_t n, int8_t *out) const;
+
+private:
+  std::shared_ptr<const EdgeTable> edges; /**< Edges of the polygon. */
+  BoundingBox bounds;              /**< Edge bounds, widened by epsilon. */
+  size_t slabCount = 0;            /**< Number of slabs. */
+  double inverseSlabHeight = 0.0;  /**< Slabs per unit of y. */
+  std::vector<uint32_t> slabStart; /**< Slab s owns [start[s], start[s+1]). */
+  std::vector<uint32_t> slabEdges; /**< Edge indices, slab after slab. */
+
+  /**
+   * @brief Find the slab of a y-coordinate.
+   *
+   * @param y The y-coordinate.
+   *
+   * @return Index of the slab, clamped to the slabs.
+   */
+  size_t slab_of(double y) const;
+};
+
+#endif // POINT_IN_POLYGON_H
@@ -0,0 +1,222 @@
+#include "point_order.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace { /**< Internal helper functions */
+
+/**< Below this size the keys are ordered with std::sort. */
+const size_t radix_sort_threshold = 1024;
+
+/**
+ * @brief Function to calculate the polar angle of a point with respect to the
+ * reference point.
+ *
+ * @param reference Reference point.
+ * @param point Point to calculate angle from.
+ *
+ * @return double angle in radians.
+ */
+inline double polar_angle(const Point &reference, const Point &point) {
+  return atan2(point.y - reference.y, point.x - reference.x);
+}
+
+/**
+ * @brief Function to check if point2 is more counterclockwise than point1 with
+ * respect to the reference point.
+ *
+ * @param reference Reference point.
+ * @param pointA Point A.
+ * @param pointB Point B.
+ *
+ * @return True if A is more CCW than B.
+ */
+bool compare_counter_clockwise(const Point &reference, const Point &pointA,
+                               const Point &pointB) {
+  double angleA = polar_angle(reference, pointA);
+  double angleB = polar_angle(reference, pointB);
+  return angleA > angleB;
+}
+
+/**< Average of the points. */
+Point centroid(const std::vector<Point> &points) {
+  Point reference;
+  for (const Point &point : points) {
+    reference.x += point.x;
+    reference.y += point.y;
+  }
+  reference.x /= points.size();
+  reference.y /= points.size();
+  return reference;
+}
+
+/**
+ * @brief Scalar pseudo angle, see compute_pseudo_angles.
+ */
+inline double pseudo_angle(double dx, double dy) {
+  const double sum = std::fabs(dx) + std::fabs(dy);
+  const double slope = (sum == 0.0) ? 0.0 * dy : dy / sum; /**< [-1, 1] */
+  if (!std::signbit(dx))
+    return slope; /**< Right half plane, [-pi/2, pi/2]. */
+  return (std::signbit(dy) ? -2.0 : 2.0) - slope; /**< Left half plane. */
+}
+
+/**
+ * @brief Map a double onto an unsigned integer with the same ordering.
+ */
+inline uint64_t orderable_bits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits & 0x8000000000000000ull) ? ~bits
+                                        : (bits | 0x8000000000000000ull);
+}
+
+/**
+ * @brief Stable LSD radix sort of (key, index) pairs by key, one byte per
+ * pass. Passes where every key has the same byte are skipped, which is most
+ * of the exponent bytes since the keys lie in [-2, 2].
+ *
+ * @param keys Keys, sorted on return.
+ * @param index Payload, permuted along with the keys.
+ */
+void radix_sort(std::vector<uint64_t> &keys, std::vector<uint32_t> &index) {
+  const size_t n = keys.size();
+  std::vector<size_t> counts(8 * 256, 0);
+  for (size_t i = 0; i < n; ++i)
+    for (int pass = 0; pass < 8; ++pass)
+      counts[pass * 256 + ((keys[i] >> (8 * pass)) & 0xff)]++;
+
+  std::vector<uint64_t> keyBuffer(n);
+  std::vector<uint32_t> indexBuffer(n);
+  for (int pass = 0; pass < 8; ++pass) {
+    size_t *count = &counts[pass * 256];
+    const int shift = 8 * pass;
+    if (count[(keys[0] >> shift) & 0xff] == n)
+      continue; /**< All keys share this byte. */
+
+    size_t offset = 0;
+    for (int bucket = 0; bucket < 256; ++bucket) {
+      const size_t size = count[bucket];
+      count[bucket] = offset;
+      offset += size;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      const size_t slot = count[(keys[i] >> shift) & 0xff]++;
+      keyBuffer[slot] = keys[i];
+      indexBuffer[slot] = index[i];
+    }
+    keys.swap(keyBuffer);
+    index.swap(indexBuffer);
+  }
+}
+} // namespace
+
+/**< Pseudo angles, two points per iteration with SSE2. */
+void compute_pseudo_angles(const Point *points, size_t count,
+                           const Point &reference, double *keys) {
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128d refX = _mm_set1_pd(reference.x);
+  const __m128d refY = _mm_set1_pd(reference.y);
+  const __m128d signMask = _mm_set1_pd(-0.0);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d two = _mm_set1_pd(2.0);
+
+  for (; i + 2 <= count; i += 2) {
+    const __m128d first = _mm_loadu_pd(&points[i].x);      /**< x0 y0 */
+    const __m128d second = _mm_loadu_pd(&points[i + 1].x); /**< x1 y1 */
+    const __m128d dx = _mm_sub_pd(_mm_unpacklo_pd(first, second), refX);
+    const __m128d dy = _mm_sub_pd(_mm_unpackhi_pd(first, second), refY);
+
+    const __m128d sum =
+        _mm_add_pd(_mm_andnot_pd(signMask, dx), _mm_andnot_pd(signMask, dy));
+    const __m128d empty = _mm_cmpeq_pd(sum, zero);
+    const __m128d slope =
+        _mm_or_pd(_mm_andnot_pd(empty, _mm_div_pd(dy, sum)),
+                  _mm_and_pd(empty, _mm_mul_pd(zero, dy)));
+
+    /**< All ones in lanes whose sign bit is set, -0.0 included. */
+    const __m128d dxNegative = _mm_castsi128_pd(_mm_shuffle_epi32(
+        _mm_srai_epi32(_mm_castpd_si128(dx), 31), _MM_SHUFFLE(3, 3, 1, 1)));
+    const __m128d dySign = _mm_and_pd(dy, signMask);
+    const __m128d left = _mm_sub_pd(_mm_or_pd(two, dySign), slope);
+
+    const __m128d key = _mm_or_pd(_mm_andnot_pd(dxNegative, slope),
+                                  _mm_and_pd(dxNegative, left));
+    _mm_storeu_pd(keys + i, key);
+  }
+#endif
+
+  for (; i < count; ++i)
+    keys[i] = pseudo_angle(points[i].x - reference.x,
+                           points[i].y - reference.y);
+}
+
+/**< Decreasing pseudo angle around the centroid. */
+void sort_by_polar_angle(std::vector<Point> &points) {
+  const size_t n = points.size();
+  const Point reference = centroid(points);
+
+  std::vector<double> angles(n);
+  compute_pseudo_angles(points.data(), n, reference, angles.data());
+
+  /**< Inverted so an ascending sort yields decreasing angles. */
+  std::vector<uint64_t> keys(n);
+  std::vector<uint32_t> index(n);
+  for (size_t i = 0; i < n; ++i) {
+    keys[i] = ~orderable_bits(angles[i]);
+    index[i] = i;
+  }
+
+  if (n < radix_sort_threshold) {
+    std::vector<std::pair<uint64_t, uint32_t>> pairs(n);
+    for (size_t i = 0; i < n; ++i)
+      pairs[i] = std::make_pair(keys[i], index[i]);
+    std::sort(pairs.begin(), pairs.end());
+    for (size_t i = 0; i < n; ++i)
+      index[i] = pairs[i].second;
+  } else {
+    radix_sort(keys, index);
+  }
+
+  std::vector<Point> sorted(n);
+  for (size_t i = 0; i < n; ++i)
+    sorted[i] = points[index[i]];
+  points.swap(sorted);
+}
+
+/**< Rotation instead of a sort, the keys are computed once. */
+void order_convex_ring_by_polar_angle(std::vector<Point> &ring) {
+  const size_t n = ring.size();
+  const Point reference = centroid(ring);
+
+  std::vector<double> angles(n);
+  compute_pseudo_angles(ring.data(), n, reference, angles.data());
+
+  size_t first = 0;
+  for (size_t i = 1; i < n; ++i)
+    if (orderable_bits(angles[i]) > orderable_bits(angles[first]))
+      first = i;
+
+  /**< Reversed the ring runs clockwise, first moves to n - 1 - first. */
+  std::reverse(ring.begin(), ring.end());
+  std::rotate(ring.begin(), ring.begin() + (n - 1 - first), ring.end());
+}
+
+/**< Sort the points based on polar angle wrt the centroid. */
+void sort_by_polar_angle_atan2(std::vector<Point> &points) {
+  const Point reference = centroid(points);
+  std::sort(points.begin(), points.end(),
+            [reference](const Point &p1, const Point &p2) {
+              return compare_counter_clockwise(reference, p1, p2);
+            });
+}
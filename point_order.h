@@ -0,0 +1,51 @@
+#ifndef POINT_ORDER_H
+#define POINT_ORDER_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Compute a pseudo angle for each point as seen from the reference
+ * point. The key is a monotone, trig free stand-in for
+ * atan2(point.y - reference.y, point.x - reference.x), mapping (-pi, pi] onto
+ * (-2, 2] with the same treatment of signed zeros. Uses SSE2 where available.
+ *
+ * @param points Points to compute keys for.
+ * @param count Number of points.
+ * @param reference Reference point, usually the centroid.
+ * @param keys Output, one key per point.
+ */
+void compute_pseudo_angles(const Point *points, size_t count,
+                           const Point &reference, double *keys);
+
+/**
+ * @brief Sort points by decreasing polar angle around their centroid, the
+ * order Polygon keeps its vertices in. Each key is computed once, large
+ * inputs are ordered with a radix sort over the keys. Points with equal
+ * angles keep their relative order.
+ *
+ * @param points Points to sort, at least three.
+ */
+void sort_by_polar_angle(std::vector<Point> &points);
+
+/**
+ * @brief Put a counter clockwise convex ring into the order of
+ * sort_by_polar_angle in O(n). Seen from the centroid of a convex ring the
+ * vertices already follow each other by angle, so it is enough to reverse
+ * the ring and start it at the largest pseudo angle.
+ *
+ * @param ring Vertices of the ring, at least three.
+ */
+void order_convex_ring_by_polar_angle(std::vector<Point> &ring);
+
+/**
+ * @brief Reference implementation of sort_by_polar_angle calling atan2 twice
+ * per comparison. Kept for cross-checking and benchmarking the kernel.
+ *
+ * @param points Points to sort, at least three.
+ */
+void sort_by_polar_angle_atan2(std::vector<Point> &points);
+
+#endif // POINT_ORDER_H
@@ -1,73 +1,428 @@
 #include "polygon.h"
+#include "convex.h"
+#include "edit_index.h"
 #include "external.h"
+#include "instrumentation.h"
+#include "multi_polygon.h"
+#include "point_in_polygon.h"
+#include "point_order.h"
+#include "polygon_io.h"
+#include "result_cache.h"
+#include "scratch.h"
+#include "simplify.h"
+#include "stats.h"
+#include "str_tree.h"
+#include "sweep_line.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cmath>
-#include <fstream>
+#include <exception>
 #include <iostream>
+#include <iterator>
+#include <memory_resource>
 #include <mutex>
-#include <set>
-#include <sstream>
 #include <thread>
 
 namespace { /**< Internal helper functions */
 
+/**< Relative area by which a hull may exceed the union of two convex
+ * polygons and still be taken as that union, covers the rounding of the
+ * shoelace sums. */
+const double convex_union_tolerance = 1e-9;
+
+/**< Entries per node of the tree the cascaded union follows. */
+const size_t cascade_node_capacity = 4;
+
+std::mutex parallelMutex;         /**< Guards parallelOptions. */
+ParallelOptions parallelOptions; /**< See Polygon::set_parallel_options. */
+
+std::mutex simplifyMutex;         /**< Guards simplifyOptions. */
+SimplifyOptions simplifyOptions; /**< See Polygon::set_simplify_options. */
+std::atomic<bool> simplifyEnabled{false}; /**< simplifyOptions.enabled. */
+
+std::mutex resultCacheMutex;           /**< Guards resultCacheOptions. */
+ResultCacheOptions resultCacheOptions; /**< See set_result_cache_options. */
+std::atomic<bool> resultCacheEnabled{false}; /**< Its enabled flag. */
+ResultCache resultCache; /**< Shared by all threads, see result_cache.h. */
+
+/**
+ * @brief Function to sort 2D points in ccw order.
+ *
+ * @param points Vector of points.
+ */
+void sort_points_counter_clockwise(std::vector<Point> &points) {
+  /**< Sorting is not meaningful for fewer than three points, empty results
+   * of the set operations get here all the time. */
+  if (points.size() < 3)
+    return;
+  POLYGON_TIMED_SPAN("sort", sortNanoseconds, sorts);
+
+  /**< Sort the points based on polar angle wrt the centroid.*/
+  sort_by_polar_angle(points);
+}
+
 /**
- * @brief Function to calculate the polar angle of a point with respect to the
- * reference point.
+ * @brief Read every polygon of a file, with one summary on stderr for its
+ * malformed lines.
  *
- * @param reference Reference point.
- * @param point Point to calculate angle from.
+ * @param filename The name of the file.
+ * @param rings Output, the vertices of each polygon.
  *
- * @return double angle in radians.
+ * @return True if the file could be opened.
  */
-inline double polar_angle(const Point &reference, const Point &point) {
-  return atan2(point.y - reference.y, point.x - reference.x);
+bool read_polygons_reporting(const std::string &filename,
+                             std::vector<std::vector<Point>> &rings) {
+  ReadReport report;
+  if (!read_polygons(filename, rings, report)) {
+    std::cerr << "Error opening file: " << filename << std::endl;
+    return false;
+  }
+
+  if (report.malformedCount > 0)
+    std::cerr << "Error parsing " << filename << ": " << report << std::endl;
+  return true;
+}
+
+/**< Grow a box by margin on every side. */
+BoundingBox widen(BoundingBox box, double margin) {
+  box.minX -= margin;
+  box.minY -= margin;
+  box.maxX += margin;
+  box.maxY += margin;
+  return box;
 }
 
 /**
- * @brief Function to check if point2 is more counterclockwise than point1 with
- * respect to the reference point.
+ * @brief Check if two polygons can share a point. Boxes further apart than
+ * epsilon leave no vertex of one on or in the other and no crossing edges.
  *
- * @param reference Reference point.
- * @param pointA Point A.
- * @param pointB Point B.
+ * @param A The first polygon.
+ * @param B The second polygon.
+ * @param stats Counts the operation and whether it was rejected.
  *
- * @return True if A is more CCW than B.
+ * @return False if the polygons are certainly disjoint.
  */
-bool compare_counter_clockwise(const Point &reference, const Point &pointA,
-                               const Point &pointB) {
-  double angleA = polar_angle(reference, pointA);
-  double angleB = polar_angle(reference, pointB);
-  return angleA > angleB;
+bool may_overlap(const PolygonView &A, const PolygonView &B,
+                 OperationStats &stats) {
+  stats.operations++;
+  if (widen(A.get_bounding_box(), epsilon).overlaps(B.get_bounding_box()))
+    return true;
+
+  stats.disjointOperations++;
+  return false;
 }
 
 /**
- * @brief Function to sort 2D points in ccw order.
+ * @brief Reduce polygons[first, last) in order, forking the left half onto
+ * the pool and doing the right half on the calling thread.
  *
- * @param points Vector of points.
+ * @param polygons Rings of the polygons to reduce, the range is consumed.
+ * @param work Prefix sums of the vertex counts.
+ * @param first First polygon of the range.
+ * @param last One past the last polygon of the range.
+ * @param op The specified operation.
+ * @param pool Pool the left halves run on.
+ * @param grainSize Ranges with fewer vertices are folded inline.
+ *
+ * @return The resulting rings.
  */
-void sort_points_counter_clockwise(std::vector<Point> &points) {
-  if (points.size() < 3) {
-    /**<  Sorting is not meaningful for fewer than three points. */
-    std::cout << "Not enough points to sort\n";
-    return;
+MultiPolygon reduce_range(std::vector<MultiPolygon> &polygons,
+                          const std::vector<size_t> &work, size_t first,
+                          size_t last, SetOperation op, ThreadPool &pool,
+                          size_t grainSize) {
+  if (last - first == 1)
+    return std::move(polygons[first]);
+
+  /**< Small ranges are folded in order without forking. */
+  if (work[last] - work[first] < grainSize) {
+    POLYGON_TIMED_SPAN("reduce fold", reduceNanoseconds, reduceTasks);
+    MultiPolygon result(std::move(polygons[first]));
+    for (size_t i = first + 1; i < last; ++i)
+      result = MultiPolygon::compute_operation(result, polygons[i], op);
+    return result;
+  }
+
+  const size_t middle = first + (last - first) / 2;
+  MultiPolygon left;
+  TaskGroup group(pool);
+  group.run([&]() {
+    left = reduce_range(polygons, work, first, middle, op, pool, grainSize);
+  });
+  const MultiPolygon right =
+      reduce_range(polygons, work, middle, last, op, pool, grainSize);
+  group.wait();
+
+  POLYGON_TIMED_SPAN("reduce merge", reduceNanoseconds, reduceTasks);
+  return MultiPolygon::compute_operation(left, right, op);
+}
+
+/**
+ * @brief Union polygons bottom up along an STR packed tree over their
+ * bounding boxes. Every node of a level is one task on the pool, unless the
+ * whole level is smaller than the grain size.
+ *
+ * @param polygons Rings of the polygons to unite, consumed.
+ * @param pool Pool the nodes run on.
+ * @param grainSize Levels with fewer vertices are done inline.
+ *
+ * @return The rings of the union.
+ */
+MultiPolygon cascaded_union(std::vector<MultiPolygon> polygons,
+                            ThreadPool &pool, size_t grainSize) {
+  if (polygons.empty())
+    return MultiPolygon();
+
+  /**< Boxes of the current level, a node covers the boxes of its children
+   * even where their union came out empty. */
+  std::vector<BoundingBox> boxes(polygons.size());
+  for (size_t i = 0; i < polygons.size(); ++i)
+    boxes[i] = polygons[i].get_bounding_box();
+
+  while (polygons.size() > 1) {
+    const std::vector<std::vector<size_t>> nodes =
+        str_pack(boxes, cascade_node_capacity);
+
+    size_t work = 0;
+    for (const MultiPolygon &polygon : polygons)
+      work += polygon.get_number_of_points();
+
+    std::vector<MultiPolygon> united(nodes.size());
+    std::vector<BoundingBox> unitedBoxes(nodes.size());
+    TaskGroup group(pool);
+    for (size_t k = 0; k < nodes.size(); ++k) {
+      unitedBoxes[k] = enclose(boxes, nodes[k]);
+      auto unite = [&polygons, &nodes, &united, k]() {
+        POLYGON_TIMED_SPAN("cascade node", reduceNanoseconds, reduceTasks);
+        const std::vector<size_t> &children = nodes[k];
+        MultiPolygon result(std::move(polygons[children.front()]));
+        for (size_t c = 1; c < children.size(); ++c)
+          result = MultiPolygon::compute_operation(
+              result, polygons[children[c]], SetOperation::Union);
+        united[k] = std::move(result);
+      };
+      if (work < grainSize)
+        unite();
+      else
+        group.run(unite);
+    }
+    group.wait();
+
+    polygons.swap(united);
+    boxes.swap(unitedBoxes);
+  }
+
+  return std::move(polygons.front());
+}
+
+/**
+ * @brief Pool for the configured thread count, the calling thread counts as
+ * one of the threads.
+ *
+ * @return The pool.
+ */
+std::shared_ptr<ThreadPool> parallel_pool(const ParallelOptions &options) {
+  unsigned int threads = options.threads;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  return shared_thread_pool(threads - 1);
+}
+
+/**< Pool for simplifying a ring, none when it fits in one chunk. */
+std::shared_ptr<ThreadPool> simplify_pool(size_t vertices) {
+  if (vertices < 2 * simplify_chunk_size)
+    return nullptr;
+  return parallel_pool(Polygon::get_parallel_options());
+}
+
+/**
+ * @brief Run a set operation through the result cache if it is enabled.
+ *
+ * @param A The first polygon.
+ * @param B The second polygon.
+ * @param op The operation compute runs.
+ * @param compute Computes the result on a miss.
+ *
+ * @return The resulting rings.
+ */
+template <typename Compute>
+MultiPolygon cached_operation(const Polygon &A, const Polygon &B,
+                              SetOperation op, Compute compute) {
+  if (!resultCacheEnabled.load(std::memory_order_relaxed))
+    return compute();
+
+  const ResultCache::Key key{A.get_content_hash(), B.get_content_hash(),
+                             A.get_number_of_points(),
+                             B.get_number_of_points(), op};
+  OperationStats stats;
+  if (const std::shared_ptr<const MultiPolygon> hit =
+          resultCache.find(key, PolygonView(A), PolygonView(B))) {
+    stats.cacheHits++;
+    record_operation_stats(stats);
+    return *hit;
+  }
+
+  MultiPolygon result = compute();
+  stats.cacheMisses++;
+  stats.cacheEvictions +=
+      resultCache.insert(key, PolygonView(A), PolygonView(B),
+                         std::make_shared<const MultiPolygon>(result));
+  record_operation_stats(stats);
+  return result;
+}
+
+/**< The only ring of a result, empty for none or several. */
+Polygon single_ring(const MultiPolygon &rings) {
+  if (rings.ring_count() != 1)
+    return Polygon();
+  const PolygonView ring = rings.ring(0);
+  return Polygon::from_ring(std::vector<Point>(ring.begin(), ring.end()));
+}
+
+/**< True if two settings simplify a ring alike. */
+bool same_simplification(const SimplifyOptions &a, const SimplifyOptions &b) {
+  return a.tolerance == b.tolerance && a.method == b.method &&
+         a.preserveTopology == b.preserveTopology;
+}
+
+/**
+ * @brief Union of two overlapping convex rings in O(n + m). It is the merged
+ * hull of the rings whenever the hull is no larger than the union, that is
+ * area(A) + area(B) - area(A and B), with the overlap taken from the linear
+ * intersection walk.
+ *
+ * @param A The first ring.
+ * @param areaA Its area.
+ * @param B The second ring.
+ * @param areaB Its area.
+ * @param points Output, the hull in ring order.
+ * @param memory Scratch memory of the operation.
+ *
+ * @return False if the union is not convex or the walk gave up, the general
+ * path has to run then.
+ */
+bool convex_union(const PolygonView &A, double areaA, const PolygonView &B,
+                  double areaB, std::vector<Point> &points,
+                  std::pmr::memory_resource *memory) {
+  std::pmr::vector<Point> overlap(memory);
+  if (!convex_intersection(A, B, overlap) || overlap.empty())
+    return false; /**< Apart, the union is two rings. */
+
+  std::pmr::vector<Point> hull(memory);
+  convex_hull_merge(A, B, hull);
+  const double hullArea =
+      ring_area(PolygonView(hull.data(), hull.size(), BoundingBox()));
+  const double unionArea =
+      areaA + areaB -
+      ring_area(PolygonView(overlap.data(), overlap.size(), BoundingBox()));
+  if (hullArea - unionArea > convex_union_tolerance * hullArea)
+    return false; /**< The hull bridges a notch between the rings. */
+
+  points.assign(hull.begin(), hull.end());
+  return true;
+}
+
+/**< Counter clockwise from the smallest vertex, as the sweep links its
+ * rings, whichever way the operands of a convex shortcut ran. */
+void orient_like_sweep(std::vector<Point> &ring) {
+  double twiceArea = 0.0;
+  for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+    twiceArea += ring[j].x * ring[i].y - ring[i].x * ring[j].y;
+  if (twiceArea < 0.0)
+    std::reverse(ring.begin(), ring.end());
+  std::rotate(ring.begin(), std::min_element(ring.begin(), ring.end()),
+              ring.end());
+}
+
+/**
+ * @brief The jobs of a compute_batch call, handed out one at a time with the
+ * largest first.
+ */
+class BatchQueue {
+public:
+  /**< Copies the requests and orders them by decreasing vertex count. */
+  BatchQueue(const OperationRequest *requests, size_t count)
+      : requests(requests, requests + count), order(count) {
+    std::vector<size_t> work(count);
+    for (size_t i = 0; i < count; ++i) {
+      order[i] = i;
+      work[i] = requests[i].A->get_number_of_points() +
+                requests[i].B->get_number_of_points();
+    }
+    std::stable_sort(order.begin(), order.end(), [&work](size_t a, size_t b) {
+      return work[a] > work[b];
+    });
   }
 
-  /**<  Find the centroid. */
-  Point reference;
-  for (const Point &point : points) {
-    reference.x += point.x;
-    reference.y += point.y;
+  /**< Number of jobs. */
+  size_t size() const { return order.size(); }
+
+  /**< Take the next job, false once all are taken. */
+  bool take(size_t &index) {
+    const size_t k = next.fetch_add(1, std::memory_order_relaxed);
+    if (k >= order.size())
+      return false;
+    index = order[k];
+    return true;
+  }
+
+  /**< Run job index. */
+  Polygon run(size_t index) const {
+    const OperationRequest &request = requests[index];
+    return Polygon::compute_operation(*request.A, *request.B, request.op);
+  }
+
+private:
+  std::vector<OperationRequest> requests; /**< The jobs. */
+  std::vector<size_t> order;              /**< Job indices, largest first. */
+  std::atomic<size_t> next{0};            /**< Position in order. */
+};
+
+/**
+ * @brief A batch running on the pool without a waiting caller. Each pool
+ * task drains the queue, the thread finishing the last job calls done.
+ */
+struct AsyncBatch {
+  BatchQueue queue;                   /**< The jobs. */
+  std::atomic<size_t> remaining;      /**< Jobs not yet finished. */
+  std::function<void(size_t)> runJob; /**< Runs one job, must not throw. */
+  std::function<void()> done;         /**< Called after the last job. */
+  std::shared_ptr<ThreadPool> pool;   /**< Runs the tasks, held until done,
+                                         the thread count may change
+                                         meanwhile. */
+
+  AsyncBatch(const OperationRequest *requests, size_t count)
+      : queue(requests, count), remaining(count) {}
+};
+
+/**< Start the tasks of an asynchronous batch on the configured pool. */
+void launch_batch(const std::shared_ptr<AsyncBatch> &batch) {
+  if (batch->queue.size() == 0) {
+    batch->done();
+    return;
   }
-  reference.x /= points.size();
-  reference.y /= points.size();
 
-  /**< Sort the points based on polar angle wrt the reference point.*/
-  std::sort(points.begin(), points.end(),
-            [reference](const Point &p1, const Point &p2) {
-              return compare_counter_clockwise(reference, p1, p2);
-            });
+  auto drain = [batch]() {
+    size_t index;
+    while (batch->queue.take(index)) {
+      batch->runJob(index);
+      if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        batch->done();
+        batch->pool.reset();
+      }
+    }
+  };
+
+  /**< A local copy, the last job may finish before the tasks are queued. */
+  const std::shared_ptr<ThreadPool> pool = batch->pool =
+      parallel_pool(Polygon::get_parallel_options());
+  if (pool->size() == 0) {
+    drain(); /**< Nobody else would run the tasks. */
+    return;
+  }
+  const size_t tasks = std::min<size_t>(pool->size(), batch->queue.size());
+  for (size_t t = 0; t < tasks; ++t)
+    pool->submit(drain);
 }
 } // namespace
 
@@ -79,6 +434,12 @@ bool Point::operator<(const Point &other) const {
   return x < other.x;
 }
 
+/**< Boxes overlap unless separated along one of the axes. */
+bool BoundingBox::overlaps(const BoundingBox &other) const {
+  return (minX <= other.maxX) && (other.minX <= maxX) &&
+         (minY <= other.maxY) && (other.minY <= maxY);
+}
+
 /**< Default constructor. */
 Polygon::Polygon() {}
 
@@ -88,12 +449,29 @@ Polygon::Polygon(const std::vector<Point> &input) : points(input) {
   sort_points_counter_clockwise(points);
 }
 
-/**< Copy constructor */
-Polygon::Polygon(const Polygon &other) : points(other.points) {
+/**< Parameterized constructor reusing the input storage. */
+Polygon::Polygon(std::vector<Point> &&input) : points(std::move(input)) {
   /**< some algorithms need the points sorted in ccw order. */
   sort_points_counter_clockwise(points);
 }
 
+/**< Takes the ring as it is. */
+Polygon Polygon::from_ring(std::vector<Point> ring) {
+  Polygon polygon;
+  polygon.points = std::move(ring);
+  return polygon;
+}
+
+/**< Copy constructor, the source is already sorted. */
+Polygon::Polygon(const Polygon &other) : points(other.points) {
+  copy_cache(other);
+}
+
+/**< Move constructor */
+Polygon::Polygon(Polygon &&other) noexcept : points(std::move(other.points)) {
+  take_cache(other);
+}
+
 /**< Destructor. */
 Polygon::~Polygon() { points.clear(); }
 
@@ -121,270 +499,925 @@ Polygon &Polygon::operator=(const Polygon &other) {
   /**<  Check for self-assignment. */
   if (this != &other) {
     this->points.assign(other.points.begin(), other.points.end());
+    copy_cache(other);
   }
   return *this;
 }
 
+/**<  Move assignment. */
+Polygon &Polygon::operator=(Polygon &&other) noexcept {
+  if (this != &other) {
+    this->points = std::move(other.points);
+    take_cache(other);
+  }
+  return *this;
+}
+
+/**<  Forget everything derived from the old points. */
+void Polygon::invalidate_cache() {
+  cacheFlags.store(0, std::memory_order_release);
+  editIndex.reset();
+}
+
+/**<  Take over the cache of a polygon with the same points. */
+void Polygon::copy_cache(const Polygon &other) {
+  std::lock_guard<std::mutex> lock(other.cacheMutex);
+  const unsigned int flags = other.cacheFlags.load(std::memory_order_relaxed);
+
+  valid = other.valid;
+  bounds = other.bounds;
+  signedArea = other.signedArea;
+  convex = other.convex;
+  edgeTable = other.edgeTable;
+  prepared = other.prepared;
+  simplified = other.simplified;
+  simplifiedWith = other.simplifiedWith;
+  contentHash = other.contentHash;
+  editIndex.reset();
+  cacheFlags.store(flags, std::memory_order_release);
+}
+
+/**<  Take over the cache of a polygon whose points were moved here. No other
+ * thread may use a polygon that is being moved from, so no locking. */
+void Polygon::take_cache(Polygon &other) {
+  valid = other.valid;
+  bounds = other.bounds;
+  signedArea = other.signedArea;
+  convex = other.convex;
+  edgeTable = std::move(other.edgeTable);
+  prepared = std::move(other.prepared);
+  simplified = std::move(other.simplified);
+  simplifiedWith = other.simplifiedWith;
+  contentHash = other.contentHash;
+  editIndex = std::move(other.editIndex);
+  cacheFlags.store(other.cacheFlags.load(std::memory_order_relaxed),
+                   std::memory_order_release);
+  other.invalidate_cache();
+}
+
+/**<  Bounds and area in a single pass over the points, then convexity. */
+void Polygon::update_geometry() const {
+  if (cacheFlags.load(std::memory_order_acquire) & GeometryCached)
+    return;
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (cacheFlags.load(std::memory_order_relaxed) & GeometryCached)
+    return;
+
+  BoundingBox box;
+  double area = 0.0;
+  if (!points.empty()) {
+    box.minX = box.maxX = points.front().x;
+    box.minY = box.maxY = points.front().y;
+  }
+
+  const size_t n = points.size();
+  for (size_t i = 0; i < n; ++i) {
+    const Point &current = points[i];
+    const Point &next = points[(i + 1) % n];
+
+    box.minX = std::min(box.minX, current.x);
+    box.maxX = std::max(box.maxX, current.x);
+    box.minY = std::min(box.minY, current.y);
+    box.maxY = std::max(box.maxY, current.y);
+    area += current.x * next.y - next.x * current.y;
+  }
+
+  bounds = box;
+  signedArea = area / 2.0;
+  convex = is_convex_ring(PolygonView(points.data(), n, box));
+  cacheFlags.fetch_or(GeometryCached | ConvexCached, std::memory_order_release);
+}
+
 /**<  Returns number of vertices.*/
 unsigned int Polygon::get_number_of_points() const { return points.size(); }
 
-/**<  Sanity Checks.*/
+/**<  Sanity Checks, cached until the points change.*/
 bool Polygon::is_valid() const {
+  POLYGON_COUNT(validityChecks, 1);
+  if (cacheFlags.load(std::memory_order_acquire) & ValidityCached)
+    return valid;
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (!(cacheFlags.load(std::memory_order_relaxed) & ValidityCached)) {
+    /**<  Check for self intersecting polygon.*/
+    POLYGON_COUNT(validityComputed, 1);
+    POLYGON_SPAN("is_valid");
+    valid = (points.size() >= 3) && !has_self_intersection(points);
+    cacheFlags.fetch_or(ValidityCached, std::memory_order_release);
+  }
+  return valid;
+}
+
+/**<  Sanity Checks with the quadratic edge loop.*/
+bool Polygon::is_valid_brute_force() const {
   if (points.size() < 3)
     return false;
 
-  /**<  Check for self intersecting polygon.*/
-  for (size_t i = 0; i < points.size(); i++) {
-    for (size_t j = 0; j < points.size(); j++) {
-      if ((i != j) && ((i + 1) % points.size() != j) &&
-          ((j + 1) % points.size() != i)) {
-        Point intersection;
-        if (do_lines_intersect(points[i], points[(i + 1) % points.size()],
-                               points[j], points[(j + 1) % points.size()],
-                               intersection))
-          return false;
-      }
-    }
+  return !has_self_intersection_brute_force(points);
+}
+
+/**<  Cached bounding box. */
+BoundingBox Polygon::get_bounding_box() const {
+  update_geometry();
+  return bounds;
+}
+
+/**<  Cached signed area. */
+double Polygon::get_signed_area() const {
+  update_geometry();
+  return signedArea;
+}
+
+/**<  Orientation follows from the sign of the area. */
+bool Polygon::is_counter_clockwise() const { return get_signed_area() > 0.0; }
+
+/**<  Cached convexity, left to compute by the edits. */
+bool Polygon::is_convex() const {
+  update_geometry();
+  if (cacheFlags.load(std::memory_order_acquire) & ConvexCached)
+    return convex;
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (!(cacheFlags.load(std::memory_order_relaxed) & ConvexCached)) {
+    convex = is_convex_ring(PolygonView(points.data(), points.size(), bounds));
+    cacheFlags.fetch_or(ConvexCached, std::memory_order_release);
+  }
+  return convex;
+}
+
+/**<  Cached edge table for batched point queries. */
+std::shared_ptr<const EdgeTable> Polygon::get_edge_table() const {
+  if (cacheFlags.load(std::memory_order_acquire) & EdgesCached)
+    return edgeTable;
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (!(cacheFlags.load(std::memory_order_relaxed) & EdgesCached)) {
+    edgeTable = std::make_shared<EdgeTable>(points);
+    cacheFlags.fetch_or(EdgesCached, std::memory_order_release);
+  }
+  return edgeTable;
+}
+
+/**<  Batched winding number test. */
+void Polygon::classify(const Point *pts, size_t n, int8_t *out) const {
+  const std::shared_ptr<const EdgeTable> edges = get_edge_table();
+  classify_points(*edges, pts, n, out);
+}
+
+/**<  Cached containment index, built outside the lock from the edges. */
+std::shared_ptr<const PreparedPolygon> Polygon::get_prepared() const {
+  if (cacheFlags.load(std::memory_order_acquire) & PreparedCached)
+    return prepared;
+
+  std::shared_ptr<const PreparedPolygon> index =
+      std::make_shared<PreparedPolygon>(*this);
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (!(cacheFlags.load(std::memory_order_relaxed) & PreparedCached)) {
+    prepared = std::move(index);
+    cacheFlags.fetch_or(PreparedCached, std::memory_order_release);
+  }
+  return prepared;
+}
+
+/**<  Cached per setting, only the last setting is kept. */
+std::shared_ptr<const Polygon>
+Polygon::get_simplified(const SimplifyOptions &options) const {
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if ((cacheFlags.load(std::memory_order_relaxed) & SimplifiedCached) &&
+        same_simplification(simplifiedWith, options))
+      return simplified;
+  }
+
+  size_t removed = 0;
+  Polygon thinned = simplify(options, &removed);
+  std::shared_ptr<const Polygon> result;
+  if (removed > 0)
+    result = std::make_shared<const Polygon>(std::move(thinned));
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  simplified = result;
+  simplifiedWith = options;
+  cacheFlags.fetch_or(SimplifiedCached, std::memory_order_release);
+  return result;
+}
+
+/**<  Simplified copy, in the order of the points. */
+Polygon Polygon::simplify(const SimplifyOptions &options,
+                          size_t *removed) const {
+  POLYGON_SPAN("simplify");
+  const std::shared_ptr<ThreadPool> pool = simplify_pool(points.size());
+  std::vector<Point> ring;
+  const size_t count = simplify_ring(*this, options, pool.get(), ring);
+  if (removed)
+    *removed = count;
+  return from_ring(std::move(ring));
+}
+
+/**<  Cached content hash. */
+ContentHash Polygon::get_content_hash() const {
+  if (cacheFlags.load(std::memory_order_acquire) & HashCached)
+    return contentHash;
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (!(cacheFlags.load(std::memory_order_relaxed) & HashCached)) {
+    contentHash = hash_points(points.data(), points.size());
+    cacheFlags.fetch_or(HashCached, std::memory_order_release);
+  }
+  return contentHash;
+}
+
+/**<  Edits of a ring too small to index start over. */
+bool Polygon::insert_vertex(size_t index, const Point &point) {
+  if (index > points.size())
+    return false;
+
+  if (points.size() < 3) {
+    points.insert(points.begin() + index, point);
+    invalidate_cache();
+    return true;
   }
 
+  EditIndex &edits = edit_index();
+  points.insert(points.begin() + index, point);
+  edits.insert(points, index);
+  cache_edit();
   return true;
 }
 
-/**<  Reads a polygon from file.*/
-bool Polygon::read_file(const std::string &filename) {
-  points.clear();
-  std::ifstream inputFile(filename);
+/**<  Moves within the ring, the vertex keeps its place. */
+bool Polygon::move_vertex(size_t index, const Point &point) {
+  if (index >= points.size())
+    return false;
 
-  if (!inputFile.is_open()) {
-    std::cerr << "Error opening file: " << filename << std::endl;
-    return false; /**< Return an empty vector on error. */
+  if (points.size() < 3) {
+    points[index] = point;
+    invalidate_cache();
+    return true;
   }
 
-  /**< Read each line from the file */
-  std::string line;
-  Point temp;
-  while (std::getline(inputFile, line)) {
-    std::istringstream iss(line);
+  EditIndex &edits = edit_index();
+  const Point from = points[index];
+  points[index] = point;
+  edits.move(points, index, from);
+  cache_edit();
+  return true;
+}
 
-    /**< Parse x and y values from the line */
-    if (iss >> temp.x >> temp.y) {
-      points.emplace_back(temp);
-    } else {
-      std::cerr << "Error parsing line: " << line << std::endl;
-    }
+/**<  A ring shrinking below three vertices drops the index. */
+bool Polygon::remove_vertex(size_t index) {
+  if (index >= points.size())
+    return false;
+
+  if (points.size() <= 3) {
+    points.erase(points.begin() + index);
+    invalidate_cache();
+    return true;
   }
 
-  inputFile.close();
+  EditIndex &edits = edit_index();
+  const Point removed = points[index];
+  points.erase(points.begin() + index);
+  edits.remove(points, index, removed);
+  cache_edit();
+  return true;
+}
+
+/**<  Built once, edits keep it up to date. */
+EditIndex &Polygon::edit_index() {
+  if (!editIndex) {
+    POLYGON_SPAN("edit index");
+    editIndex = std::make_unique<EditIndex>(points);
+  }
+  return *editIndex;
+}
+
+/**<  No other thread may use a polygon being edited, so no locking. */
+void Polygon::cache_edit() {
+  valid = editIndex->is_simple();
+  bounds = editIndex->get_bounding_box();
+  signedArea = editIndex->get_signed_area();
+  edgeTable.reset();
+  prepared.reset();
+  simplified.reset();
+  cacheFlags.store(ValidityCached | GeometryCached, std::memory_order_release);
+}
+
+/**<  Reads a polygon from file.*/
+bool Polygon::read_file(const std::string &filename) {
+  points.clear();
+  invalidate_cache();
+
+  std::vector<std::vector<Point>> rings;
+  if (!read_polygons_reporting(filename, rings))
+    return false;
+
+  if (rings.size() > 1)
+    std::cerr << filename << " holds " << rings.size()
+              << " polygons, only the first is loaded" << std::endl;
+  if (!rings.empty())
+    points = std::move(rings.front());
+
   /**< some algorithms need the points sorted in ccw order */
   sort_points_counter_clockwise(points);
   return true;
 }
 
+/**<  Reads all polygons of a file.*/
+bool Polygon::read_file(const std::string &filename,
+                        std::vector<Polygon> &polygons) {
+  polygons.clear();
+
+  std::vector<std::vector<Point>> rings;
+  if (!read_polygons_reporting(filename, rings))
+    return false;
+
+  polygons.reserve(rings.size());
+  for (auto &ring : rings)
+    polygons.emplace_back(std::move(ring));
+  return true;
+}
+
 /**<  Writes a polygon to file.*/
-bool Polygon::write_file(const std::string &filename) {
-  /**< Open the file for writing. */
-  std::ofstream outputFile(filename);
-  if (!outputFile.is_open()) {
+bool Polygon::write_file(const std::string &filename) const {
+  if (!write_polygons(filename, {PolygonView(*this)})) {
     std::cerr << "Error opening file for writing: " << filename << std::endl;
     return false;
   }
+  return true;
+}
 
-  /**< Write polygon coordinates. */
-  for (size_t i = 0; i < points.size(); ++i) {
-    outputFile << points[i].x << " " << points[i].y << std::endl;
-  }
+/**<  Writes several polygons to one file.*/
+bool Polygon::write_file(const std::string &filename,
+                         const std::vector<Polygon> &polygons) {
+  const std::vector<PolygonView> rings(polygons.begin(), polygons.end());
 
-  outputFile.close();
-  std::cout << "Polygon written to file: " << filename << std::endl;
+  if (!write_polygons(filename, rings)) {
+    std::cerr << "Error opening file for writing: " << filename << std::endl;
+    return false;
+  }
   return true;
 }
 
-/**< Implementation of the << operator. */
+/**< Implementation of the << operator, formatted into one buffer. */
 std::ostream &operator<<(std::ostream &os, const Polygon &polygon) {
-  os << "Polygon coordinates:" << std::endl;
+  std::string text = "Polygon coordinates:\n";
   for (size_t i = 0; i < polygon.points.size(); ++i) {
-    os << "(" << polygon.points[i].x << "," << polygon.points[i].y << ")"
-       << (i + 1 == polygon.points.size() ? "\n" : ",");
+    text.push_back('(');
+    format_double(text, polygon.points[i].x);
+    text.push_back(',');
+    format_double(text, polygon.points[i].y);
+    text.push_back(')');
+    text.push_back(i + 1 == polygon.points.size() ? '\n' : ',');
   }
-  return os;
+  return os.write(text.data(), text.size());
 }
 
-/**< Calculates the union of 2 polygons uses the algo described on
- * https://stackoverflow.com/questions/7915734/intersection-and-union-of-polygons
- */
-Polygon Polygon::compute_union(Polygon A, Polygon B) {
-  Polygon result;
-
-  if (A.is_valid() && B.is_valid()) {
-    std::set<Point> vertexSet;
-    vertexSet.insert(A.points.begin(), A.points.end());
-    vertexSet.insert(B.points.begin(), B.points.end());
-
-    Point intersection;
-
-    /**< add all interesection points of edges. */
-    for (int i = 0; i < A.points.size(); i++) {
-      for (int j = 0; j < B.points.size(); j++) {
-        if (do_lines_intersect(A.points[i], A.points[(i + 1) % A.points.size()],
-                               B.points[j], B.points[(j + 1) % B.points.size()],
-                               intersection)) {
-          vertexSet.insert(intersection);
-        }
-      }
+/**< The caches of the owning polygon when there is one, else built on the
+ * first query and dropped with the operand. */
+struct Polygon::Operand {
+  PolygonView ring;               /**< Vertices and bounds. */
+  const Polygon *owner = nullptr; /**< Polygon the ring belongs to, if any. */
+  std::shared_ptr<const Polygon> simplified; /**< Owns the simplified ring. */
+  size_t simplifiedFrom = 0; /**< Vertices before, 0 if not simplified. */
+
+  /**< The polygon, or its cached simplification if that is enabled. */
+  Operand(const Polygon &polygon) : ring(polygon), owner(&polygon) {
+    if (!simplifyEnabled.load(std::memory_order_relaxed) ||
+        !polygon.is_valid())
+      return;
+
+    simplifiedFrom = polygon.points.size();
+    simplified = polygon.get_simplified(get_simplify_options());
+    if (simplified) {
+      ring = PolygonView(*simplified);
+      owner = simplified.get();
     }
+  }
 
-    /**< remove internal points from resultant set. */
-    for (auto &p : vertexSet) {
-      if (!((is_point_inside_polygon(p, A.points) == 1) ||
-            (is_point_inside_polygon(p, B.points) == 1))) {
-        result.points.emplace_back(p);
-      }
+  /**< The view, or a simplified copy if that is enabled. */
+  Operand(const PolygonView &view) : ring(view) {
+    if (!simplifyEnabled.load(std::memory_order_relaxed) || !view.is_valid())
+      return;
+
+    simplifiedFrom = view.size();
+    std::vector<Point> thinned;
+    const std::shared_ptr<ThreadPool> pool = simplify_pool(view.size());
+    if (simplify_ring(view, get_simplify_options(), pool.get(), thinned) > 0) {
+      simplified = std::make_shared<const Polygon>(
+          Polygon::from_ring(std::move(thinned)));
+      ring = PolygonView(*simplified);
+      owner = simplified.get();
     }
+  }
 
-    sort_points_counter_clockwise(result.points);
+  /**< Count the vertices the simplification removed. */
+  void count_simplified(OperationStats &stats) const {
+    stats.simplifiedVertices += simplifiedFrom;
+    if (simplifiedFrom > 0)
+      stats.verticesRemoved += simplifiedFrom - ring.size();
   }
 
-  return result;
+  /**< Cached for polygons, computed for views. */
+  bool is_valid() const { return owner ? owner->is_valid() : ring.is_valid(); }
+
+  /**< Cached for polygons, computed for views. */
+  bool is_convex() const {
+    return owner ? owner->is_convex() : is_convex_ring(ring);
+  }
+
+  /**< Cached for polygons, computed for views. */
+  double area() const {
+    return owner ? std::abs(owner->get_signed_area()) : ring_area(ring);
+  }
+};
+
+/**< The single ring of the cached sweep. */
+Polygon Polygon::compute_union(const Polygon &A, const Polygon &B,
+                               ScratchContext *scratch) {
+  return single_ring(compute_boolean(A, B, SetOperation::Union, scratch));
 }
 
-/**< calculate the intersection of 2 polygons, Inspired by the function above.
- */
-Polygon Polygon::compute_intersection(Polygon A, Polygon B) {
-  Polygon result;
-
-  if (A.is_valid() && B.is_valid()) {
-    std::set<Point> vertexSet;
-    Point intersection;
-
-    for (auto &pa : A.points)
-      if (is_point_inside_polygon(pa, B.points) >= 0)
-        vertexSet.insert(pa);
-
-    for (auto &pb : B.points)
-      if (is_point_inside_polygon(pb, A.points) >= 0)
-        vertexSet.insert(pb);
-
-    /**< add all interesection points of edges. */
-    for (int i = 0; i < A.points.size(); i++) {
-      for (int j = 0; j < B.points.size(); j++) {
-        if (do_lines_intersect(A.points[i], A.points[(i + 1) % A.points.size()],
-                               B.points[j], B.points[(j + 1) % B.points.size()],
-                               intersection)) {
-          vertexSet.insert(intersection);
-        }
-      }
-    }
+/**< Same as above on borrowed vertices. */
+Polygon Polygon::compute_union(const PolygonView &A, const PolygonView &B,
+                               ScratchContext *scratch) {
+  return single_ring(compute_boolean(A, B, SetOperation::Union, scratch));
+}
 
-    /**< remove external points from resultant set. */
-    for (auto &p : vertexSet) {
-      if (!((is_point_inside_polygon(p, A.points) == -1) ||
-            (is_point_inside_polygon(p, B.points) == -1)))
-        result.points.emplace_back(p);
-    }
+/**< The single ring of the cached sweep. */
+Polygon Polygon::compute_intersection(const Polygon &A, const Polygon &B,
+                                      ScratchContext *scratch) {
+  return single_ring(
+      compute_boolean(A, B, SetOperation::Intersection, scratch));
+}
 
-    sort_points_counter_clockwise(result.points);
-  }
+/**< Same as above on borrowed vertices. */
+Polygon Polygon::compute_intersection(const PolygonView &A,
+                                      const PolygonView &B,
+                                      ScratchContext *scratch) {
+  return single_ring(
+      compute_boolean(A, B, SetOperation::Intersection, scratch));
+}
 
-  return result;
+/**< The single ring of the cached sweep. */
+Polygon Polygon::compute_subtraction(const Polygon &A, const Polygon &B,
+                                     ScratchContext *scratch) {
+  return single_ring(compute_boolean(A, B, SetOperation::Difference, scratch));
 }
 
-/**< Calculates the subtraction of 2 polygons A-B. */
-Polygon Polygon::compute_subtraction(Polygon A, Polygon B) {
-  Polygon result;
+/**< Same as above on borrowed vertices. */
+Polygon Polygon::compute_subtraction(const PolygonView &A,
+                                     const PolygonView &B,
+                                     ScratchContext *scratch) {
+  return single_ring(compute_boolean(A, B, SetOperation::Difference, scratch));
+}
 
-  if (A.is_valid() && B.is_valid()) {
-    std::set<Point> vertexSet;
-    vertexSet.insert(A.points.begin(), A.points.end());
-    Point intersection;
+/**< Shortcuts first, the sweep for everything they cannot settle. */
+MultiPolygon Polygon::operation_of(const Operand &A, const Operand &B,
+                                   SetOperation op, ScratchContext *scratch) {
+  POLYGON_SPAN("set operation");
+  if (!A.is_valid() || !B.is_valid())
+    return MultiPolygon();
 
-    /**< add points of B that lie in A. */
-    for (auto &p : B.points) {
-      if (is_point_inside_polygon(p, A.points) == 1)
-        result.points.emplace_back(p);
+  OperationStats stats;
+  A.count_simplified(stats);
+  B.count_simplified(stats);
+  MultiPolygon result;
+  const bool overlap = may_overlap(A.ring, B.ring, stats);
+  if (!overlap && op == SetOperation::Intersection) {
+    /**< Disjoint polygons share no point, the result stays empty. */
+  } else if (overlap && A.is_convex() && B.is_convex() &&
+             (op == SetOperation::Intersection ||
+              op == SetOperation::Union)) {
+    ScratchScope scope(scratch);
+    std::pmr::memory_resource *memory = scope.resource();
+    std::vector<Point> ring;
+    bool settled = false;
+    if (op == SetOperation::Intersection) {
+      /**< Linear walk along both rings, the result comes out in order. */
+      std::pmr::vector<Point> vertices(memory);
+      settled = convex_intersection(A.ring, B.ring, vertices);
+      if (settled && vertices.size() >= 3)
+        ring.assign(vertices.begin(), vertices.end());
+    } else {
+      /**< Linear hull of both rings, the result comes out in order. */
+      settled = convex_union(A.ring, A.area(), B.ring, B.area(), ring, memory);
     }
-
-    /**< add all interesection points of edges. */
-    for (int i = 0; i < A.points.size(); i++) {
-      for (int j = 0; j < B.points.size(); j++) {
-        if (do_lines_intersect(A.points[i], A.points[(i + 1) % A.points.size()],
-                               B.points[j], B.points[(j + 1) % B.points.size()],
-                               intersection)) {
-          vertexSet.insert(intersection);
-        }
+    if (settled) {
+      stats.convexOperations++;
+      if (!ring.empty()) {
+        orient_like_sweep(ring);
+        result = MultiPolygon(Polygon::from_ring(std::move(ring)));
       }
+    } else {
+      result = MultiPolygon::compute_operation({A.ring}, {B.ring}, op);
     }
+  } else {
+    /**< Disjoint rings still go through the sweep, which orients them. */
+    result = MultiPolygon::compute_operation({A.ring}, {B.ring}, op);
+  }
+  record_operation_stats(stats);
+  return result;
+}
 
-    /**< remove points that lie in B from resultant set. */
-    for (auto &p : vertexSet) {
-      if (!(is_point_inside_polygon(p, B.points) == 1))
-        result.points.emplace_back(p);
-    }
+/**< Dispatches a single set operation. */
+Polygon Polygon::compute_operation(const Polygon &A, const Polygon &B,
+                                   SetOperation op, ScratchContext *scratch) {
+  switch (op) {
+  case SetOperation::Union:
+    return compute_union(A, B, scratch);
+  case SetOperation::Intersection:
+    return compute_intersection(A, B, scratch);
+  case SetOperation::Difference:
+    return compute_subtraction(A, B, scratch);
+  case SetOperation::Xor: /**< Several rings in general, see compute_boolean. */
+    return Polygon();
+  default: /**< Not a SetOperation. */
+    return Polygon();
+  }
+}
 
-    sort_points_counter_clockwise(result.points);
+/**< Same dispatch on borrowed vertices. */
+Polygon Polygon::compute_operation(const PolygonView &A, const PolygonView &B,
+                                   SetOperation op, ScratchContext *scratch) {
+  switch (op) {
+  case SetOperation::Union:
+    return compute_union(A, B, scratch);
+  case SetOperation::Intersection:
+    return compute_intersection(A, B, scratch);
+  case SetOperation::Difference:
+    return compute_subtraction(A, B, scratch);
+  case SetOperation::Xor:
+    return Polygon();
+  default: /**< Not a SetOperation. */
+    return Polygon();
   }
+}
 
-  return result;
+/**< The sweep of the operands through the result cache. */
+MultiPolygon Polygon::compute_boolean(const Polygon &A, const Polygon &B,
+                                      SetOperation op,
+                                      ScratchContext *scratch) {
+  return cached_operation(A, B, op, [&]() {
+    return operation_of(Operand(A), Operand(B), op, scratch);
+  });
+}
+
+/**< Same as above on borrowed vertices, without the cache. */
+MultiPolygon Polygon::compute_boolean(const PolygonView &A,
+                                      const PolygonView &B, SetOperation op,
+                                      ScratchContext *scratch) {
+  return operation_of(Operand(A), Operand(B), op, scratch);
 }
 
 /**< Applies the specified operation on a vector of polygons. */
-Polygon Polygon::apply_ops(std::vector<Polygon> polygons, SetOperation op) {
-  Polygon result(polygons.front());
+Polygon Polygon::apply_ops(const std::vector<Polygon> &polygons,
+                           SetOperation op) {
+  if (op == SetOperation::Xor)
+    return Polygon();
+  return single_ring(fold_ops(polygons, op));
+}
 
-  for (size_t i = 1; i < polygons.size(); i++) {
-    if ((i > 1) && (!result.is_valid())) {
-      std::cout << "Error ! Set operation results in empty polygon.\n";
-      break;
-    }
-    switch (op) {
-    case SetOperation::Union:
-      result = compute_union(result, polygons[i]);
-      break;
-    case SetOperation::Intersection:
-      result = compute_intersection(result, polygons[i]);
-      break;
-    case SetOperation::Difference:
-      result = compute_subtraction(result, polygons[i]);
-      break;
-    default:
-      std::cout << "Undefined SetOperation.\n";
-      return result;
-    }
+/**< Same as above, moving the vertices into the fold. */
+Polygon Polygon::apply_ops(std::vector<Polygon> &&polygons, SetOperation op) {
+  if (op == SetOperation::Xor)
+    return Polygon();
+  return single_ring(fold_ops(std::move(polygons), op));
+}
+
+/**< The rings of each step are the subject of the next. */
+MultiPolygon Polygon::apply_ops_rings(const std::vector<Polygon> &polygons,
+                                      SetOperation op) {
+  return fold_ops(polygons, op);
+}
+
+/**< Same as above, moving the vertices into the fold. */
+MultiPolygon Polygon::apply_ops_rings(std::vector<Polygon> &&polygons,
+                                      SetOperation op) {
+  return fold_ops(std::move(polygons), op);
+}
+
+/**< The simplified ring if there is one, else the polygon's own vertices,
+ * which are moved. */
+bool Polygon::reduction_operands(std::vector<Polygon> &&polygons,
+                                 std::vector<MultiPolygon> &rings) {
+  OperationStats stats;
+  rings.clear();
+  rings.reserve(polygons.size());
+  for (Polygon &polygon : polygons) {
+    const Operand operand(polygon);
+    if (!operand.is_valid())
+      return false;
+    operand.count_simplified(stats);
+    if (operand.simplified)
+      rings.emplace_back(*operand.simplified);
+    else
+      rings.emplace_back(std::move(polygon));
   }
+  record_operation_stats(stats);
+  return true;
+}
 
+/**< Folds the rings into those of the first polygon. */
+MultiPolygon Polygon::fold_ops(std::vector<Polygon> polygons,
+                               SetOperation op) {
+  POLYGON_SPAN("apply_ops");
+  std::vector<MultiPolygon> rings;
+  if (polygons.empty() || !reduction_operands(std::move(polygons), rings))
+    return MultiPolygon();
+
+  /**< A sweep of the first polygon alone orients its ring. */
+  MultiPolygon result = MultiPolygon::compute_operation(
+      rings.front(), MultiPolygon(), SetOperation::Union);
+  for (size_t i = 1; i < rings.size(); i++) {
+    /**< Nothing is left to intersect or to take away from. */
+    if (result.ring_count() == 0 && (op == SetOperation::Intersection ||
+                                     op == SetOperation::Difference))
+      break;
+    result = MultiPolygon::compute_operation(result, rings[i], op);
+  }
   return result;
 }
 
 /**< Applies the specified operation on a vector of polygons with
  * multithreading. */
-Polygon Polygon::apply_ops_multi_threaded(std::vector<Polygon> &polygons,
+Polygon Polygon::apply_ops_multi_threaded(const std::vector<Polygon> &polygons,
+                                          SetOperation op) {
+  if (op == SetOperation::Xor)
+    return Polygon();
+  return single_ring(reduce_multi_threaded(polygons, op));
+}
+
+/**< Same as above, reducing the caller's polygons in place. */
+Polygon Polygon::apply_ops_multi_threaded(std::vector<Polygon> &&polygons,
                                           SetOperation op) {
-  std::mutex resultMutex;
-  std::vector<Polygon> results(polygons.begin(), polygons.end());
-
-  while (results.size() > 1) {
-    std::vector<Polygon> nextResults;
-    std::vector<std::thread> threads;
-    nextResults.reserve((results.size() / 2) + 1);
-
-    /**< Handle iterations when size is odd. */
-    if (results.size() % 2 != 0)
-      nextResults.emplace_back(results.back());
-
-    for (size_t i = 0; i < results.size() - 1; i += 2) {
-      threads.emplace_back(
-          [&](size_t idx) {
-            auto temp = apply_ops({results[idx], results[idx + 1]}, op);
-            std::lock_guard<std::mutex> lock(resultMutex);
-            nextResults.emplace_back(temp);
-          },
-          i);
+  if (op == SetOperation::Xor)
+    return Polygon();
+  return single_ring(reduce_multi_threaded(std::move(polygons), op));
+}
+
+/**< Same reduction, keeping every ring. */
+MultiPolygon
+Polygon::apply_ops_rings_multi_threaded(const std::vector<Polygon> &polygons,
+                                        SetOperation op) {
+  return reduce_multi_threaded(polygons, op);
+}
+
+/**< Same as above, reducing the caller's polygons in place. */
+MultiPolygon
+Polygon::apply_ops_rings_multi_threaded(std::vector<Polygon> &&polygons,
+                                        SetOperation op) {
+  return reduce_multi_threaded(std::move(polygons), op);
+}
+
+/**< Balanced tree over the polygons in their original order. */
+MultiPolygon Polygon::reduce_multi_threaded(std::vector<Polygon> polygons,
+                                            SetOperation op) {
+  POLYGON_SPAN("apply_ops_multi_threaded");
+  std::vector<MultiPolygon> results;
+  if (polygons.empty() || !reduction_operands(std::move(polygons), results))
+    return MultiPolygon();
+  if (results.size() == 1)
+    return MultiPolygon::compute_operation(results.front(), MultiPolygon(),
+                                           SetOperation::Union);
+
+  const ParallelOptions options = get_parallel_options();
+  const std::shared_ptr<ThreadPool> pool = parallel_pool(options);
+
+  /**< Unions merge neighbours first, whatever their position. */
+  if (op == SetOperation::Union)
+    return cascaded_union(std::move(results), *pool, options.grainSize);
+
+  /**< A - B - C - ... is A - (B u C u ...), the union may have any number
+   * of rings. */
+  if (op == SetOperation::Difference) {
+    MultiPolygon first = std::move(results.front());
+    results.erase(results.begin());
+    return MultiPolygon::compute_operation(
+        first, cascaded_union(std::move(results), *pool, options.grainSize),
+        op);
+  }
+
+  std::vector<size_t> work(results.size() + 1, 0);
+  for (size_t i = 0; i < results.size(); ++i)
+    work[i + 1] = work[i] + results[i].get_number_of_points();
+
+  return reduce_range(results, work, 0, results.size(), op, *pool,
+                      options.grainSize);
+}
+
+/**< Every thread drains the shared queue, the caller included. */
+std::vector<Polygon> Polygon::compute_batch(const OperationRequest *requests,
+                                            size_t count) {
+  std::vector<Polygon> results(count);
+  if (count == 0)
+    return results;
+
+  POLYGON_SPAN("compute_batch");
+  const std::shared_ptr<ThreadPool> pool =
+      parallel_pool(get_parallel_options());
+  BatchQueue queue(requests, count);
+  auto drain = [&queue, &results]() {
+    size_t index;
+    while (queue.take(index))
+      results[index] = queue.run(index);
+  };
+
+  TaskGroup group(*pool);
+  const size_t helpers = std::min<size_t>(pool->size(), count - 1);
+  for (size_t t = 0; t < helpers; ++t)
+    group.run(drain);
+  drain();
+  group.wait();
+  return results;
+}
+
+/**< One promise per job. */
+std::vector<std::future<Polygon>>
+Polygon::compute_batch_async(const OperationRequest *requests, size_t count) {
+  auto batch = std::make_shared<AsyncBatch>(requests, count);
+  auto promises = std::make_shared<std::vector<std::promise<Polygon>>>(count);
+  std::vector<std::future<Polygon>> futures;
+  futures.reserve(count);
+  for (std::promise<Polygon> &promise : *promises)
+    futures.push_back(promise.get_future());
+
+  AsyncBatch &state = *batch;
+  state.runJob = [&state, promises](size_t index) {
+    try {
+      (*promises)[index].set_value(state.queue.run(index));
+    } catch (...) {
+      (*promises)[index].set_exception(std::current_exception());
+    }
+  };
+  state.done = []() {};
+  launch_batch(batch);
+  return futures;
+}
+
+/**< One promise for the whole batch, the first exception is kept. */
+std::future<void>
+Polygon::compute_batch_async(const OperationRequest *requests, size_t count,
+                             std::function<void(size_t, Polygon &&)> callback) {
+  struct Completion {
+    std::promise<void> finished; /**< Set after the last callback. */
+    std::mutex errorMutex;       /**< Guards error. */
+    std::exception_ptr error;    /**< First exception thrown. */
+  };
+  auto batch = std::make_shared<AsyncBatch>(requests, count);
+  auto completion = std::make_shared<Completion>();
+  std::future<void> future = completion->finished.get_future();
+
+  AsyncBatch &state = *batch;
+  state.runJob = [&state, completion, callback](size_t index) {
+    try {
+      callback(index, state.queue.run(index));
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(completion->errorMutex);
+      if (!completion->error)
+        completion->error = std::current_exception();
     }
+  };
+  state.done = [completion]() {
+    std::lock_guard<std::mutex> lock(completion->errorMutex);
+    if (completion->error)
+      completion->finished.set_exception(completion->error);
+    else
+      completion->finished.set_value();
+  };
+  launch_batch(batch);
+  return future;
+}
+
+/**< Spatial tree on the configured pool. */
+Polygon Polygon::compute_cascaded_union(const std::vector<Polygon> &polygons) {
+  return compute_cascaded_union(std::vector<Polygon>(polygons));
+}
+
+/**< Same as above, consuming the caller's polygons. */
+Polygon Polygon::compute_cascaded_union(std::vector<Polygon> &&polygons) {
+  POLYGON_SPAN("cascaded union");
+  std::vector<MultiPolygon> rings;
+  if (polygons.empty() || !reduction_operands(std::move(polygons), rings))
+    return Polygon();
+  if (rings.size() == 1)
+    return single_ring(MultiPolygon::compute_operation(
+        rings.front(), MultiPolygon(), SetOperation::Union));
+
+  const ParallelOptions options = get_parallel_options();
+  const std::shared_ptr<ThreadPool> pool = parallel_pool(options);
+  return single_ring(
+      cascaded_union(std::move(rings), *pool, options.grainSize));
+}
+
+/**< Empty view. */
+PolygonView::PolygonView() {}
+
+/**< View of raw vertices with known bounds. */
+PolygonView::PolygonView(const Point *first, size_t size,
+                         const BoundingBox &box)
+    : points(first), count(size), bounds(box) {}
+
+/**< Bounds of the vertices in one pass. */
+PolygonView::PolygonView(const std::vector<Point> &vertices)
+    : points(vertices.data()), count(vertices.size()) {
+  if (vertices.empty())
+    return;
+
+  bounds.minX = bounds.maxX = vertices.front().x;
+  bounds.minY = bounds.maxY = vertices.front().y;
+  for (const Point &point : vertices) {
+    bounds.minX = std::min(bounds.minX, point.x);
+    bounds.maxX = std::max(bounds.maxX, point.x);
+    bounds.minY = std::min(bounds.minY, point.y);
+    bounds.maxY = std::max(bounds.maxY, point.y);
+  }
+}
+
+/**< Shares the cached bounds of the polygon. */
+PolygonView::PolygonView(const Polygon &polygon)
+    : points(polygon.points.data()), count(polygon.points.size()),
+      bounds(polygon.get_bounding_box()) {}
+
+/**< Same checks as Polygon::is_valid. */
+bool PolygonView::is_valid() const {
+  return (count >= 3) && !has_self_intersection(*this);
+}
+
+/**< Batched winding number test over a fresh edge table. */
+void PolygonView::classify(const Point *pts, size_t n, int8_t *out) const {
+  const EdgeTable edges(*this);
+  classify_points(edges, pts, n, out);
+}
 
-    for (auto &thread : threads)
-      thread.join();
+/**< Guarded by parallelMutex. */
+void Polygon::set_parallel_options(const ParallelOptions &options) {
+  std::lock_guard<std::mutex> lock(parallelMutex);
+  parallelOptions = options;
+}
+
+ParallelOptions Polygon::get_parallel_options() {
+  std::lock_guard<std::mutex> lock(parallelMutex);
+  return parallelOptions;
+}
+
+/**< Guarded by simplifyMutex, the flag lets operations skip the lock. */
+void Polygon::set_simplify_options(const SimplifyOptions &options) {
+  {
+    std::lock_guard<std::mutex> lock(simplifyMutex);
+    simplifyOptions = options;
+    simplifyEnabled.store(options.enabled, std::memory_order_relaxed);
+  }
+  /**< Results computed with the old setting would differ. */
+  resultCache.clear();
+}
+
+SimplifyOptions Polygon::get_simplify_options() {
+  std::lock_guard<std::mutex> lock(simplifyMutex);
+  return simplifyOptions;
+}
 
-    results = std::move(nextResults);
+/**< The results are dropped when the cache is switched off. */
+void Polygon::set_result_cache_options(const ResultCacheOptions &options) {
+  std::lock_guard<std::mutex> lock(resultCacheMutex);
+  resultCacheOptions = options;
+  resultCacheEnabled.store(options.enabled, std::memory_order_relaxed);
+  if (options.enabled) {
+    OperationStats stats;
+    stats.cacheEvictions = resultCache.set_capacity(options.maxBytes);
+    record_operation_stats(stats);
+  } else {
+    resultCache.clear();
   }
+}
+
+ResultCacheOptions Polygon::get_result_cache_options() {
+  std::lock_guard<std::mutex> lock(resultCacheMutex);
+  return resultCacheOptions;
+}
+
+size_t Polygon::result_cache_bytes() { return resultCache.size_in_bytes(); }
+
+/**< Totals over all threads. */
+OperationStats Polygon::stats() { return load_operation_stats(); }
+
+/**< Start counting from zero. */
+void Polygon::reset_stats() { reset_operation_stats(); }
+
+/**< Read by the counting macros with a relaxed load. */
+void Polygon::set_stats_enabled(bool enabled) {
+  statsEnabled.store(enabled && POLYGON_ENABLE_STATS,
+                     std::memory_order_relaxed);
+}
+
+/**< Same for the spans. */
+void Polygon::set_trace_enabled(bool enabled) {
+  traceEnabled.store(enabled && POLYGON_ENABLE_STATS,
+                     std::memory_order_relaxed);
+}
 
-  return results.front();
+/**< Chrome trace of every thread. */
+bool Polygon::write_trace(const std::string &filename) {
+  return write_trace_events(filename);
 }
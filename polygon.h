@@ -1,14 +1,24 @@
 #ifndef POLYGON_H
 #define POLYGON_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 /**
- * @brief Enumeration representing set operations on polygons.
+ * @brief Enumeration representing set operations on polygons. Xor is only
+ * supported by compute_boolean, the apply_ops_rings functions and
+ * MultiPolygon::compute_operation, the operations returning a single Polygon
+ * return an empty one for it.
  */
-enum class SetOperation { Union, Intersection, Difference };
+enum class SetOperation { Union, Intersection, Difference, Xor };
 
 /**
  * @brief Struct to represent a 2D point with x and y coordinates.
@@ -27,6 +37,162 @@ struct Point {
   bool operator<(const Point &other) const;
 };
 
+/**
+ * @brief Axis aligned bounding box of a set of points.
+ */
+struct BoundingBox {
+  double minX = 0.0; /**< Smallest x-coordinate. */
+  double minY = 0.0; /**< Smallest y-coordinate. */
+  double maxX = 0.0; /**< Largest x-coordinate. */
+  double maxY = 0.0; /**< Largest y-coordinate. */
+
+  /**
+   * @brief Check if two boxes share at least one point.
+   *
+   * @param other The other box.
+   *
+   * @return True if the boxes overlap or touch.
+   */
+  bool overlaps(const BoundingBox &other) const;
+};
+
+/**
+ * @brief Busy time of one thread inside apply_ops_multi_threaded.
+ */
+struct ThreadStats {
+  unsigned int thread = 0; /**< Thread number, in order of first use. */
+  uint64_t tasks = 0;      /**< Reduction steps run. */
+  double busySeconds = 0;  /**< Time spent running them. */
+};
+
+/**
+ * @brief Counters of the pairwise set operations, see Polygon::stats. The
+ * bounding box, convex and simplification counters are always kept, the hot
+ * path counters below them only while Polygon::set_stats_enabled is on.
+ */
+struct OperationStats {
+  uint64_t operations = 0;         /**< Pairwise set operations run. */
+  uint64_t disjointOperations = 0; /**< Settled by the polygon boxes. */
+  uint64_t edges = 0;              /**< Edges entering the crossing search. */
+  uint64_t edgesRejected = 0;      /**< Dropped, box misses the other. */
+  uint64_t edgePairs = 0;          /**< Pairs of the nested edge loop. */
+  uint64_t edgePairsRejected = 0;  /**< Skipped, their boxes miss. */
+  uint64_t pointTests = 0;         /**< Point in polygon queries. */
+  uint64_t pointTestsRejected = 0; /**< Answered by the polygon box. */
+  uint64_t convexOperations = 0;   /**< Settled by the convex paths. */
+  uint64_t simplifiedVertices = 0; /**< Operand vertices simplified. */
+  uint64_t verticesRemoved = 0;    /**< Of those, removed. */
+  uint64_t cacheHits = 0;          /**< Results found in the result cache. */
+  uint64_t cacheMisses = 0;        /**< Results computed and stored there. */
+  uint64_t cacheEvictions = 0;     /**< Results it dropped to make room. */
+
+  uint64_t segmentTests = 0;        /**< do_lines_intersect calls. */
+  uint64_t segmentHits = 0;         /**< Of those, segments that meet. */
+  uint64_t predicateFallbacks = 0;  /**< Orientations decided exactly. */
+  uint64_t pointInPolygonCalls = 0; /**< Points classified. */
+  uint64_t edgesVisited = 0;        /**< Edges tested to classify them. */
+  uint64_t validityChecks = 0;      /**< is_valid calls. */
+  uint64_t validityComputed = 0;    /**< Of those, not found in the cache. */
+  uint64_t sorts = 0;               /**< Angular sorts of vertices. */
+  double sortSeconds = 0;           /**< Time spent in them. */
+  uint64_t allocations = 0;         /**< operator new calls, counted in
+                                       programs built with alloc_hook.cpp. */
+  uint64_t allocatedBytes = 0;      /**< Bytes they asked for. */
+  std::vector<ThreadStats> threads; /**< Reduction time per thread. */
+
+  /**
+   * @brief Add the counters of another set of stats.
+   *
+   * @param other The stats to add.
+   *
+   * @return Reference to this object.
+   */
+  OperationStats &operator+=(const OperationStats &other);
+
+  /**
+   * @brief Overloaded stream insertion operator printing every counter with
+   * its skip rate.
+   *
+   * @param os The output stream.
+   * @param stats The stats to output.
+   *
+   * @return Reference to the output stream.
+   */
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const OperationStats &stats);
+};
+
+/**
+ * @brief Settings of the multi threaded operations, see
+ * Polygon::set_parallel_options.
+ */
+struct ParallelOptions {
+  unsigned int threads = 0; /**< Threads per call, 0 for all hardware. */
+  size_t grainSize = 1024;  /**< Fewer vertices than this are done inline. */
+};
+
+/**
+ * @brief Algorithms of the simplification stage, see simplify.h.
+ */
+enum class SimplifyMethod { DouglasPeucker, VisvalingamWhyatt };
+
+/**
+ * @brief Settings of the simplification applied to the operands of the set
+ * operations, see Polygon::set_simplify_options.
+ */
+struct SimplifyOptions {
+  bool enabled = false;  /**< Simplify before every set operation. */
+  double tolerance = 0.0; /**< Largest distance a removed vertex may lie
+                             from the new boundary, for Visvalingam-Whyatt
+                             the root of the largest triangle removed. */
+  SimplifyMethod method = SimplifyMethod::DouglasPeucker; /**< Algorithm. */
+  bool preserveTopology = true; /**< Never let a ring intersect itself. */
+};
+
+/**
+ * @brief Settings of the cache of set operation results, see
+ * Polygon::set_result_cache_options.
+ */
+struct ResultCacheOptions {
+  bool enabled = false;               /**< Look results up before computing. */
+  size_t maxBytes = size_t(64) << 20; /**< Memory the results and the
+                                         copies of their operands may
+                                         take. */
+};
+
+/**
+ * @brief Hash of the vertices of a polygon, see Polygon::get_content_hash.
+ */
+struct ContentHash {
+  uint64_t low = 0;  /**< First half. */
+  uint64_t high = 0; /**< Second half. */
+
+  bool operator==(const ContentHash &other) const {
+    return low == other.low && high == other.high;
+  }
+};
+
+class Polygon;
+
+/**
+ * @brief One independent pairwise operation of Polygon::compute_batch. The
+ * polygons are borrowed and must outlive the batch.
+ */
+struct OperationRequest {
+  const Polygon *A = nullptr;            /**< The first polygon. */
+  const Polygon *B = nullptr;            /**< The second polygon. */
+  SetOperation op = SetOperation::Union; /**< Union, Intersection or
+                                            Difference, Xor gives an empty
+                                            result. */
+};
+
+struct EdgeTable; /**< Edges in SoA layout, see point_in_polygon.h. */
+class PreparedPolygon; /**< Indexed polygon, see point_in_polygon.h. */
+class PolygonView;     /**< Borrowed vertices, see below. */
+class MultiPolygon;    /**< Polygons with holes, see multi_polygon.h. */
+class ScratchContext;  /**< Memory for temporaries, see scratch.h. */
+class EditIndex;       /**< Kept while editing, see edit_index.h. */
+
 /**
  * @brief Class representing a polygon in 2D space.
  */
@@ -34,6 +200,141 @@ class Polygon {
 private:
   std::vector<Point> points; /**< Vector of points representing the polygon. */
 
+  /**
+   * @brief Properties derived from the points. They are computed on first use
+   * and kept until the points change, the flags record what is up to date.
+   * Guarded by cacheMutex so const polygons can be shared between threads.
+   */
+  mutable std::mutex cacheMutex;
+  mutable std::atomic<unsigned int> cacheFlags{0}; /**< CacheFlag bits. */
+  mutable bool valid = false;       /**< Result of is_valid. */
+  mutable BoundingBox bounds;       /**< Result of get_bounding_box. */
+  mutable double signedArea = 0.0; /**< Result of get_signed_area. */
+  mutable bool convex = false;      /**< Result of is_convex. */
+  mutable std::shared_ptr<const EdgeTable> edgeTable; /**< For classify. */
+  mutable std::shared_ptr<const PreparedPolygon> prepared; /**< Its index. */
+  mutable std::shared_ptr<const Polygon> simplified; /**< Null if nothing
+                                                        could be removed. */
+  mutable SimplifyOptions simplifiedWith; /**< Settings of simplified. */
+  mutable ContentHash contentHash;        /**< Result of get_content_hash. */
+  std::unique_ptr<EditIndex> editIndex; /**< Built by the first edit, not
+                                           shared with copies. */
+
+  /**
+   * @brief Bits of cacheFlags.
+   */
+  enum CacheFlag : unsigned int {
+    ValidityCached = 1u << 0,   /**< valid is up to date. */
+    GeometryCached = 1u << 1,   /**< bounds and signedArea are. */
+    EdgesCached = 1u << 2,      /**< edgeTable is. */
+    PreparedCached = 1u << 3,   /**< prepared is. */
+    SimplifiedCached = 1u << 4, /**< simplified is, for simplifiedWith. */
+    ConvexCached = 1u << 5,     /**< convex is. */
+    HashCached = 1u << 6        /**< contentHash is. */
+  };
+
+  /**
+   * @brief Drop every cached property, call whenever points change.
+   */
+  void invalidate_cache();
+
+  /**
+   * @brief Build the edit index over the points if needed, at least three.
+   *
+   * @return The index.
+   */
+  EditIndex &edit_index();
+
+  /**
+   * @brief Take validity, bounds and area from the edit index after an edit
+   * and drop the other cached properties.
+   */
+  void cache_edit();
+
+  /**
+   * @brief Copy the cached properties of a polygon with identical points.
+   *
+   * @param other The polygon to copy from.
+   */
+  void copy_cache(const Polygon &other);
+
+  /**
+   * @brief Move the cached properties of a polygon whose points were moved
+   * into this one, the other polygon's cache is dropped.
+   *
+   * @param other The polygon to take from.
+   */
+  void take_cache(Polygon &other);
+
+  /**
+   * @brief Compute bounds, signed area and convexity if needed. After an
+   * edit only convexity is left to compute.
+   */
+  void update_geometry() const;
+
+  /**
+   * @brief Build the edge table used by classify if needed.
+   *
+   * @return The edge table, shared with copies of this polygon.
+   */
+  std::shared_ptr<const EdgeTable> get_edge_table() const;
+
+  /**
+   * @brief Build the containment index of this polygon if needed.
+   *
+   * @return The index, shared with copies of this polygon.
+   */
+  std::shared_ptr<const PreparedPolygon> get_prepared() const;
+
+  /**
+   * @brief Simplify the polygon if it was not simplified with the same
+   * settings before.
+   *
+   * @param options Settings of the simplification.
+   *
+   * @return The simplified polygon, null if no vertex could be removed.
+   */
+  std::shared_ptr<const Polygon>
+  get_simplified(const SimplifyOptions &options) const;
+
+  /**
+   * @brief One side of a set operation, a polygon with its caches or a plain
+   * view. Defined in polygon.cpp.
+   */
+  struct Operand;
+
+  /**
+   * @brief The set operations on operands with the sweep of boolean_op.h,
+   * shared by the Polygon and the PolygonView overloads. Disjoint boxes and
+   * convex pairs are settled without the sweep where they can be.
+   *
+   * @param A The first operand.
+   * @param B The second operand.
+   * @param op Union, Intersection, Difference or Xor.
+   * @param scratch Memory for the temporaries, null for the calling
+   * thread's.
+   *
+   * @return The rings of the result, none if an operand is not valid.
+   */
+  static MultiPolygon operation_of(const Operand &A, const Operand &B,
+                                   SetOperation op, ScratchContext *scratch);
+
+  /**
+   * @brief The rings of polygons entering a reduction, each simplified if
+   * that is enabled.
+   *
+   * @param polygons The polygons, consumed.
+   * @param rings Output, one multi polygon per polygon.
+   *
+   * @return False if one of the polygons is not valid.
+   */
+  static bool reduction_operands(std::vector<Polygon> &&polygons,
+                                 std::vector<MultiPolygon> &rings);
+
+  friend class PreparedPolygon; /**< Shares the cached edge table. */
+  friend class PolygonView;     /**< Borrows the points. */
+  friend class MultiPolygon;    /**< Takes over the points. */
+
 public:
   /**
    * @brief Default constructor for the Polygon class.
@@ -48,12 +349,37 @@ public:
   Polygon(const std::vector<Point> &input);
 
   /**
-   * @brief Copy constructor for the Polygon class.
+   * @brief Parameterized constructor taking over the storage of the points.
+   *
+   * @param input Vector of points to initialize the polygon.
+   */
+  Polygon(std::vector<Point> &&input);
+
+  /**
+   * @brief Make a polygon of a ring whose vertices are already in order,
+   * unlike the constructors they are not sorted by angle.
+   *
+   * @param ring Vertices of the ring, the last connects to the first.
+   *
+   * @return The polygon.
+   */
+  static Polygon from_ring(std::vector<Point> ring);
+
+  /**
+   * @brief Copy constructor for the Polygon class. The points are already in
+   * order so they are copied as is, together with any cached properties.
    *
    * @param other The polygon to copy.
    */
   Polygon(const Polygon &other);
 
+  /**
+   * @brief Move constructor for the Polygon class.
+   *
+   * @param other The polygon to move from, left empty.
+   */
+  Polygon(Polygon &&other) noexcept;
+
   /**
    * @brief Destructor for the Polygon class.
    */
@@ -77,6 +403,15 @@ public:
    */
   Polygon &operator=(const Polygon &other);
 
+  /**
+   * @brief Move assignment operator.
+   *
+   * @param other The polygon to move from, left empty.
+   *
+   * @return Reference to the assigned polygon.
+   */
+  Polygon &operator=(Polygon &&other) noexcept;
+
   /**
    * @brief Get the total number of points in the polygon.
    *
@@ -85,14 +420,131 @@ public:
   unsigned int get_number_of_points() const;
 
   /**
-   * @brief Perform basic sanity checks on the polygon.
+   * @brief Perform basic sanity checks on the polygon. Self intersections are
+   * found with a Shamos-Hoey sweep in O(n log n), the result is cached until
+   * the points change.
    *
    * @return True if the polygon is valid, false otherwise.
    */
   bool is_valid() const;
 
   /**
-   * @brief Load a polygon from a CSV file.
+   * @brief Same checks as is_valid but tests every pair of edges in O(n^2).
+   * Kept as a reference for cross-checking the sweep based is_valid.
+   *
+   * @return True if the polygon is valid, false otherwise.
+   */
+  bool is_valid_brute_force() const;
+
+  /**
+   * @brief Get the axis aligned bounding box of the polygon, cached.
+   *
+   * @return The bounding box, all zero for an empty polygon.
+   */
+  BoundingBox get_bounding_box() const;
+
+  /**
+   * @brief Get the signed area of the polygon (shoelace formula), cached.
+   *
+   * @return Area, positive if the points run counter clockwise.
+   */
+  double get_signed_area() const;
+
+  /**
+   * @brief Check the orientation of the points, cached.
+   *
+   * @return True if the points run counter clockwise.
+   */
+  bool is_counter_clockwise() const;
+
+  /**
+   * @brief Check if the polygon is convex, cached. Collinear vertices are
+   * allowed, self intersecting rings are never convex. Intersections and
+   * unions of convex polygons take linear time paths, see convex.h.
+   *
+   * @return True if the polygon is convex.
+   */
+  bool is_convex() const;
+
+  /**
+   * @brief Remove the vertices that add less than a tolerance to the shape,
+   * see simplify_ring. Large rings are simplified in parallel on the pool of
+   * the multi threaded operations.
+   *
+   * @param options Method, tolerance and topology preservation, enabled is
+   * not read.
+   * @param removed Output if not null, the number of vertices removed.
+   *
+   * @return The simplified polygon, its vertices in the same order.
+   */
+  Polygon simplify(const SimplifyOptions &options,
+                   size_t *removed = nullptr) const;
+
+  /**
+   * @brief Hash the vertices in the order the polygon keeps them, cached.
+   * Polygons with the same vertices in the same order hash alike, whatever
+   * way they were built. The result cache takes polygons with equal hashes
+   * for equal, 128 bits make an accidental collision negligible.
+   *
+   * @return The hash.
+   */
+  ContentHash get_content_hash() const;
+
+  /**
+   * @brief Insert a vertex into the ring before the vertex at an index. The
+   * order of the points is kept as it is, nothing is sorted by angle.
+   *
+   * The first edit indexes the edges of the ring (see edit_index.h). From
+   * then on an edit only tests the edges at its vertex against the edges
+   * near them, so is_valid stays cached, and the bounds and the area are
+   * updated in O(log n). Convexity and the classification tables are built
+   * again on their next use. Moving the vertices along still costs O(n), a
+   * plain memmove.
+   *
+   * @param index Position of the new vertex, the number of points to append
+   * it.
+   * @param point The vertex.
+   *
+   * @return False if the index is out of range, the polygon is unchanged.
+   */
+  bool insert_vertex(size_t index, const Point &point);
+
+  /**
+   * @brief Move the vertex at an index, see insert_vertex.
+   *
+   * @param index Position of the vertex.
+   * @param point Its new position.
+   *
+   * @return False if the index is out of range, the polygon is unchanged.
+   */
+  bool move_vertex(size_t index, const Point &point);
+
+  /**
+   * @brief Remove the vertex at an index, see insert_vertex. Its neighbours
+   * are joined by a new edge.
+   *
+   * @param index Position of the vertex.
+   *
+   * @return False if the index is out of range, the polygon is unchanged.
+   */
+  bool remove_vertex(size_t index);
+
+  /**
+   * @brief Classify many points against the polygon at once, with the same
+   * codes as is_point_inside_polygon. The edges are kept in a cached
+   * structure of arrays table and several points are tested per iteration
+   * with AVX2 or SSE2 where available.
+   *
+   * @param pts Points to classify.
+   * @param n Number of points.
+   * @param out Output per point: 1 inside, 0 on the boundary, -1 outside.
+   */
+  void classify(const Point *pts, size_t n, int8_t *out) const;
+
+  /**
+   * @brief Load a polygon from a CSV file. The file is memory mapped and
+   * parsed in place, malformed lines are reported once as a summary. Only
+   * the first polygon of a file holding several is loaded.
    *
    * @param filename The name of the CSV file.
    *
@@ -101,13 +553,37 @@ public:
   bool read_file(const std::string &filename);
 
   /**
-   * @brief Write the polygon to a CSV file.
+   * @brief Load every polygon of a CSV file, see parse_polygons for the
+   * layouts understood.
+   *
+   * @param filename The name of the CSV file.
+   * @param polygons Output, the polygons in file order.
+   *
+   * @return True if the file is successfully loaded, false otherwise.
+   */
+  static bool read_file(const std::string &filename,
+                        std::vector<Polygon> &polygons);
+
+  /**
+   * @brief Write the polygon to a CSV file, each coordinate with the fewest
+   * digits that read back exactly.
    *
    * @param filename The name of the CSV file.
    *
    * @return True if the file is successfully written, false otherwise.
    */
-  bool write_file(const std::string &filename);
+  bool write_file(const std::string &filename) const;
+
+  /**
+   * @brief Write several polygons to one CSV file, separated by blank lines.
+   *
+   * @param filename The name of the CSV file.
+   * @param polygons The polygons to write.
+   *
+   * @return True if the file is successfully written, false otherwise.
+   */
+  static bool write_file(const std::string &filename,
+                         const std::vector<Polygon> &polygons);
 
   /**
    * @brief Overloaded stream insertion operator for outputting the polygon.
@@ -120,56 +596,536 @@ public:
   friend std::ostream &operator<<(std::ostream &os, const Polygon &polygon);
 
   /**
-   * @brief Compute the union of two polygons.
+   * @brief Compute the union of two polygons with the sweep of
+   * compute_boolean.
+   *
+   * @param A The first polygon.
+   * @param B The second polygon.
+   * @param scratch Memory for the temporaries, null for the calling
+   * thread's.
+   *
+   * @return The polygon representing the union of A and B, empty if it is
+   * not a single ring, such as the union of disjoint polygons.
+   */
+  static Polygon compute_union(const Polygon &A, const Polygon &B,
+                               ScratchContext *scratch = nullptr);
+
+  /**
+   * @brief Compute the intersection of two polygons with the sweep of
+   * compute_boolean.
    *
    * @param A The first polygon.
    * @param B The second polygon.
+   * @param scratch Memory for the temporaries, null for the calling
+   * thread's.
    *
-   * @return The polygon representing the union of A and B.
+   * @return The polygon representing the intersection of A and B, empty if
+   * it is not a single ring.
    */
-  static Polygon compute_union(Polygon A, Polygon B);
+  static Polygon compute_intersection(const Polygon &A, const Polygon &B,
+                                      ScratchContext *scratch = nullptr);
 
   /**
-   * @brief Compute the intersection of two polygons.
+   * @brief Compute the subtraction of two polygons (A - B) with the sweep of
+   * compute_boolean.
    *
    * @param A The first polygon.
    * @param B The second polygon.
+   * @param scratch Memory for the temporaries, null for the calling
+   * thread's.
    *
-   * @return The polygon representing the intersection of A and B.
+   * @return The polygon representing the subtraction of B from A, empty if
+   * it is not a single ring, such as B cutting a hole into A.
    */
-  static Polygon compute_intersection(Polygon A, Polygon B);
+  static Polygon compute_subtraction(const Polygon &A, const Polygon &B,
+                                     ScratchContext *scratch = nullptr);
 
   /**
-   * @brief Compute the subtraction of two polygons (A - B).
+   * @brief Set operations on views, for example polygons mapped from a
+   * binary file (see polygon_binary.h). Same results as the Polygon
+   * overloads, validity and the point in polygon tables are computed per
+   * call instead of cached.
    *
    * @param A The first polygon.
    * @param B The second polygon.
+   * @param scratch Memory for the temporaries, null for the calling
+   * thread's.
    *
-   * @return The polygon representing the subtraction of B from A.
+   * @return The resulting polygon.
    */
-  static Polygon compute_subtraction(Polygon A, Polygon B);
+  static Polygon compute_union(const PolygonView &A, const PolygonView &B,
+                               ScratchContext *scratch = nullptr);
+  static Polygon compute_intersection(const PolygonView &A,
+                                      const PolygonView &B,
+                                      ScratchContext *scratch = nullptr);
+  static Polygon compute_subtraction(const PolygonView &A,
+                                     const PolygonView &B,
+                                     ScratchContext *scratch = nullptr);
 
   /**
-   * @brief Apply the same operation to a vector of polygons.
+   * @brief Apply a set operation to two polygons.
+   *
+   * @param A The first polygon.
+   * @param B The second polygon.
+   * @param op The specified operation eg Union, Intersection or Difference.
+   * @param scratch Memory for the temporaries (see scratch.h), null for the
+   * calling thread's.
+   *
+   * @return The resulting polygon, empty for Xor or if the result is not a
+   * single ring, see compute_boolean.
+   */
+  static Polygon compute_operation(const Polygon &A, const Polygon &B,
+                                   SetOperation op,
+                                   ScratchContext *scratch = nullptr);
+
+  /**
+   * @brief Apply a set operation to two views.
+   *
+   * @param A The first polygon.
+   * @param B The second polygon.
+   * @param op The specified operation eg Union, Intersection or Difference.
+   * @param scratch Memory for the temporaries (see scratch.h), null for the
+   * calling thread's.
+   *
+   * @return The resulting polygon, empty for Xor or if the result is not a
+   * single ring, see compute_boolean.
+   */
+  static Polygon compute_operation(const PolygonView &A, const PolygonView &B,
+                                   SetOperation op,
+                                   ScratchContext *scratch = nullptr);
+
+  /**
+   * @brief Apply a set operation to two polygons with the sweep of
+   * boolean_op.h, which every operation above goes through. The result may
+   * be concave and consist of several rings and holes. Like them it goes
+   * through the simplification and the result cache if they are enabled,
+   * and is empty if either polygon is not valid.
+   *
+   * @param A The first polygon.
+   * @param B The second polygon.
+   * @param op The specified operation eg Union, Intersection, Difference or
+   * Xor.
+   * @param scratch Memory for the temporaries (see scratch.h), null for the
+   * calling thread's.
+   *
+   * @return The resulting multi polygon, see MultiPolygon::compute_operation.
+   */
+  static MultiPolygon compute_boolean(const Polygon &A, const Polygon &B,
+                                      SetOperation op,
+                                      ScratchContext *scratch = nullptr);
+
+  /**
+   * @brief compute_boolean on two views, without the result cache.
+   *
+   * @param A The first polygon.
+   * @param B The second polygon.
+   * @param op The specified operation eg Union, Intersection, Difference or
+   * Xor.
+   * @param scratch Memory for the temporaries (see scratch.h), null for the
+   * calling thread's.
+   *
+   * @return The resulting multi polygon, see MultiPolygon::compute_operation.
+   */
+  static MultiPolygon compute_boolean(const PolygonView &A,
+                                      const PolygonView &B, SetOperation op,
+                                      ScratchContext *scratch = nullptr);
+
+  /**
+   * @brief Apply the same operation to a vector of polygons, see
+   * apply_ops_rings.
    *
    * @param polygons Vector of polygons.
    * @param op The specified operation eg Union, Intersection or Difference.
    *
-   * @return The resulting polygon.
+   * @return The resulting polygon, empty for Xor or if the result is not a
+   * single ring.
    */
-  static Polygon apply_ops(std::vector<Polygon> polygons, SetOperation op);
+  static Polygon apply_ops(const std::vector<Polygon> &polygons,
+                           SetOperation op);
 
   /**
-   * @brief Apply the same operation to a vector of polygons. Splits the
-   * workload on multiple threads to speed up computation.
+   * @brief Apply the same operation to a vector of polygons the caller no
+   * longer needs, their vertices are moved into the fold.
    *
    * @param polygons Vector of polygons.
    * @param op The specified operation eg Union, Intersection or Difference.
    *
-   * @return The resulting polygon.
+   * @return The resulting polygon, empty for Xor or if the result is not a
+   * single ring.
+   */
+  static Polygon apply_ops(std::vector<Polygon> &&polygons, SetOperation op);
+
+  /**
+   * @brief Apply the same operation to a vector of polygons with the sweep
+   * of compute_boolean, folding them into the rings of the result one by
+   * one, so holes and separate parts carry over to the next step. The
+   * polygons are simplified first if that is enabled. An empty intermediate
+   * intersection or difference ends the fold.
+   *
+   * @param polygons Vector of polygons.
+   * @param op The specified operation eg Union, Intersection, Difference or
+   * Xor.
+   *
+   * @return The resulting multi polygon as for compute_boolean, empty if one
+   * of the polygons is not valid.
+   */
+  static MultiPolygon apply_ops_rings(const std::vector<Polygon> &polygons,
+                                      SetOperation op);
+
+  /**
+   * @brief apply_ops_rings for polygons the caller no longer needs.
+   *
+   * @param polygons Vector of polygons.
+   * @param op The specified operation eg Union, Intersection, Difference or
+   * Xor.
+   *
+   * @return The resulting multi polygon as for compute_boolean.
+   */
+  static MultiPolygon apply_ops_rings(std::vector<Polygon> &&polygons,
+                                      SetOperation op);
+
+  /**
+   * @brief Apply the same operation to a vector of polygons, see
+   * apply_ops_rings_multi_threaded.
+   *
+   * @param polygons Vector of polygons.
+   * @param op The specified operation eg Union, Intersection or Difference.
+   *
+   * @return The resulting polygon, empty for Xor or if the result is not a
+   * single ring.
+   */
+  static Polygon apply_ops_multi_threaded(const std::vector<Polygon> &polygons,
+                                          SetOperation op);
+
+  /**
+   * @brief Multi threaded apply_ops for a vector of polygons the caller no
+   * longer needs, the polygons are reduced in place instead of copied.
+   *
+   * @param polygons Vector of polygons.
+   * @param op The specified operation eg Union, Intersection or Difference.
+   *
+   * @return The resulting polygon, empty for Xor or if the result is not a
+   * single ring.
    */
-  static Polygon apply_ops_multi_threaded(std::vector<Polygon> &polygons,
+  static Polygon apply_ops_multi_threaded(std::vector<Polygon> &&polygons,
                                           SetOperation op);
+
+  /**
+   * @brief apply_ops_rings on multiple threads. The rings of the polygons
+   * are reduced along a balanced tree that keeps their left to right order,
+   * on a shared pool of worker threads. A union is computed as in
+   * compute_cascaded_union, a difference subtracts the cascaded union of all
+   * polygons but the first from the first one. The result does not depend
+   * on thread timing.
+   *
+   * @param polygons Vector of polygons.
+   * @param op The specified operation eg Union, Intersection, Difference or
+   * Xor.
+   *
+   * @return The resulting multi polygon, empty if one of the polygons is not
+   * valid.
+   */
+  static MultiPolygon
+  apply_ops_rings_multi_threaded(const std::vector<Polygon> &polygons,
+                                 SetOperation op);
+
+  /**
+   * @brief apply_ops_rings_multi_threaded for polygons the caller no longer
+   * needs.
+   *
+   * @param polygons Vector of polygons.
+   * @param op The specified operation eg Union, Intersection, Difference or
+   * Xor.
+   *
+   * @return The resulting multi polygon.
+   */
+  static MultiPolygon
+  apply_ops_rings_multi_threaded(std::vector<Polygon> &&polygons,
+                                 SetOperation op);
+
+  /**
+   * @brief Union of many polygons that merges neighbours first. The bounding
+   * boxes are packed into a Sort-Tile-Recursive tree and the polygons are
+   * united bottom up along it, the nodes of each level in parallel, so most
+   * merges are between nearby polygons of similar size.
+   *
+   * @param polygons Vector of polygons.
+   *
+   * @return The resulting polygon, empty if the union is not a single ring
+   * or one of the polygons is not valid.
+   */
+  static Polygon compute_cascaded_union(const std::vector<Polygon> &polygons);
+
+  /**
+   * @brief Cascaded union of polygons the caller no longer needs.
+   *
+   * @param polygons Vector of polygons.
+   *
+   * @return The resulting polygon.
+   */
+  static Polygon compute_cascaded_union(std::vector<Polygon> &&polygons);
+
+  /**
+   * @brief Run many independent pairwise operations on the pool of the
+   * multi threaded operations. The threads take one job at a time, the
+   * largest by vertex count first, so a few huge jobs do not hold up the
+   * end of the batch while the other threads idle.
+   *
+   * @param requests The jobs.
+   * @param count Number of jobs.
+   *
+   * @return The result of every job as compute_operation gives it, in the
+   * order of the requests.
+   */
+  static std::vector<Polygon> compute_batch(const OperationRequest *requests,
+                                            size_t count);
+
+  /**
+   * @brief compute_batch without waiting for it. The requests are copied,
+   * the polygons they point to must live until the last job has finished.
+   * With a single configured thread the jobs run before the call returns.
+   *
+   * @param requests The jobs.
+   * @param count Number of jobs.
+   *
+   * @return A future per job, in the order of the requests, ready as soon as
+   * that job has finished.
+   */
+  static std::vector<std::future<Polygon>>
+  compute_batch_async(const OperationRequest *requests, size_t count);
+
+  /**
+   * @brief compute_batch handing every result to a callback as soon as it
+   * is done, in the order the jobs finish.
+   *
+   * @param requests The jobs, copied as above.
+   * @param count Number of jobs.
+   * @param callback Called with the index of the request and its result,
+   * from several threads at once.
+   *
+   * @return Ready once every callback has returned, holds the first
+   * exception an operation or callback threw.
+   */
+  static std::future<void>
+  compute_batch_async(const OperationRequest *requests, size_t count,
+                      std::function<void(size_t, Polygon &&)> callback);
+
+  /**
+   * @brief Configure the multi threaded operations for all later calls.
+   *
+   * @param options Thread count and grain size.
+   */
+  static void set_parallel_options(const ParallelOptions &options);
+
+  /**
+   * @brief Get the settings of the multi threaded operations.
+   *
+   * @return The current settings.
+   */
+  static ParallelOptions get_parallel_options();
+
+  /**
+   * @brief Configure the simplification of the operands of compute_*,
+   * compute_boolean, compute_operation and the apply_ops functions for all
+   * later calls. Valid polygons are simplified once per setting and the
+   * result is cached with them. The reductions simplify the polygons they
+   * are given, not their intermediate results. Polygon::stats reports the
+   * vertices removed.
+   *
+   * @param options Settings of the simplification, off by default.
+   */
+  static void set_simplify_options(const SimplifyOptions &options);
+
+  /**
+   * @brief Get the settings of the simplification.
+   *
+   * @return The current settings.
+   */
+  static SimplifyOptions get_simplify_options();
+
+  /**
+   * @brief Configure the cache of set operation results for all later calls.
+   * While it is enabled, the Polygon overloads of compute_* and
+   * compute_boolean, and so compute_operation and compute_batch, look each
+   * pair up by the content hash of both polygons and the operation before
+   * computing it, and store the rings they compute with a copy of both
+   * operands, which a hit has to match vertex for vertex. The reductions
+   * fold rings and do not use it. The least recently used results are
+   * evicted beyond maxBytes. Polygon::stats counts the hits, misses and
+   * evictions. Disabling the cache drops its results, so does changing the
+   * simplification.
+   *
+   * @param options Settings of the cache, off by default.
+   */
+  static void set_result_cache_options(const ResultCacheOptions &options);
+
+  /**
+   * @brief Get the settings of the result cache.
+   *
+   * @return The current settings.
+   */
+  static ResultCacheOptions get_result_cache_options();
+
+  /**
+   * @brief Get the memory taken by the results in the cache.
+   *
+   * @return Estimate in bytes.
+   */
+  static size_t result_cache_bytes();
+
+  /**
+   * @brief Get the counters since the last reset_stats, summed over all
+   * threads.
+   *
+   * @return The counters.
+   */
+  static OperationStats stats();
+
+  /**
+   * @brief Set every counter returned by stats back to zero.
+   */
+  static void reset_stats();
+
+  /**
+   * @brief Switch the hot path counters and timers on or off, they are off
+   * at start. Builds with POLYGON_ENABLE_STATS=0 never count.
+   *
+   * @param enabled True to count.
+   */
+  static void set_stats_enabled(bool enabled);
+
+  /**
+   * @brief Switch recording of trace spans on or off, they are off at start.
+   *
+   * @param enabled True to record.
+   */
+  static void set_trace_enabled(bool enabled);
+
+  /**
+   * @brief Write the spans recorded so far as Chrome trace JSON and forget
+   * them.
+   *
+   * @param filename The name of the file.
+   *
+   * @return True if the file was written.
+   */
+  static bool write_trace(const std::string &filename);
+
+private:
+  /**
+   * @brief Fold the rings of the polygons one by one, shared by the
+   * apply_ops and apply_ops_rings overloads.
+   *
+   * @param polygons Polygons to fold, consumed.
+   * @param op The specified operation.
+   *
+   * @return The resulting multi polygon.
+   */
+  static MultiPolygon fold_ops(std::vector<Polygon> polygons,
+                               SetOperation op);
+
+  /**
+   * @brief Tree reduction on the thread pool, shared by the multi threaded
+   * apply_ops and apply_ops_rings overloads.
+   *
+   * @param polygons Polygons to reduce, consumed.
+   * @param op The specified operation.
+   *
+   * @return The resulting multi polygon.
+   */
+  static MultiPolygon reduce_multi_threaded(std::vector<Polygon> polygons,
+                                            SetOperation op);
+};
+
+/**
+ * @brief Read only polygon whose vertices are stored elsewhere, in a
+ * Polygon, a vector or a memory mapped file. The vertices are taken as they
+ * are, in the order Polygon keeps them, and must outlive the view.
+ */
+class PolygonView {
+public:
+  /**
+   * @brief Empty view.
+   */
+  PolygonView();
+
+  /**
+   * @brief View of raw vertices with known bounds.
+   *
+   * @param points First vertex.
+   * @param count Number of vertices.
+   * @param bounds Bounding box of the vertices.
+   */
+  PolygonView(const Point *points, size_t count, const BoundingBox &bounds);
+
+  /**
+   * @brief View of a vector of vertices, the bounds are computed.
+   *
+   * @param points The vertices.
+   */
+  PolygonView(const std::vector<Point> &points);
+
+  /**
+   * @brief View of a polygon, sharing its cached bounds.
+   *
+   * @param polygon The polygon.
+   */
+  PolygonView(const Polygon &polygon);
+
+  /**
+   * @brief Get the vertices.
+   *
+   * @return First vertex.
+   */
+  const Point *data() const { return points; }
+
+  /**
+   * @brief Get the number of vertices.
+   *
+   * @return Number of vertices.
+   */
+  size_t size() const { return count; }
+
+  /**
+   * @brief Access a vertex.
+   *
+   * @param i Index of the vertex.
+   *
+   * @return The vertex.
+   */
+  const Point &operator[](size_t i) const { return points[i]; }
+
+  const Point *begin() const { return points; }       /**< First vertex. */
+  const Point *end() const { return points + count; } /**< Past the last. */
+
+  /**
+   * @brief Get the bounding box of the vertices.
+   *
+   * @return The bounding box.
+   */
+  const BoundingBox &get_bounding_box() const { return bounds; }
+
+  /**
+   * @brief Same checks as Polygon::is_valid, computed on every call.
+   *
+   * @return True if the polygon is valid, false otherwise.
+   */
+  bool is_valid() const;
+
+  /**
+   * @brief Same as Polygon::classify. The edge table is built on every call,
+   * prepare the view (see PreparedPolygon) for repeated queries.
+   *
+   * @param pts Points to classify.
+   * @param n Number of points.
+   * @param out Output per point: 1 inside, 0 on the boundary, -1 outside.
+   */
+  void classify(const Point *pts, size_t n, int8_t *out) const;
+
+private:
+  const Point *points = nullptr; /**< First vertex. */
+  size_t count = 0;              /**< Number of vertices. */
+  BoundingBox bounds;            /**< Box of the vertices. */
 };
 
 #endif // POLYGON_H
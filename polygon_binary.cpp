@@ -0,0 +1,329 @@
+#include "polygon_binary.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+/**< The file sections are viewed as these structures in place. */
+static_assert(sizeof(Point) == 2 * sizeof(double), "Point is x y doubles");
+static_assert(sizeof(BoundingBox) == 4 * sizeof(double),
+              "BoundingBox is minX minY maxX maxY doubles");
+
+namespace { /**< Internal helper functions */
+
+const char binary_magic[8] = {'P', 'O', 'L', 'Y', 'G', 'O', 'N', 'B'};
+const uint32_t binary_version = 1;    /**< Bumped on layout changes. */
+const size_t binary_header_size = 56; /**< Magic to file size. */
+
+/**< Output is handed to the stream in chunks of this size. */
+const size_t write_chunk_size = 1 << 20;
+
+/**< Byte order of the host, the file is always little-endian. */
+bool host_is_little_endian() {
+  const uint16_t one = 1;
+  unsigned char first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+/**< Little-endian loads, whatever the byte order of the host. */
+uint32_t load_u32(const char *bytes) {
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; --i)
+    value = (value << 8) | static_cast<unsigned char>(bytes[i]);
+  return value;
+}
+
+uint64_t load_u64(const char *bytes) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; --i)
+    value = (value << 8) | static_cast<unsigned char>(bytes[i]);
+  return value;
+}
+
+double load_f64(const char *bytes) {
+  const uint64_t bits = load_u64(bytes);
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+float load_f32(const char *bytes) {
+  const uint32_t bits = load_u32(bytes);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**< Little-endian stores, appended to a buffer. */
+void store_u32(std::string &buffer, uint32_t value) {
+  for (int i = 0; i < 4; ++i)
+    buffer.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+void store_u64(std::string &buffer, uint64_t value) {
+  for (int i = 0; i < 8; ++i)
+    buffer.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+void store_f64(std::string &buffer, double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  store_u64(buffer, bits);
+}
+
+void store_f32(std::string &buffer, float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  store_u32(buffer, bits);
+}
+
+/**< A vertex as it reads back from the file. */
+Point stored(const Point &point, CoordinateType type) {
+  if (type == CoordinateType::Float64)
+    return point;
+
+  Point rounded;
+  rounded.x = static_cast<float>(point.x);
+  rounded.y = static_cast<float>(point.y);
+  return rounded;
+}
+
+/**< The stored box is exactly the box of the vertices, empty polygons keep
+ * the default box. Non finite coordinates never match. */
+bool box_matches(const Point *points, size_t n, const BoundingBox &box) {
+  BoundingBox actual;
+  if (n > 0) {
+    actual.minX = actual.maxX = points[0].x;
+    actual.minY = actual.maxY = points[0].y;
+  }
+  for (size_t i = 1; i < n; ++i) {
+    actual.minX = std::min(actual.minX, points[i].x);
+    actual.maxX = std::max(actual.maxX, points[i].x);
+    actual.minY = std::min(actual.minY, points[i].y);
+    actual.maxY = std::max(actual.maxY, points[i].y);
+  }
+  return actual.minX == box.minX && actual.maxX == box.maxX &&
+         actual.minY == box.minY && actual.maxY == box.maxY;
+}
+
+/**< Hand the buffer to the stream once it holds a chunk. */
+void flush_chunk(std::ofstream &outputFile, std::string &buffer) {
+  if (buffer.size() >= write_chunk_size) {
+    outputFile.write(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+}
+} // namespace
+
+/**< Compares the first eight bytes only. */
+bool is_polygon_binary(const std::string &filename) {
+  std::ifstream inputFile(filename, std::ios::binary);
+  char magic[sizeof(binary_magic)];
+  if (!inputFile.read(magic, sizeof(magic)))
+    return false;
+  return std::memcmp(magic, binary_magic, sizeof(magic)) == 0;
+}
+
+/**< Header, offsets, boxes and coordinates in one sequential pass each. */
+bool write_polygon_binary(const std::string &filename,
+                          const std::vector<PolygonView> &polygons,
+                          CoordinateType type) {
+  std::ofstream outputFile(filename, std::ios::binary);
+  if (!outputFile.is_open())
+    return false;
+
+  const uint64_t count = polygons.size();
+  uint64_t vertices = 0;
+  for (const PolygonView &polygon : polygons)
+    vertices += polygon.size();
+
+  const size_t coordinateSize = (type == CoordinateType::Float64) ? 8 : 4;
+  const uint64_t offsetsOffset = binary_header_size;
+  const uint64_t boxesOffset = offsetsOffset + (count + 1) * 8;
+  const uint64_t coordinatesOffset = boxesOffset + count * 32;
+  const uint64_t fileSize = coordinatesOffset + vertices * 2 * coordinateSize;
+
+  std::string buffer;
+  buffer.reserve(write_chunk_size + 64);
+  buffer.append(binary_magic, sizeof(binary_magic));
+  store_u32(buffer, binary_version);
+  store_u32(buffer, static_cast<uint32_t>(type));
+  store_u64(buffer, count);
+  store_u64(buffer, offsetsOffset);
+  store_u64(buffer, boxesOffset);
+  store_u64(buffer, coordinatesOffset);
+  store_u64(buffer, fileSize);
+
+  uint64_t offset = 0;
+  store_u64(buffer, offset);
+  for (const PolygonView &polygon : polygons) {
+    offset += polygon.size();
+    store_u64(buffer, offset);
+    flush_chunk(outputFile, buffer);
+  }
+
+  /**< Boxes of the stored coordinates, which floats may have rounded. */
+  for (const PolygonView &polygon : polygons) {
+    BoundingBox box;
+    if (polygon.size() > 0) {
+      const Point first = stored(polygon[0], type);
+      box.minX = box.maxX = first.x;
+      box.minY = box.maxY = first.y;
+    }
+    for (const Point &vertex : polygon) {
+      const Point point = stored(vertex, type);
+      box.minX = std::min(box.minX, point.x);
+      box.maxX = std::max(box.maxX, point.x);
+      box.minY = std::min(box.minY, point.y);
+      box.maxY = std::max(box.maxY, point.y);
+    }
+    store_f64(buffer, box.minX);
+    store_f64(buffer, box.minY);
+    store_f64(buffer, box.maxX);
+    store_f64(buffer, box.maxY);
+    flush_chunk(outputFile, buffer);
+  }
+
+  for (const PolygonView &polygon : polygons) {
+    for (const Point &point : polygon) {
+      if (type == CoordinateType::Float64) {
+        store_f64(buffer, point.x);
+        store_f64(buffer, point.y);
+      } else {
+        store_f32(buffer, static_cast<float>(point.x));
+        store_f32(buffer, static_cast<float>(point.y));
+      }
+      flush_chunk(outputFile, buffer);
+    }
+  }
+
+  outputFile.write(buffer.data(), buffer.size());
+  return static_cast<bool>(outputFile);
+}
+
+PolygonFile::PolygonFile() {}
+
+/**< Every offset is checked against the file before any view is handed
+ * out, a damaged file is rejected rather than read out of bounds. */
+bool PolygonFile::open(const std::string &filename) {
+  close();
+  if (!file.open(filename))
+    return false;
+
+  const char *bytes = file.data();
+  const uint64_t size = file.size();
+  if (size < binary_header_size ||
+      std::memcmp(bytes, binary_magic, sizeof(binary_magic)) != 0 ||
+      load_u32(bytes + 8) != binary_version) {
+    close();
+    return false;
+  }
+
+  const uint32_t type = load_u32(bytes + 12);
+  const uint64_t polygons = load_u64(bytes + 16);
+  const uint64_t offsetsOffset = load_u64(bytes + 24);
+  const uint64_t boxesOffset = load_u64(bytes + 32);
+  const uint64_t coordinatesOffset = load_u64(bytes + 40);
+  const uint64_t fileSize = load_u64(bytes + 48);
+
+  const bool sectionsFit =
+      (fileSize == size) && (offsetsOffset % 8 == 0) &&
+      (boxesOffset % 8 == 0) && (coordinatesOffset % 8 == 0) &&
+      (offsetsOffset >= binary_header_size) && (offsetsOffset <= size) &&
+      (polygons < (size - offsetsOffset) / 8) &&
+      (boxesOffset >= offsetsOffset + (polygons + 1) * 8) &&
+      (boxesOffset <= size) && (polygons <= (size - boxesOffset) / 32) &&
+      (coordinatesOffset >= boxesOffset + polygons * 32) &&
+      (coordinatesOffset <= size);
+  const uint32_t lastType = static_cast<uint32_t>(CoordinateType::Float32);
+  if (!sectionsFit || (type > lastType)) {
+    close();
+    return false;
+  }
+
+  /**< Offsets must start at zero, never decrease and stay in the file. */
+  const size_t coordinateSize =
+      (type == static_cast<uint32_t>(CoordinateType::Float64)) ? 8 : 4;
+  const uint64_t capacity = (size - coordinatesOffset) / (2 * coordinateSize);
+  uint64_t previous = 0;
+  for (uint64_t p = 0; p <= polygons; ++p) {
+    const uint64_t offset = load_u64(bytes + offsetsOffset + 8 * p);
+    if ((p == 0 && offset != 0) || offset < previous || offset > capacity) {
+      close();
+      return false;
+    }
+    previous = offset;
+  }
+  const uint64_t vertices = previous;
+
+  /**< Mapped files are page aligned, the fallback buffer at least 8. */
+  const bool inPlace = host_is_little_endian() &&
+                       (reinterpret_cast<uintptr_t>(bytes) % 8 == 0);
+  if (inPlace) {
+    offsets = reinterpret_cast<const uint64_t *>(bytes + offsetsOffset);
+    boxes = reinterpret_cast<const BoundingBox *>(bytes + boxesOffset);
+  } else {
+    decodedOffsets.resize(polygons + 1);
+    for (uint64_t p = 0; p <= polygons; ++p)
+      decodedOffsets[p] = load_u64(bytes + offsetsOffset + 8 * p);
+    decodedBoxes.resize(polygons);
+    for (uint64_t p = 0; p < polygons; ++p) {
+      const char *box = bytes + boxesOffset + 32 * p;
+      decodedBoxes[p].minX = load_f64(box);
+      decodedBoxes[p].minY = load_f64(box + 8);
+      decodedBoxes[p].maxX = load_f64(box + 16);
+      decodedBoxes[p].maxY = load_f64(box + 24);
+    }
+    offsets = decodedOffsets.data();
+    boxes = decodedBoxes.data();
+  }
+
+  const char *coordinates = bytes + coordinatesOffset;
+  if (inPlace && coordinateSize == 8) {
+    points = reinterpret_cast<const Point *>(coordinates);
+  } else {
+    decoded.resize(vertices);
+    for (uint64_t i = 0; i < vertices; ++i) {
+      if (coordinateSize == 8) {
+        decoded[i].x = load_f64(coordinates + 16 * i);
+        decoded[i].y = load_f64(coordinates + 16 * i + 8);
+      } else {
+        decoded[i].x = load_f32(coordinates + 8 * i);
+        decoded[i].y = load_f32(coordinates + 8 * i + 4);
+      }
+    }
+    points = decoded.data();
+  }
+
+  /**< Views classify with the stored boxes, a wrong one would silently give
+   * wrong answers, so every box is checked once against its vertices. */
+  for (uint64_t p = 0; p < polygons; ++p) {
+    if (!box_matches(points + offsets[p], offsets[p + 1] - offsets[p],
+                     boxes[p])) {
+      close();
+      return false;
+    }
+  }
+
+  count = polygons;
+  return true;
+}
+
+void PolygonFile::close() {
+  file.close();
+  count = 0;
+  offsets = nullptr;
+  boxes = nullptr;
+  points = nullptr;
+  decodedOffsets.clear();
+  decodedBoxes.clear();
+  decoded.clear();
+}
+
+/**< Pointers into the mapping or the decoded copy. */
+PolygonView PolygonFile::operator[](size_t i) const {
+  return PolygonView(points + offsets[i], offsets[i + 1] - offsets[i],
+                     boxes[i]);
+}
@@ -0,0 +1,117 @@
+#ifndef POLYGON_BINARY_H
+#define POLYGON_BINARY_H
+
+#include "polygon.h"
+#include "polygon_io.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary container of many polygons, every field little-endian and
+ * every section 8 byte aligned:
+ *
+ *   header       56 bytes, see below
+ *   offsets      polygon count + 1 uint64, vertex i of polygon p is vertex
+ *                offsets[p] + i of the coordinate array
+ *   boxes        4 doubles per polygon, minX minY maxX maxY
+ *   coordinates  x y pairs of doubles or floats
+ *
+ * The header holds the magic "POLYGONB", a uint32 version, a uint32
+ * CoordinateType, then the uint64 polygon count, the byte offsets of the
+ * three sections and the file size. Vertices are stored in the order
+ * Polygon keeps them so loading needs no sorting.
+ */
+enum class CoordinateType : uint32_t {
+  Float64 = 0, /**< Exact, mapped without copying. */
+  Float32 = 1, /**< Half the size, decoded when the file is opened. */
+};
+
+/**
+ * @brief Check if a file starts with the magic of the binary container.
+ *
+ * @param filename The name of the file.
+ *
+ * @return True for binary polygon files.
+ */
+bool is_polygon_binary(const std::string &filename);
+
+/**
+ * @brief Write polygons to the binary container.
+ *
+ * @param filename The name of the file.
+ * @param polygons The polygons, stored in this order with their vertices as
+ * they are.
+ * @param type Precision of the stored coordinates.
+ *
+ * @return True if the file was written.
+ */
+bool write_polygon_binary(const std::string &filename,
+                          const std::vector<PolygonView> &polygons,
+                          CoordinateType type = CoordinateType::Float64);
+
+/**
+ * @brief A binary container opened for reading. Double precision files are
+ * memory mapped and viewed in place on little-endian hosts; float files and
+ * big-endian hosts get their coordinates decoded into memory once.
+ */
+class PolygonFile {
+public:
+  PolygonFile();
+
+  PolygonFile(const PolygonFile &) = delete;
+  PolygonFile &operator=(const PolygonFile &) = delete;
+
+  /**
+   * @brief Open and check a file, any previous file is released first. The
+   * sections must lie inside the file and the box of every polygon must be
+   * the box of its vertices, which takes one pass over the coordinates.
+   *
+   * @param filename The name of the file.
+   *
+   * @return True if the file could be opened and is well formed.
+   */
+  bool open(const std::string &filename);
+
+  /**
+   * @brief Release the file, views taken from it become invalid.
+   */
+  void close();
+
+  /**
+   * @brief Get the number of polygons.
+   *
+   * @return Number of polygons.
+   */
+  size_t size() const { return count; }
+
+  /**
+   * @brief View one polygon, valid until the file is closed.
+   *
+   * @param i Index of the polygon.
+   *
+   * @return The view.
+   */
+  PolygonView operator[](size_t i) const;
+
+  /**
+   * @brief Check whether the coordinates are read from the mapping itself.
+   *
+   * @return True if no coordinates were copied.
+   */
+  bool is_zero_copy() const { return decoded.empty() && count > 0; }
+
+private:
+  MappedFile file;                       /**< The mapped bytes. */
+  size_t count = 0;                      /**< Number of polygons. */
+  const uint64_t *offsets = nullptr;     /**< Vertex prefix sums. */
+  const BoundingBox *boxes = nullptr;    /**< Box per polygon. */
+  const Point *points = nullptr;         /**< All coordinates. */
+  std::vector<uint64_t> decodedOffsets;  /**< Offsets not in place. */
+  std::vector<BoundingBox> decodedBoxes; /**< Boxes not in place. */
+  std::vector<Point> decoded;            /**< Coordinates not in place. */
+};
+
+#endif // POLYGON_BINARY_H
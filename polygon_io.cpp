@@ -0,0 +1,260 @@
+#include "polygon_io.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define POLYGON_HAVE_MMAP 1 /**< POSIX file mapping available. */
+#endif
+
+namespace { /**< Internal helper functions */
+
+/**< Malformed line numbers kept for the report. */
+const size_t max_reported_lines = 10;
+
+/**< Output is handed to the stream in chunks of this size. */
+const size_t write_chunk_size = 1 << 20;
+
+/**< Field separators. */
+inline bool is_separator(char c) {
+  return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+/**
+ * @brief Split a line into its first fields.
+ *
+ * @param line The line without its newline.
+ * @param fields Output, up to four fields.
+ *
+ * @return Number of fields found, at most four.
+ */
+size_t split_fields(std::string_view line, std::string_view *fields) {
+  size_t count = 0;
+  size_t i = 0;
+  while (count < 4) {
+    while (i < line.size() && is_separator(line[i]))
+      ++i;
+    if (i == line.size())
+      break;
+    const size_t start = i;
+    while (i < line.size() && !is_separator(line[i]))
+      ++i;
+    fields[count++] = line.substr(start, i - start);
+  }
+  return count;
+}
+
+/**
+ * @brief Parse a whole field as a double.
+ *
+ * @param field The field.
+ * @param value Output, the number.
+ *
+ * @return True if the field is exactly one finite number.
+ */
+bool parse_double(std::string_view field, double &value) {
+  const char *first = field.data();
+  const char *last = first + field.size();
+  if (first != last && *first == '+')
+    ++first; /**< Accepted by operator>>, not by from_chars. */
+
+  /**< from_chars also reads nan and inf, which are no coordinates. */
+  const std::from_chars_result result = std::from_chars(first, last, value);
+  return result.ec == std::errc() && result.ptr == last &&
+         std::isfinite(value);
+}
+
+/**< Remember a malformed line. */
+void add_malformed(ReadReport &report, size_t line) {
+  report.malformedCount++;
+  if (report.malformed.size() < max_reported_lines)
+    report.malformed.push_back(line);
+}
+} // namespace
+
+/**< Count and the first line numbers. */
+std::ostream &operator<<(std::ostream &os, const ReadReport &report) {
+  os << report.malformedCount << " of " << report.lines
+     << " lines could not be parsed";
+  for (size_t i = 0; i < report.malformed.size(); ++i)
+    os << (i > 0 ? ", " : report.malformedCount == 1 ? " (line " : " (lines ")
+       << report.malformed[i];
+  if (!report.malformed.empty())
+    os << (report.malformedCount > report.malformed.size() ? ", ...)" : ")");
+  return os;
+}
+
+MappedFile::MappedFile() {}
+
+MappedFile::~MappedFile() { close(); }
+
+/**< mmap first, a plain read if that is unavailable or fails. */
+bool MappedFile::open(const std::string &filename) {
+  close();
+
+#if defined(POLYGON_HAVE_MMAP)
+  const int descriptor = ::open(filename.c_str(), O_RDONLY);
+  if (descriptor < 0)
+    return false;
+
+  struct stat status;
+  if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode)) {
+    length = static_cast<size_t>(status.st_size);
+    if (length == 0) {
+      ::close(descriptor);
+      return true;
+    }
+    void *address =
+        mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (address != MAP_FAILED) {
+      madvise(address, length, MADV_SEQUENTIAL);
+      ::close(descriptor);
+      bytes = static_cast<const char *>(address);
+      mapped = true;
+      return true;
+    }
+  }
+  ::close(descriptor);
+  length = 0;
+#endif
+
+  std::ifstream inputFile(filename, std::ios::binary);
+  if (!inputFile.is_open())
+    return false;
+
+  buffer.assign(std::istreambuf_iterator<char>(inputFile),
+                std::istreambuf_iterator<char>());
+  bytes = buffer.data();
+  length = buffer.size();
+  return true;
+}
+
+const char *MappedFile::data() const { return bytes; }
+
+size_t MappedFile::size() const { return length; }
+
+void MappedFile::close() {
+#if defined(POLYGON_HAVE_MMAP)
+  if (mapped)
+    munmap(const_cast<char *>(bytes), length);
+#endif
+  bytes = nullptr;
+  length = 0;
+  mapped = false;
+  buffer.clear();
+}
+
+/**< One pass over the text, no copies of the lines. */
+void parse_polygons(const char *text, size_t size,
+                    std::vector<std::vector<Point>> &rings,
+                    ReadReport &report) {
+  rings.clear();
+  report = ReadReport();
+
+  std::string_view currentId; /**< Id of the last vertex, empty for none. */
+  bool open = false;          /**< The last ring still takes vertices. */
+
+  const char *end = text + size;
+  for (const char *line = text; line < end;) {
+    const char *newline =
+        static_cast<const char *>(std::memchr(line, '\n', end - line));
+    const char *lineEnd = newline ? newline : end;
+    report.lines++;
+
+    std::string_view fields[4];
+    const size_t count = split_fields(
+        std::string_view(line, static_cast<size_t>(lineEnd - line)), fields);
+    line = newline ? newline + 1 : end;
+
+    if (count == 0) {
+      open = false; /**< Blank line, the next vertex starts a polygon. */
+      continue;
+    }
+    if (fields[0][0] == '#')
+      continue; /**< Comment, the polygon goes on. */
+
+    /**< Each line by its own field count, so one stray field costs only its
+     * own line. */
+    Point vertex;
+    const size_t first = (count == 3) ? 1 : 0;
+    if (count > 3 || !parse_double(fields[first], vertex.x) ||
+        !parse_double(fields[first + 1], vertex.y)) {
+      add_malformed(report, report.lines);
+      continue;
+    }
+
+    const std::string_view id = (count == 3) ? fields[0] : std::string_view();
+    if (id != currentId) {
+      currentId = id;
+      open = false;
+    }
+    if (!open) {
+      rings.emplace_back();
+      open = true;
+    }
+    rings.back().push_back(vertex);
+  }
+}
+
+/**< Parse straight out of the mapping. */
+bool read_polygons(const std::string &filename,
+                   std::vector<std::vector<Point>> &rings,
+                   ReadReport &report) {
+  MappedFile file;
+  if (!file.open(filename))
+    return false;
+
+  parse_polygons(file.data(), file.size(), rings, report);
+  return true;
+}
+
+/**< to_chars without a precision is the shortest round trip form. */
+void format_double(std::string &buffer, double value) {
+  char digits[32];
+  const std::to_chars_result result =
+      std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+/**< "x y" per vertex. */
+void format_points(std::string &buffer, const Point *points, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    format_double(buffer, points[i].x);
+    buffer.push_back(' ');
+    format_double(buffer, points[i].y);
+    buffer.push_back('\n');
+  }
+}
+
+/**< Formatted into one buffer, written whenever it fills up. */
+bool write_polygons(const std::string &filename,
+                    const std::vector<PolygonView> &rings) {
+  std::ofstream outputFile(filename, std::ios::binary);
+  if (!outputFile.is_open())
+    return false;
+
+  std::string buffer;
+  buffer.reserve(write_chunk_size + 64);
+  for (size_t r = 0; r < rings.size(); ++r) {
+    if (r > 0)
+      buffer.push_back('\n');
+
+    const PolygonView &ring = rings[r];
+    for (size_t i = 0; i < ring.size(); ++i) {
+      format_points(buffer, &ring[i], 1);
+      if (buffer.size() >= write_chunk_size) {
+        outputFile.write(buffer.data(), buffer.size());
+        buffer.clear();
+      }
+    }
+  }
+  outputFile.write(buffer.data(), buffer.size());
+  return static_cast<bool>(outputFile);
+}
@@ -0,0 +1,138 @@
+#ifndef POLYGON_IO_H
+#define POLYGON_IO_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Outcome of reading a text file. Malformed lines are collected here
+ * and reported once instead of one message per line.
+ */
+struct ReadReport {
+  size_t lines = 0;              /**< Lines in the file. */
+  size_t malformedCount = 0;     /**< Lines that could not be parsed. */
+  std::vector<size_t> malformed; /**< First few of them, 1 based. */
+
+  /**
+   * @brief Overloaded stream insertion operator, a one line summary of the
+   * malformed lines.
+   *
+   * @param os The output stream.
+   * @param report The report to output.
+   *
+   * @return Reference to the output stream.
+   */
+  friend std::ostream &operator<<(std::ostream &os, const ReadReport &report);
+};
+
+/**
+ * @brief Read only view of a whole file, memory mapped where the platform
+ * supports it and read into a buffer otherwise.
+ */
+class MappedFile {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @brief Map a file, any previous file is released first.
+   *
+   * @param filename The name of the file.
+   *
+   * @return True if the file could be opened.
+   */
+  bool open(const std::string &filename);
+
+  /**
+   * @brief Get the contents of the file.
+   *
+   * @return First byte of the file, valid until the file is closed.
+   */
+  const char *data() const;
+
+  /**
+   * @brief Get the size of the file.
+   *
+   * @return Size in bytes.
+   */
+  size_t size() const;
+
+  /**
+   * @brief Release the file.
+   */
+  void close();
+
+private:
+  const char *bytes = nullptr; /**< Start of the contents. */
+  size_t length = 0;           /**< Size of the contents. */
+  bool mapped = false;         /**< bytes is a mapping, not buffer. */
+  std::vector<char> buffer;    /**< Contents when mapping is unavailable. */
+};
+
+/**
+ * @brief Parse polygons from text, one vertex per line as "x y" or
+ * "id x y". Fields are separated by spaces, tabs or commas, lines starting
+ * with '#' are comments. A blank line ends a polygon, and so does a change
+ * of id, including from or to a line without one. Lines with other field
+ * counts or coordinates that are no finite numbers are malformed.
+ *
+ * @param text The text, need not be null terminated.
+ * @param size Length of the text.
+ * @param rings Output, the vertices of each polygon in file order.
+ * @param report Output, line counts and malformed lines.
+ */
+void parse_polygons(const char *text, size_t size,
+                    std::vector<std::vector<Point>> &rings,
+                    ReadReport &report);
+
+/**
+ * @brief Map a file and parse it with parse_polygons.
+ *
+ * @param filename The name of the file.
+ * @param rings Output, the vertices of each polygon in file order.
+ * @param report Output, line counts and malformed lines.
+ *
+ * @return True if the file could be opened.
+ */
+bool read_polygons(const std::string &filename,
+                   std::vector<std::vector<Point>> &rings, ReadReport &report);
+
+/**
+ * @brief Append a double in the shortest decimal form that reads back as the
+ * same value.
+ *
+ * @param buffer Text to append to.
+ * @param value The number.
+ */
+void format_double(std::string &buffer, double value);
+
+/**
+ * @brief Append vertices as "x y" lines, with the shortest decimal form that
+ * reads back as the same double.
+ *
+ * @param buffer Text to append to.
+ * @param points Vertices to write.
+ * @param count Number of vertices.
+ */
+void format_points(std::string &buffer, const Point *points, size_t count);
+
+/**
+ * @brief Write polygons as text, blank line separated, through one large
+ * buffer.
+ *
+ * @param filename The name of the file.
+ * @param rings Vertices of each polygon.
+ *
+ * @return True if the file was written.
+ */
+bool write_polygons(const std::string &filename,
+                    const std::vector<PolygonView> &rings);
+
+#endif // POLYGON_IO_H
@@ -0,0 +1,212 @@
+#include "predicates.h"
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace { /**< Internal helper functions */
+
+/**< Error bounds of the later stages, see Shewchuk section 4. */
+const double result_error_bound = (3.0 + 8.0 * unit_roundoff) * unit_roundoff;
+const double orient2d_bound_b = (2.0 + 12.0 * unit_roundoff) * unit_roundoff;
+const double orient2d_bound_c =
+    (9.0 + 64.0 * unit_roundoff) * unit_roundoff * unit_roundoff;
+
+/**< 2^27 + 1, splits a double into two halves of 26 bits each. */
+const double splitter = 134217729.0;
+
+/**
+ * The helpers below are error free transformations: every one returns the
+ * rounded result and the exact rounding error, so that x + y equals the
+ * exact result. This file must be compiled without contracting a * b + c
+ * into fused multiply adds, see CMakeLists.txt.
+ */
+
+/**< x + y = a + b exactly, requires |a| >= |b|. */
+inline void fast_two_sum(double a, double b, double &x, double &y) {
+  x = a + b;
+  y = b - (x - a);
+}
+
+/**< x + y = a + b exactly. */
+inline void two_sum(double a, double b, double &x, double &y) {
+  x = a + b;
+  const double bVirtual = x - a;
+  const double aVirtual = x - bVirtual;
+  y = (a - aVirtual) + (b - bVirtual);
+}
+
+/**< Rounding error of x = a - b. */
+inline double two_diff_tail(double a, double b, double x) {
+  const double bVirtual = a - x;
+  const double aVirtual = x + bVirtual;
+  return (a - aVirtual) + (bVirtual - b);
+}
+
+/**< x + y = a - b exactly. */
+inline void two_diff(double a, double b, double &x, double &y) {
+  x = a - b;
+  y = two_diff_tail(a, b, x);
+}
+
+/**< high + low = a, both halves fit in 26 bits. */
+inline void split(double a, double &high, double &low) {
+  const double c = splitter * a;
+  const double big = c - a;
+  high = c - big;
+  low = a - high;
+}
+
+/**< x + y = a * b exactly. */
+inline void two_product(double a, double b, double &x, double &y) {
+  x = a * b;
+  double aHigh, aLow, bHigh, bLow;
+  split(a, aHigh, aLow);
+  split(b, bHigh, bLow);
+  const double err1 = x - (aHigh * bHigh);
+  const double err2 = err1 - (aLow * bHigh);
+  const double err3 = err2 - (aHigh * bLow);
+  y = (aLow * bLow) - err3;
+}
+
+/**< (a1 + a0) - (b1 + b0) as a four component expansion x, smallest first. */
+inline void two_two_diff(double a1, double a0, double b1, double b0,
+                         double *x) {
+  double i, j, k;
+  two_diff(a0, b0, i, x[0]);
+  two_sum(a1, i, j, k);
+  two_diff(k, b1, i, x[1]);
+  two_sum(j, i, x[3], x[2]);
+}
+
+/**< Approximate value of an expansion. */
+double estimate(const double *e, int length) {
+  double sum = e[0];
+  for (int i = 1; i < length; ++i)
+    sum += e[i];
+  return sum;
+}
+
+/**
+ * @brief Sum of two nonoverlapping expansions, both ordered by increasing
+ * magnitude, without zero components (Shewchuk's
+ * fast_expansion_sum_zeroelim).
+ *
+ * @param e First expansion.
+ * @param eLength Components of e.
+ * @param f Second expansion.
+ * @param fLength Components of f.
+ * @param h Output, room for eLength + fLength components.
+ *
+ * @return Components of h.
+ */
+int expansion_sum(const double *e, int eLength, const double *f, int fLength,
+                  double *h) {
+  int ei = 0, fi = 0, hi = 0;
+  double q, sum, tail;
+
+  /**< Next component of smaller magnitude from either expansion. */
+  auto take_e = [&]() {
+    return fi >= fLength ||
+           (ei < eLength && ((f[fi] > e[ei]) == (f[fi] > -e[ei])));
+  };
+
+  q = take_e() ? e[ei++] : f[fi++];
+  if (ei < eLength && fi < fLength) {
+    const double next = take_e() ? e[ei++] : f[fi++];
+    fast_two_sum(next, q, sum, tail);
+    q = sum;
+    if (tail != 0.0)
+      h[hi++] = tail;
+  }
+  while (ei < eLength || fi < fLength) {
+    const double next = take_e() ? e[ei++] : f[fi++];
+    two_sum(q, next, sum, tail);
+    q = sum;
+    if (tail != 0.0)
+      h[hi++] = tail;
+  }
+  if (q != 0.0 || hi == 0)
+    h[hi++] = q;
+  return hi;
+}
+} // namespace
+
+/**< Shewchuk's orient2dadapt, stages B to D. */
+double orient2d_adaptive(const Point &a, const Point &b, const Point &c,
+                         double detsum) {
+  POLYGON_COUNT(predicateFallbacks, 1);
+
+  const double acx = a.x - c.x;
+  const double bcx = b.x - c.x;
+  const double acy = a.y - c.y;
+  const double bcy = b.y - c.y;
+
+  /**< Stage B, exact products of the rounded differences. */
+  double detLeft, detLeftTail, detRight, detRightTail;
+  two_product(acx, bcy, detLeft, detLeftTail);
+  two_product(acy, bcx, detRight, detRightTail);
+  double B[4];
+  two_two_diff(detLeft, detLeftTail, detRight, detRightTail, B);
+
+  double det = estimate(B, 4);
+  double bound = orient2d_bound_b * detsum;
+  if (det >= bound || -det >= bound)
+    return det;
+
+  /**< Stage C, first order correction for the rounding of the
+   * differences. */
+  const double acxTail = two_diff_tail(a.x, c.x, acx);
+  const double bcxTail = two_diff_tail(b.x, c.x, bcx);
+  const double acyTail = two_diff_tail(a.y, c.y, acy);
+  const double bcyTail = two_diff_tail(b.y, c.y, bcy);
+  if (acxTail == 0.0 && acyTail == 0.0 && bcxTail == 0.0 && bcyTail == 0.0)
+    return det; /**< The differences were exact, so is B. */
+
+  bound = orient2d_bound_c * detsum + result_error_bound * std::abs(det);
+  det += (acx * bcyTail + bcy * acxTail) - (acy * bcxTail + bcx * acyTail);
+  if (det >= bound || -det >= bound)
+    return det;
+
+  /**< Stage D, the exact determinant. */
+  double s1, s0, t1, t0, u[4];
+  double C1[8], C2[12], D[16];
+
+  two_product(acxTail, bcy, s1, s0);
+  two_product(acyTail, bcx, t1, t0);
+  two_two_diff(s1, s0, t1, t0, u);
+  const int c1Length = expansion_sum(B, 4, u, 4, C1);
+
+  two_product(acx, bcyTail, s1, s0);
+  two_product(acy, bcxTail, t1, t0);
+  two_two_diff(s1, s0, t1, t0, u);
+  const int c2Length = expansion_sum(C1, c1Length, u, 4, C2);
+
+  two_product(acxTail, bcyTail, s1, s0);
+  two_product(acyTail, bcxTail, t1, t0);
+  two_two_diff(s1, s0, t1, t0, u);
+  const int dLength = expansion_sum(C2, c2Length, u, 4, D);
+
+  return D[dLength - 1];
+}
+
+/**< Sides of each segment's ends relative to the other segment's line. */
+bool segments_meet_exact(const Point &p1, const Point &p2, const Point &p3,
+                         const Point &p4, double &fraction) {
+  const double start1 = orient2d(p3, p4, p1);
+  const double end1 = orient2d(p3, p4, p2);
+  const double start3 = orient2d(p1, p2, p3);
+  const double end3 = orient2d(p1, p2, p4);
+
+  /**< Both ends of one segment strictly on one side of the other line. */
+  if ((start1 > 0.0 && end1 > 0.0) || (start1 < 0.0 && end1 < 0.0) ||
+      (start3 > 0.0 && end3 > 0.0) || (start3 < 0.0 && end3 < 0.0))
+    return false;
+
+  /**< On one line, or one of them is a single point. */
+  if ((start1 == 0.0 && end1 == 0.0) || (start3 == 0.0 && end3 == 0.0))
+    return false;
+
+  fraction = std::min(1.0, std::max(0.0, start1 / (start1 - end1)));
+  return true;
+}
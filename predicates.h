@@ -0,0 +1,98 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include "polygon.h"
+
+#include <cfloat>
+#include <cmath>
+
+/**
+ * Adaptive precision orientation test after Shewchuk, "Adaptive Precision
+ * Floating-Point Arithmetic and Fast Robust Geometric Predicates" (1997).
+ * The plain floating point determinant is returned whenever its error bound
+ * proves the sign, only the rare near collinear cases fall back to exact
+ * expansion arithmetic in predicates.cpp. Requires round to nearest doubles
+ * without extended precision, as on every SSE2 target.
+ */
+
+/**< Unit roundoff, half the distance from 1.0 to the next double. */
+const double unit_roundoff = DBL_EPSILON / 2.0;
+
+/**< Relative error bound of the floating point determinant. */
+const double orient2d_filter_bound =
+    (3.0 + 16.0 * unit_roundoff) * unit_roundoff;
+
+/**
+ * @brief Exact orientation of a near collinear triple, the slow path of
+ * orient2d.
+ *
+ * @param a First point of the directed line.
+ * @param b Second point of the directed line.
+ * @param c Query point.
+ * @param detsum Sum of the absolute products of the determinant.
+ *
+ * @return An approximation of the determinant with the exact sign.
+ */
+double orient2d_adaptive(const Point &a, const Point &b, const Point &c,
+                         double detsum);
+
+/**
+ * @brief The floating point determinant of orient2d and whether its sign is
+ * proven, for callers that combine several tests before falling back.
+ *
+ * @param a First point of the directed line.
+ * @param b Second point of the directed line.
+ * @param c Query point.
+ * @param det Output, the rounded determinant.
+ *
+ * @return True if det has the exact sign.
+ */
+inline bool orient2d_filtered(const Point &a, const Point &b, const Point &c,
+                              double &det) {
+  const double detLeft = (a.x - c.x) * (b.y - c.y);
+  const double detRight = (a.y - c.y) * (b.x - c.x);
+  det = detLeft - detRight;
+
+  /**< Products of opposite sign cannot cancel, |det| then equals detsum up
+   * to rounding and passes the test, so one comparison covers every case. */
+  const double detsum = std::abs(detLeft) + std::abs(detRight);
+  return std::abs(det) >= orient2d_filter_bound * detsum;
+}
+
+/**
+ * @brief Twice the signed area of the triangle a, b, c with the exact sign.
+ *
+ * @param a First point of the directed line.
+ * @param b Second point of the directed line.
+ * @param c Query point.
+ *
+ * @return > 0: c lies left of the line a -> b (counter clockwise turn).
+ *         = 0: The points are exactly collinear.
+ *         < 0: c lies right of the line.
+ */
+inline double orient2d(const Point &a, const Point &b, const Point &c) {
+  double det;
+  if (orient2d_filtered(a, b, c, det))
+    return det;
+  return orient2d_adaptive(a, b, c,
+                           std::abs((a.x - c.x) * (b.y - c.y)) +
+                               std::abs((a.y - c.y) * (b.x - c.x)));
+}
+
+/**
+ * @brief Exact version of the intersection test of do_lines_intersect, for
+ * the pairs its filter cannot decide. Segments on one line and degenerate
+ * segments never meet, like parallel lines there.
+ *
+ * @param p1 Start of segment A.
+ * @param p2 End of segment A.
+ * @param p3 Start of segment B.
+ * @param p4 End of segment B.
+ * @param fraction Output, where along A they meet, in [0, 1].
+ *
+ * @return True if the segments share a point.
+ */
+bool segments_meet_exact(const Point &p1, const Point &p2, const Point &p3,
+                         const Point &p4, double &fraction);
+
+#endif // PREDICATES_H
@@ -0,0 +1,157 @@
+#include "result_cache.h"
+
+#include <cstring>
+#include <utility>
+
+namespace { /**< Internal helper functions */
+
+/**< Primes of xxHash64. */
+const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+const uint64_t prime3 = 0x165667B19E3779F9ull;
+
+/**< Bookkeeping per result besides its vertices: the list and map nodes and
+ * the polygon with its shared control block. */
+const size_t entry_overhead = 192;
+
+inline uint64_t rotate_left(uint64_t value, int shift) {
+  return (value << shift) | (value >> (64 - shift));
+}
+
+/**< One xxHash64 round. */
+inline uint64_t mix_round(uint64_t accumulator, uint64_t input) {
+  accumulator += input * prime2;
+  return rotate_left(accumulator, 31) * prime1;
+}
+
+/**< Final mix of xxHash64, every input bit reaches every output bit. */
+inline uint64_t avalanche(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= prime2;
+  hash ^= hash >> 29;
+  hash *= prime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/**< Bits of a coordinate, -0.0 and 0.0 hash apart. */
+inline uint64_t bits_of(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+/**< Memory a result and the copies of its operands take in the cache. */
+size_t bytes_of(const MultiPolygon &result, const PolygonView &A,
+                const PolygonView &B) {
+  return entry_overhead + sizeof(MultiPolygon) +
+         (result.get_number_of_points() + A.size() + B.size()) *
+             sizeof(Point);
+}
+
+/**< Same bits, as hashed by hash_points. */
+bool same_points(const std::vector<Point> &stored, const PolygonView &view) {
+  return stored.size() == view.size() &&
+         (stored.empty() ||
+          std::memcmp(stored.data(), view.begin(),
+                      stored.size() * sizeof(Point)) == 0);
+}
+} // namespace
+
+/**< Seeded with the length, so rings of repeated points differ. */
+ContentHash hash_points(const Point *points, size_t n) {
+  uint64_t low = prime1 + n;
+  uint64_t high = prime2 ^ n;
+  for (size_t i = 0; i < n; ++i) {
+    low = mix_round(low, bits_of(points[i].x));
+    high = mix_round(high, bits_of(points[i].y));
+  }
+
+  ContentHash hash;
+  hash.low = avalanche(low + rotate_left(high, 27));
+  hash.high = avalanche(high ^ (low * prime3));
+  return hash;
+}
+
+bool ResultCache::Key::operator==(const Key &other) const {
+  return a == other.a && b == other.b && sizeA == other.sizeA &&
+         sizeB == other.sizeB && op == other.op;
+}
+
+/**< The low words are already uniform. */
+size_t ResultCache::KeyHash::operator()(const Key &key) const {
+  return static_cast<size_t>(key.a.low ^ rotate_left(key.b.low, 1) ^
+                             static_cast<uint64_t>(key.op));
+}
+
+ResultCache::ResultCache(size_t maxBytes) : maxBytes(maxBytes) {}
+
+/**< A hit moves to the front, colliding operands are a miss. */
+std::shared_ptr<const MultiPolygon> ResultCache::find(const Key &key,
+                                                      const PolygonView &A,
+                                                      const PolygonView &B) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = byKey.find(key);
+  if (found == byKey.end() || !same_points(found->second->a, A) ||
+      !same_points(found->second->b, B))
+    return nullptr;
+
+  entries.splice(entries.begin(), entries, found->second);
+  return found->second->result;
+}
+
+/**< A result already held under the key is replaced, also one of colliding
+ * operands. */
+size_t ResultCache::insert(const Key &key, const PolygonView &A,
+                           const PolygonView &B,
+                           std::shared_ptr<const MultiPolygon> result) {
+  const size_t size = bytes_of(*result, A, B);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (size > maxBytes)
+    return 0;
+
+  auto found = byKey.find(key);
+  if (found != byKey.end()) {
+    bytes -= found->second->bytes;
+    entries.erase(found->second);
+    byKey.erase(found);
+  }
+
+  const size_t evicted = evict_to(maxBytes - size);
+  entries.push_front(Entry{key, std::vector<Point>(A.begin(), A.end()),
+                           std::vector<Point>(B.begin(), B.end()),
+                           std::move(result), size});
+  byKey.emplace(key, entries.begin());
+  bytes += size;
+  return evicted;
+}
+
+size_t ResultCache::set_capacity(size_t maxBytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  this->maxBytes = maxBytes;
+  return evict_to(maxBytes);
+}
+
+void ResultCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  byKey.clear();
+  entries.clear();
+  bytes = 0;
+}
+
+size_t ResultCache::size_in_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return bytes;
+}
+
+/**< Least recently used first. */
+size_t ResultCache::evict_to(size_t limit) {
+  size_t evicted = 0;
+  while (bytes > limit && !entries.empty()) {
+    bytes -= entries.back().bytes;
+    byKey.erase(entries.back().key);
+    entries.pop_back();
+    evicted++;
+  }
+  return evicted;
+}
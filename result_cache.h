@@ -0,0 +1,148 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "multi_polygon.h"
+#include "polygon.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Hash the coordinates of a ring in order, see
+ * Polygon::get_content_hash. The x and y coordinates go through two
+ * independent lanes of the xxHash64 round, so the cost is about one
+ * multiply per coordinate.
+ *
+ * @param points Vertices of the ring.
+ * @param n Number of vertices.
+ *
+ * @return The hash.
+ */
+ContentHash hash_points(const Point *points, size_t n);
+
+/**
+ * @brief Results of set operations by the content of their operands, see
+ * Polygon::set_result_cache_options. The least recently used results are
+ * evicted once the results held need more memory than the cap. Safe to use
+ * from any number of threads, one lock per lookup.
+ *
+ * Every entry keeps a copy of its operands, a lookup only hits if they are
+ * the same vertices bit for bit, so colliding hashes cost a miss and never
+ * return the result of other operands.
+ *
+ * Two threads missing the same key at once both compute the result, the
+ * second one to finish replaces the first.
+ */
+class ResultCache {
+public:
+  /**
+   * @brief What a result is stored under.
+   */
+  struct Key {
+    ContentHash a;   /**< Hash of the first operand. */
+    ContentHash b;   /**< Hash of the second operand. */
+    size_t sizeA;    /**< Vertices of the first operand. */
+    size_t sizeB;    /**< Vertices of the second operand. */
+    SetOperation op; /**< The operation. */
+
+    bool operator==(const Key &other) const;
+  };
+
+  /**
+   * @brief Make an empty cache.
+   *
+   * @param maxBytes Memory the results may take, 0 to keep none.
+   */
+  explicit ResultCache(size_t maxBytes = 0);
+
+  /**
+   * @brief Look a result up, a hit becomes the most recently used.
+   *
+   * @param key Operands and operation.
+   * @param A The first operand.
+   * @param B The second operand.
+   *
+   * @return The result, null if it is not held for these operands.
+   */
+  std::shared_ptr<const MultiPolygon> find(const Key &key,
+                                           const PolygonView &A,
+                                           const PolygonView &B);
+
+  /**
+   * @brief Store a result as the most recently used one, evicting others
+   * until it fits. Results larger than the cap are not stored.
+   *
+   * @param key Operands and operation.
+   * @param A The first operand, copied into the entry.
+   * @param B The second operand, copied into the entry.
+   * @param result The rings of the result.
+   *
+   * @return Number of results evicted.
+   */
+  size_t insert(const Key &key, const PolygonView &A, const PolygonView &B,
+                std::shared_ptr<const MultiPolygon> result);
+
+  /**
+   * @brief Change the cap, evicting results until the rest fit.
+   *
+   * @param maxBytes Memory the results may take.
+   *
+   * @return Number of results evicted.
+   */
+  size_t set_capacity(size_t maxBytes);
+
+  /**
+   * @brief Drop every result, not counted as evictions.
+   */
+  void clear();
+
+  /**
+   * @brief Memory taken by the results held.
+   *
+   * @return Estimate in bytes, vertices of the results and their operands
+   * and bookkeeping.
+   */
+  size_t size_in_bytes() const;
+
+private:
+  /**
+   * @brief Hash functor of the keys, the content hashes are well mixed.
+   */
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  /**
+   * @brief A result held, in the order of use.
+   */
+  struct Entry {
+    Key key;                                    /**< Where it is stored. */
+    std::vector<Point> a;                       /**< First operand, copied. */
+    std::vector<Point> b;                       /**< Second operand, copied. */
+    std::shared_ptr<const MultiPolygon> result; /**< The result. */
+    size_t bytes;                               /**< Memory it takes. */
+  };
+
+  mutable std::mutex mutex; /**< Guards everything below. */
+  size_t maxBytes;          /**< The cap. */
+  size_t bytes = 0;         /**< Memory taken by the entries. */
+  std::list<Entry> entries; /**< Most recently used first. */
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> byKey;
+
+  /**
+   * @brief Evict from the back until the entries fit below a limit, the
+   * lock has to be held.
+   *
+   * @param limit Memory the entries may take.
+   *
+   * @return Number of entries evicted.
+   */
+  size_t evict_to(size_t limit);
+};
+
+#endif // RESULT_CACHE_H
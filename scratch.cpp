@@ -0,0 +1,52 @@
+#include "scratch.h"
+
+#include <algorithm>
+#include <new>
+
+/**< The buffer is allocated up front and handed to the arena. */
+ScratchContext::ScratchContext(size_t initialBytes)
+    : buffer(new std::byte[std::max<size_t>(initialBytes, 1)]),
+      size(std::max<size_t>(initialBytes, 1)) {
+  arena.emplace(buffer.get(), size, &overflow);
+}
+
+/**< Grows the buffer to what the last operations needed in total. */
+void ScratchContext::release() {
+  arena->release();
+  const size_t used = size + overflow.bytes;
+  overflow.bytes = 0;
+  if (used == size || size >= max_scratch_bytes)
+    return;
+
+  size = std::min(max_scratch_bytes, used);
+  arena.reset();
+  buffer.reset(new std::byte[size]);
+  arena.emplace(buffer.get(), size, &overflow);
+}
+
+/**< One per thread, freed when the thread exits. */
+ScratchContext &ScratchContext::thread_context() {
+  thread_local ScratchContext context;
+  return context;
+}
+
+void *ScratchContext::Overflow::do_allocate(size_t bytes, size_t alignment) {
+  this->bytes += bytes;
+  return ::operator new(bytes, std::align_val_t(alignment));
+}
+
+void ScratchContext::Overflow::do_deallocate(void *pointer, size_t bytes,
+                                             size_t alignment) {
+  ::operator delete(pointer, bytes, std::align_val_t(alignment));
+}
+
+/**< Counts the depth so only the outermost scope releases. */
+ScratchScope::ScratchScope(ScratchContext *context)
+    : context(context ? *context : ScratchContext::thread_context()) {
+  ++this->context.depth;
+}
+
+ScratchScope::~ScratchScope() {
+  if (--context.depth == 0)
+    context.release();
+}
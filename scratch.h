@@ -0,0 +1,129 @@
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+/**
+ * Reusable memory for the temporaries of the set operations. An operation
+ * allocates its vertex buffers and point codes from a monotonic arena and
+ * drops them all at once when it ends, so once the arena has grown to the
+ * size of the largest operation seen, further operations make no heap
+ * allocations for them. Every thread has a context of its own, callers
+ * running batches may pass theirs instead to keep the memory with the
+ * batch.
+ */
+
+/**< Initial size of a scratch arena. */
+const size_t default_scratch_bytes = 64 * 1024;
+
+/**< Largest arena a context keeps between operations, larger operations get
+ * the rest from the heap every time. */
+const size_t max_scratch_bytes = 64 * 1024 * 1024;
+
+/**
+ * @brief A monotonic arena reset between operations. Not thread safe, use
+ * one context per thread.
+ */
+class ScratchContext {
+public:
+  /**
+   * @brief Create a context.
+   *
+   * @param initialBytes Size of the arena before it first grows.
+   */
+  explicit ScratchContext(size_t initialBytes = default_scratch_bytes);
+
+  ScratchContext(const ScratchContext &) = delete;
+  ScratchContext &operator=(const ScratchContext &) = delete;
+
+  /**
+   * @brief Get the arena to allocate from.
+   *
+   * @return The memory resource, valid until release.
+   */
+  std::pmr::memory_resource *resource() { return &*arena; }
+
+  /**
+   * @brief Free everything allocated since the last release. If the arena
+   * ran out, it is grown to what was used, up to max_scratch_bytes.
+   */
+  void release();
+
+  /**
+   * @brief Get the size of the arena.
+   *
+   * @return Bytes available before the heap is used.
+   */
+  size_t capacity() const { return size; }
+
+  /**
+   * @brief Get the context of the calling thread.
+   *
+   * @return The context, created on first use.
+   */
+  static ScratchContext &thread_context();
+
+private:
+  /**
+   * @brief The heap behind the arena, counting what the arena did not hold.
+   */
+  class Overflow : public std::pmr::memory_resource {
+  public:
+    size_t bytes = 0; /**< Allocated since the last release. */
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const
+        noexcept override {
+      return this == &other;
+    }
+  };
+
+  std::unique_ptr<std::byte[]> buffer; /**< Memory of the arena. */
+  size_t size = 0;                     /**< Its size in bytes. */
+  Overflow overflow;                   /**< Heap once buffer is full. */
+  std::optional<std::pmr::monotonic_buffer_resource> arena; /**< Over it. */
+  unsigned int depth = 0; /**< Open ScratchScopes on this context. */
+
+  friend class ScratchScope; /**< Opens and closes operations. */
+};
+
+/**
+ * @brief One operation on a scratch context. The outermost scope of a
+ * context releases it when it ends, so nested operations share the arena.
+ */
+class ScratchScope {
+public:
+  /**
+   * @brief Open an operation.
+   *
+   * @param context The context to allocate from, null for the one of the
+   * calling thread.
+   */
+  explicit ScratchScope(ScratchContext *context);
+
+  /**
+   * @brief Close the operation, releasing the context if it was the
+   * outermost one.
+   */
+  ~ScratchScope();
+
+  ScratchScope(const ScratchScope &) = delete;
+  ScratchScope &operator=(const ScratchScope &) = delete;
+
+  /**
+   * @brief Get the arena of the context.
+   *
+   * @return The memory resource.
+   */
+  std::pmr::memory_resource *resource() const { return context.resource(); }
+
+private:
+  ScratchContext &context; /**< The context in use. */
+};
+
+#endif // SCRATCH_H
@@ -0,0 +1,230 @@
+#include "simplify.h"
+#include "predicates.h"
+#include "sweep_line.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace { /**< Internal helper functions */
+
+/**< Times the tolerance is halved before a ring is left as it is. */
+const int max_topology_retries = 4;
+
+/**
+ * @brief Distance of a point from the segment a -> b, exactly zero for a
+ * point on the segment.
+ *
+ * @param point The point.
+ * @param a Start of the segment.
+ * @param b End of the segment, may equal a.
+ *
+ * @return The distance.
+ */
+double distance_to_segment(const Point &point, const Point &a,
+                           const Point &b) {
+  const double dx = b.x - a.x;
+  const double dy = b.y - a.y;
+  const double length2 = dx * dx + dy * dy;
+  const double t =
+      (length2 == 0.0)
+          ? 0.0
+          : ((point.x - a.x) * dx + (point.y - a.y) * dy) / length2;
+  if (t <= 0.0)
+    return std::hypot(point.x - a.x, point.y - a.y);
+  if (t >= 1.0)
+    return std::hypot(point.x - b.x, point.y - b.y);
+  return std::abs(orient2d(a, b, point)) / std::sqrt(length2);
+}
+
+/**
+ * @brief Douglas-Peucker on the chain ring[first..last], indices modulo the
+ * ring size so last may be the size of the ring for vertex 0. The end
+ * points are kept by the caller.
+ *
+ * @param ring The ring.
+ * @param first First vertex of the chain.
+ * @param last Last vertex of the chain.
+ * @param tolerance Largest distance of a removed vertex.
+ * @param keep Flag per vertex, set for the vertices kept.
+ */
+void douglas_peucker(const PolygonView &ring, size_t first, size_t last,
+                     double tolerance, std::vector<char> &keep) {
+  const size_t n = ring.size();
+  std::vector<std::pair<size_t, size_t>> pending{{first, last}};
+  while (!pending.empty()) {
+    const auto [start, end] = pending.back();
+    pending.pop_back();
+    if (end - start < 2)
+      continue;
+
+    const Point &a = ring[start];
+    const Point &b = ring[end % n];
+    double worst = -1.0;
+    size_t farthest = start;
+    for (size_t i = start + 1; i < end; ++i) {
+      const double distance = distance_to_segment(ring[i], a, b);
+      if (distance > worst) {
+        worst = distance;
+        farthest = i;
+      }
+    }
+
+    if (worst > tolerance) {
+      keep[farthest] = 1;
+      pending.emplace_back(start, farthest);
+      pending.emplace_back(farthest, end);
+    }
+  }
+}
+
+/**
+ * @brief Visvalingam-Whyatt on the chain ring[first..last], indexed like
+ * douglas_peucker. Vertices are removed smallest triangle first, the
+ * triangles of their neighbours are updated as they go.
+ *
+ * @param ring The ring.
+ * @param first First vertex of the chain.
+ * @param last Last vertex of the chain.
+ * @param tolerance Square root of the largest triangle area removed.
+ * @param minKept Interior vertices that have to remain.
+ * @param keep Flag per vertex, cleared for the vertices removed.
+ */
+void visvalingam_whyatt(const PolygonView &ring, size_t first, size_t last,
+                        double tolerance, size_t minKept,
+                        std::vector<char> &keep) {
+  const size_t n = ring.size();
+  const size_t count = last - first + 1; /**< Chain vertices. */
+  if (count < 3)
+    return;
+
+  /**< Neighbours in the chain as it shrinks, by offset from first. */
+  std::vector<size_t> previous(count);
+  std::vector<size_t> next(count);
+  std::vector<double> areas(count, 0.0);
+  for (size_t k = 0; k < count; ++k) {
+    previous[k] = k - 1;
+    next[k] = k + 1;
+  }
+  auto area_of = [&](size_t k) {
+    return std::abs(orient2d(ring[(first + previous[k]) % n],
+                             ring[(first + k) % n],
+                             ring[(first + next[k]) % n])) /
+           2.0;
+  };
+
+  using Entry = std::pair<double, size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+  for (size_t k = 1; k + 1 < count; ++k) {
+    areas[k] = area_of(k);
+    heap.emplace(areas[k], k);
+  }
+
+  const double limit = tolerance * tolerance;
+  size_t interior = count - 2;
+  while (!heap.empty() && interior > minKept) {
+    const auto [area, k] = heap.top();
+    heap.pop();
+    if (!keep[first + k] || area != areas[k])
+      continue; /**< Removed already, or its triangle changed. */
+    if (area > limit)
+      break;
+
+    keep[first + k] = 0;
+    interior--;
+    next[previous[k]] = next[k];
+    previous[next[k]] = previous[k];
+    for (size_t neighbour : {previous[k], next[k]}) {
+      if (neighbour == 0 || neighbour + 1 == count)
+        continue; /**< End points stay. */
+      areas[neighbour] = area_of(neighbour);
+      heap.emplace(areas[neighbour], neighbour);
+    }
+  }
+}
+
+/**
+ * @brief One simplification of the ring at a fixed tolerance.
+ *
+ * @param ring The ring.
+ * @param options Method of simplification.
+ * @param tolerance Tolerance of this attempt.
+ * @param pool Pool for the chunks, may be null.
+ * @param result Output, the kept vertices.
+ */
+void simplify_once(const PolygonView &ring, const SimplifyOptions &options,
+                   double tolerance, ThreadPool *pool,
+                   std::vector<Point> &result) {
+  const size_t n = ring.size();
+  const size_t chunks = std::max<size_t>(1, n / simplify_chunk_size);
+
+  /**< The chunk ends are set before any chunk runs, each chunk only
+   * writes the flags of its interior. */
+  std::vector<char> keep(n, 0);
+  for (size_t c = 0; c < chunks; ++c)
+    keep[c * n / chunks] = 1;
+
+  auto simplify_chunk = [&ring, &options, &keep, tolerance, n, chunks](
+                            size_t c) {
+    const size_t first = c * n / chunks;
+    const size_t last = (c + 1) * n / chunks;
+    if (options.method == SimplifyMethod::VisvalingamWhyatt) {
+      std::fill(keep.begin() + first + 1, keep.begin() + last, 1);
+      visvalingam_whyatt(ring, first, last, tolerance, chunks == 1 ? 2 : 0,
+                         keep);
+    } else {
+      douglas_peucker(ring, first, last, tolerance, keep);
+    }
+  };
+
+  if (chunks > 1 && pool) {
+    TaskGroup group(*pool);
+    for (size_t c = 0; c < chunks; ++c)
+      group.run([&simplify_chunk, c]() { simplify_chunk(c); });
+    group.wait();
+  } else {
+    for (size_t c = 0; c < chunks; ++c)
+      simplify_chunk(c);
+  }
+
+  /**< Repeats of a chunk end survive the chunk, drop them here. */
+  result.clear();
+  for (size_t i = 0; i < n; ++i) {
+    if (keep[i] && (result.empty() || result.back().x != ring[i].x ||
+                    result.back().y != ring[i].y))
+      result.push_back(ring[i]);
+  }
+  while (result.size() > 1 && result.front().x == result.back().x &&
+         result.front().y == result.back().y)
+    result.pop_back();
+}
+
+/**< True if the ring encloses some area. */
+bool has_area(const std::vector<Point> &ring) {
+  if (ring.size() < 3)
+    return false;
+  for (size_t i = 2; i < ring.size(); ++i)
+    if (orient2d(ring[0], ring[1], ring[i]) != 0.0)
+      return true;
+  return false;
+}
+} // namespace
+
+/**< Halves the tolerance until the ring stays simple. */
+size_t simplify_ring(const PolygonView &ring, const SimplifyOptions &options,
+                     ThreadPool *pool, std::vector<Point> &result) {
+  double tolerance = std::max(0.0, options.tolerance);
+  for (int attempt = 0; attempt <= max_topology_retries; ++attempt) {
+    simplify_once(ring, options, tolerance, pool, result);
+    if (has_area(result) &&
+        !(options.preserveTopology && has_self_intersection(result)))
+      return ring.size() - result.size();
+    tolerance /= 2.0;
+  }
+
+  result.assign(ring.begin(), ring.end());
+  return 0;
+}
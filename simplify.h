@@ -0,0 +1,43 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+/**< Rings with more vertices are cut into chunks of about this many
+ * vertices, whose end points are kept and which are simplified in parallel.
+ * The cut depends on the ring only, so the result does not depend on the
+ * number of threads. */
+const size_t simplify_chunk_size = 16384;
+
+/**
+ * @brief Drop the vertices of a ring that add less than the tolerance to
+ * its shape. Repeated and collinear vertices always go, the rest is thinned
+ * with Douglas-Peucker (no removed vertex lies further than the tolerance
+ * from the new boundary) or Visvalingam-Whyatt (vertices whose triangle with
+ * their neighbours is smaller than the tolerance squared are removed,
+ * smallest first).
+ *
+ * With topology preservation a result that intersects itself is thrown away
+ * and the ring simplified again with half the tolerance, a few times, before
+ * giving up. A ring that would shrink below three vertices or to no area is
+ * left as it is.
+ *
+ * @param ring Vertices of the ring, the last connects to the first.
+ * @param options Method, tolerance and topology preservation, enabled is
+ * not read.
+ * @param pool Pool the chunks of large rings run on, null to run them on the
+ * calling thread.
+ * @param result Output, cleared and filled with the kept vertices in ring
+ * order.
+ *
+ * @return Number of vertices removed, 0 if result is a copy of the ring.
+ */
+size_t simplify_ring(const PolygonView &ring, const SimplifyOptions &options,
+                     ThreadPool *pool, std::vector<Point> &result);
+
+#endif // SIMPLIFY_H
@@ -0,0 +1,136 @@
+#include "stats.h"
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace { /**< Internal helper functions */
+
+std::mutex totalsMutex; /**< Guards totals. */
+OperationStats totals;  /**< Everything recorded since the last reset. */
+
+/**< Share of rejected items in percent, 0 if nothing was counted. */
+double percent(uint64_t rejected, uint64_t total) {
+  return (total == 0) ? 0.0 : (100.0 * rejected) / total;
+}
+} // namespace
+
+/**< Counter wise sum. */
+OperationStats &OperationStats::operator+=(const OperationStats &other) {
+  operations += other.operations;
+  disjointOperations += other.disjointOperations;
+  edges += other.edges;
+  edgesRejected += other.edgesRejected;
+  edgePairs += other.edgePairs;
+  edgePairsRejected += other.edgePairsRejected;
+  pointTests += other.pointTests;
+  pointTestsRejected += other.pointTestsRejected;
+  convexOperations += other.convexOperations;
+  simplifiedVertices += other.simplifiedVertices;
+  verticesRemoved += other.verticesRemoved;
+  cacheHits += other.cacheHits;
+  cacheMisses += other.cacheMisses;
+  cacheEvictions += other.cacheEvictions;
+  segmentTests += other.segmentTests;
+  segmentHits += other.segmentHits;
+  predicateFallbacks += other.predicateFallbacks;
+  pointInPolygonCalls += other.pointInPolygonCalls;
+  edgesVisited += other.edgesVisited;
+  validityChecks += other.validityChecks;
+  validityComputed += other.validityComputed;
+  sorts += other.sorts;
+  sortSeconds += other.sortSeconds;
+  allocations += other.allocations;
+  allocatedBytes += other.allocatedBytes;
+  for (const ThreadStats &thread : other.threads) {
+    auto same = std::find_if(threads.begin(), threads.end(),
+                             [&](const ThreadStats &known) {
+                               return known.thread == thread.thread;
+                             });
+    if (same == threads.end()) {
+      threads.push_back(thread);
+    } else {
+      same->tasks += thread.tasks;
+      same->busySeconds += thread.busySeconds;
+    }
+  }
+  return *this;
+}
+
+/**< Implementation of the << operator. */
+std::ostream &operator<<(std::ostream &os, const OperationStats &stats) {
+  os << "Bounding box rejections:" << std::endl;
+  os << "operations: " << stats.disjointOperations << " of "
+     << stats.operations << " ("
+     << percent(stats.disjointOperations, stats.operations) << "%)"
+     << std::endl;
+  os << "edges: " << stats.edgesRejected << " of " << stats.edges << " ("
+     << percent(stats.edgesRejected, stats.edges) << "%)" << std::endl;
+  os << "edge pairs: " << stats.edgePairsRejected << " of "
+     << stats.edgePairs << " ("
+     << percent(stats.edgePairsRejected, stats.edgePairs) << "%)"
+     << std::endl;
+  os << "point tests: " << stats.pointTestsRejected << " of "
+     << stats.pointTests << " ("
+     << percent(stats.pointTestsRejected, stats.pointTests) << "%)"
+     << std::endl;
+  os << "Convex fast paths: " << stats.convexOperations << " of "
+     << stats.operations << " ("
+     << percent(stats.convexOperations, stats.operations) << "%)"
+     << std::endl;
+  os << "Simplification: " << stats.verticesRemoved << " of "
+     << stats.simplifiedVertices << " vertices removed ("
+     << percent(stats.verticesRemoved, stats.simplifiedVertices) << "%)"
+     << std::endl;
+  os << "Result cache: " << stats.cacheHits << " hits of "
+     << stats.cacheHits + stats.cacheMisses << " lookups ("
+     << percent(stats.cacheHits, stats.cacheHits + stats.cacheMisses)
+     << "%), " << stats.cacheEvictions << " evictions" << std::endl;
+
+  if (stats.segmentTests == 0 && stats.predicateFallbacks == 0 &&
+      stats.pointInPolygonCalls == 0 && stats.validityChecks == 0 &&
+      stats.sorts == 0 && stats.allocations == 0 && stats.threads.empty())
+    return os; /**< Hot path counters were off. */
+
+  os << "Hot paths:" << std::endl;
+  os << "segment tests: " << stats.segmentTests << " ("
+     << stats.segmentHits << " hits)" << std::endl;
+  os << "exact predicate fallbacks: " << stats.predicateFallbacks
+     << std::endl;
+  os << "points classified: " << stats.pointInPolygonCalls << " ("
+     << stats.edgesVisited << " edges visited)" << std::endl;
+  os << "validity checks: " << stats.validityChecks << " ("
+     << stats.validityComputed << " computed)" << std::endl;
+  os << "sorts: " << stats.sorts << " (" << stats.sortSeconds * 1e3
+     << " ms)" << std::endl;
+  os << "allocations: " << stats.allocations << " ("
+     << stats.allocatedBytes << " bytes)" << std::endl;
+  for (const ThreadStats &thread : stats.threads)
+    os << "thread " << thread.thread << ": " << thread.tasks << " tasks, "
+       << thread.busySeconds * 1e3 << " ms busy" << std::endl;
+  return os;
+}
+
+/**< One lock per operation. */
+void record_operation_stats(const OperationStats &stats) {
+  std::lock_guard<std::mutex> lock(totalsMutex);
+  totals += stats;
+}
+
+/**< Snapshot of the totals and the per thread counters. */
+OperationStats load_operation_stats() {
+  OperationStats snapshot;
+  {
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    snapshot = totals;
+  }
+  add_thread_counters(snapshot);
+  return snapshot;
+}
+
+/**< Start counting from zero. */
+void reset_operation_stats() {
+  std::lock_guard<std::mutex> lock(totalsMutex);
+  totals = OperationStats();
+  reset_thread_counters();
+}
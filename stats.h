@@ -0,0 +1,27 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "polygon.h"
+
+/**
+ * @brief Add the counters of one operation to the process wide totals.
+ * Operations count into a local OperationStats and record it once at the
+ * end, so the hot loops never touch shared state.
+ *
+ * @param stats Counters of the operation.
+ */
+void record_operation_stats(const OperationStats &stats);
+
+/**
+ * @brief Get the process wide totals.
+ *
+ * @return The counters recorded since the last reset.
+ */
+OperationStats load_operation_stats();
+
+/**
+ * @brief Set the process wide totals back to zero.
+ */
+void reset_operation_stats();
+
+#endif // STATS_H
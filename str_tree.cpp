@@ -0,0 +1,54 @@
+#include "str_tree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**< Slices of about sqrt(node count) nodes each. */
+std::vector<std::vector<size_t>> str_pack(const std::vector<BoundingBox> &boxes,
+                                          size_t capacity) {
+  const size_t n = boxes.size();
+  std::vector<std::vector<size_t>> nodes;
+  if (n == 0)
+    return nodes;
+
+  const size_t nodeCount = (n + capacity - 1) / capacity;
+  const size_t sliceCount =
+      static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(nodeCount))));
+  const size_t sliceSize = sliceCount * capacity;
+
+  std::vector<std::pair<double, size_t>> order(n);
+  for (size_t i = 0; i < n; ++i)
+    order[i] = std::make_pair(boxes[i].minX + boxes[i].maxX, i);
+  std::sort(order.begin(), order.end()); /**< Ties by index. */
+
+  for (size_t slice = 0; slice < n; slice += sliceSize) {
+    const size_t sliceEnd = std::min(n, slice + sliceSize);
+    for (size_t i = slice; i < sliceEnd; ++i) {
+      const size_t index = order[i].second;
+      order[i].first = boxes[index].minY + boxes[index].maxY;
+    }
+    std::sort(order.begin() + slice, order.begin() + sliceEnd);
+
+    for (size_t start = slice; start < sliceEnd; start += capacity) {
+      const size_t end = std::min(sliceEnd, start + capacity);
+      nodes.emplace_back();
+      for (size_t i = start; i < end; ++i)
+        nodes.back().push_back(order[i].second);
+    }
+  }
+  return nodes;
+}
+
+/**< Running min and max over the entries. */
+BoundingBox enclose(const std::vector<BoundingBox> &boxes,
+                    const std::vector<size_t> &entries) {
+  BoundingBox box = boxes[entries.front()];
+  for (size_t index : entries) {
+    box.minX = std::min(box.minX, boxes[index].minX);
+    box.minY = std::min(box.minY, boxes[index].minY);
+    box.maxX = std::max(box.maxX, boxes[index].maxX);
+    box.maxY = std::max(box.maxY, boxes[index].maxY);
+  }
+  return box;
+}
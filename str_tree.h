@@ -0,0 +1,35 @@
+#ifndef STR_TREE_H
+#define STR_TREE_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Group boxes into nodes of at most capacity entries with the
+ * Sort-Tile-Recursive packing. The boxes are sorted by the x of their
+ * centres and cut into vertical slices, each slice is sorted by y and cut
+ * into nodes, so every node holds boxes that lie close together. Applied
+ * again to the node boxes it yields the next level of the tree.
+ *
+ * @param boxes Boxes to group.
+ * @param capacity Largest number of entries per node, at least 2.
+ *
+ * @return Indices into boxes for each node, nodes ordered slice by slice.
+ */
+std::vector<std::vector<size_t>> str_pack(const std::vector<BoundingBox> &boxes,
+                                          size_t capacity);
+
+/**
+ * @brief Box enclosing a set of boxes.
+ *
+ * @param boxes All boxes.
+ * @param entries Indices of the boxes to enclose, not empty.
+ *
+ * @return The enclosing box.
+ */
+BoundingBox enclose(const std::vector<BoundingBox> &boxes,
+                    const std::vector<size_t> &entries);
+
+#endif // STR_TREE_H
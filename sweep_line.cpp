@@ -0,0 +1,645 @@
+#include "sweep_line.h"
+#include "external.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace { /**< Internal helper functions */
+
+/**< Below this many edge pairs the nested loop beats the sweep. */
+const size_t brute_force_pair_limit = 256;
+
+/**
+ * @brief Sign of the turn start -> end -> query.
+ *
+ * @return +1 if query lies left of (above) the directed line, -1 if it lies
+ * right of (below) it and 0 if the three points are collinear.
+ */
+inline int orientation(const Point &start, const Point &end,
+                       const Point &query) {
+  const double side = substitute_point_in_line(start, end, query);
+  return (side > 0.0) - (side < 0.0);
+}
+
+/**
+ * @brief An edge oriented from its lexicographically smallest endpoint.
+ */
+struct Segment {
+  Point left;  /**< Endpoint reached first by the sweep. */
+  Point right; /**< Endpoint reached last by the sweep. */
+  int ring;    /**< Index of the ring the edge belongs to. */
+  size_t edge; /**< Index of the edge's first vertex in its ring. */
+};
+
+/**
+ * @brief State shared by the sweeps below. The sweep line is vertical and
+ * moves left to right, events are ordered by Point::operator<. The status
+ * holds the active edges bottom to top. Its ordering predicate only ever
+ * compares against exact input vertices, anything else that changes the
+ * order (a crossing) swaps adjacent nodes in place.
+ */
+class SegmentSweep {
+protected:
+  /**< Status entry, the segment may be swapped in place at crossings. */
+  struct Node {
+    mutable int segment;
+  };
+
+  /**< Strict ordering of the status bottom to top at the sweep point. */
+  struct Order {
+    explicit Order(const SegmentSweep *owner) : sweep(owner) {}
+    bool operator()(const Node &a, const Node &b) const {
+      return sweep->is_below(a.segment, b.segment);
+    }
+    const SegmentSweep *sweep;
+  };
+
+  typedef std::set<Node, Order> Status;
+
+  /**< Everything that happens at one event point. */
+  struct Event {
+    Event() : ends(0) {}
+    std::vector<int> starts;                /**< Segments starting here. */
+    int ends;                               /**< Segments ending here. */
+    std::vector<std::pair<int, int>> swaps; /**< (lower, upper) crossings. */
+  };
+
+  SegmentSweep() : status(Order(this)), probe(-1) {}
+
+  /**< Queue the non degenerate edges of a closed ring. */
+  void add_ring(const PolygonView &points, int ring) {
+    for (size_t i = 0; i < points.size(); ++i)
+      add_edge(points, ring, i);
+  }
+
+  /**< Queue edge i of a closed ring unless it is degenerate. */
+  void add_edge(const PolygonView &points, int ring, size_t i) {
+    const Point &start = points[i];
+    const Point &end = points[(i + 1) % points.size()];
+    if ((start.x == end.x) && (start.y == end.y))
+      return; /**< Degenerate edges never intersect anything. */
+
+    Segment segment;
+    segment.left = (start < end) ? start : end;
+    segment.right = (start < end) ? end : start;
+    segment.ring = ring;
+    segment.edge = i;
+
+    const int id = segments.size();
+    segments.push_back(segment);
+    position.push_back(status.end());
+    events[segment.left].starts.push_back(id);
+    events[segment.right].ends++;
+  }
+
+  /**
+   * @brief Where the probe lies relative to segment s at the sweep point.
+   * The probe is either the segment being inserted, which passes through
+   * the sweep point, or the sweep point itself (probe == -1).
+   *
+   * @return < 0 if the probe is below s, > 0 if above, 0 if s contains the
+   * sweep point and the probe is the point.
+   */
+  int compare_probe(int s) const {
+    const Segment &segment = segments[s];
+    const int side = orientation(segment.left, segment.right, sweepPoint);
+    if (side != 0 || probe < 0)
+      return side;
+
+    /**< Both pass through the sweep point, order by direction after it. */
+    const int turn =
+        orientation(segment.left, segment.right, segments[probe].right);
+    if (turn != 0)
+      return turn;
+
+    return (probe < s) ? -1 : 1; /**< Collinear overlap, any fixed order. */
+  }
+
+  bool is_below(int a, int b) const {
+    if (a == b)
+      return false;
+    if (a == probe)
+      return compare_probe(b) < 0;
+    if (b == probe)
+      return compare_probe(a) > 0;
+    return a < b; /**< Not reached, the set only compares against a probe. */
+  }
+
+  /**
+   * @brief Move the sweep to an input vertex and take every active segment
+   * passing through it out of the status.
+   *
+   * @param point The vertex.
+   * @param through Output, the removed segments bottom to top.
+   * @param below Output, status entry below the removed ones or end().
+   * @param above Output, status entry above the removed ones or end().
+   */
+  void remove_through(const Point &point, std::vector<int> &through,
+                      Status::iterator &below, Status::iterator &above) {
+    sweepPoint = point;
+    probe = -1;
+
+    /**< Active segments through the point are contiguous. */
+    Status::iterator first = status.lower_bound(Node{-1});
+    Status::iterator last = first;
+    through.clear();
+    while (last != status.end() && compare_probe(last->segment) == 0) {
+      through.push_back(last->segment);
+      position[last->segment] = status.end();
+      ++last;
+    }
+
+    below = (first != status.begin()) ? std::prev(first) : status.end();
+    above = last;
+    status.erase(first, last);
+  }
+
+  /**
+   * @brief Insert the segments that continue past the sweep point.
+   *
+   * @param meeting Segments through the sweep point, ending ones are skipped.
+   * @param lowest Output, lowest inserted entry.
+   * @param highest Output, highest inserted entry.
+   *
+   * @return False if nothing continues past the sweep point.
+   */
+  bool insert_through(const std::vector<int> &meeting,
+                      Status::iterator &lowest, Status::iterator &highest) {
+    bool inserted = false;
+    for (size_t i = 0; i < meeting.size(); ++i) {
+      const int s = meeting[i];
+      if (!(sweepPoint < segments[s].right))
+        continue;
+      probe = s;
+      position[s] = status.insert(Node{s}).first;
+      inserted = true;
+    }
+    probe = -1;
+
+    if (!inserted)
+      return false;
+
+    lowest = status.lower_bound(Node{-1});
+    highest = lowest;
+    while (std::next(highest) != status.end() &&
+           compare_probe(std::next(highest)->segment) == 0)
+      ++highest;
+    return true;
+  }
+
+  std::vector<Segment> segments;
+  std::vector<Status::iterator> position; /**< end() when inactive. */
+  std::map<Point, Event> events;
+  Status status;
+  Point sweepPoint; /**< Current event point. */
+  int probe;        /**< Segment being located, -1 for the sweep point. */
+};
+
+/**
+ * @brief Bentley-Ottmann sweep reporting the crossings between the edges of
+ * ring 0 and ring 1. Crossings swap the two edges in the status.
+ */
+class CrossingSweep : public SegmentSweep {
+public:
+  /**< Sweep over the listed edges of each ring. */
+  CrossingSweep(const PolygonView &ringA, const PolygonView &ringB,
+                const std::vector<size_t> &edgesA,
+                const std::vector<size_t> &edgesB) {
+    rings[0] = ringA;
+    rings[1] = ringB;
+    for (size_t i = 0; i < edgesA.size(); ++i)
+      add_edge(ringA, 0, edgesA[i]);
+    for (size_t i = 0; i < edgesB.size(); ++i)
+      add_edge(ringB, 1, edgesB[i]);
+  }
+
+  void run(std::vector<EdgeCrossing> &crossings) {
+    std::vector<int> meeting;
+    while (!events.empty()) {
+      const Point point = events.begin()->first;
+      Event event;
+      std::swap(event, events.begin()->second);
+      events.erase(events.begin());
+
+      for (size_t i = 0; i < event.swaps.size(); ++i)
+        handle_swap(event.swaps[i].first, event.swaps[i].second, crossings);
+
+      if (event.starts.empty() && event.ends == 0)
+        continue;
+
+      Status::iterator below, above;
+      remove_through(point, meeting, below, above);
+      meeting.insert(meeting.end(), event.starts.begin(), event.starts.end());
+
+      /**< Every pair meeting at the vertex touches there. */
+      for (size_t i = 0; i < meeting.size(); ++i)
+        for (size_t j = i + 1; j < meeting.size(); ++j)
+          report(meeting[i], meeting[j], crossings);
+
+      Status::iterator lowest, highest;
+      if (!insert_through(meeting, lowest, highest)) {
+        check_pair(below, above);
+        continue;
+      }
+
+      if (lowest != status.begin())
+        check_pair(std::prev(lowest), lowest);
+      check_pair(highest, std::next(highest));
+    }
+  }
+
+private:
+  /**< Record the pair if do_lines_intersect agrees they intersect. */
+  void report(int a, int b, std::vector<EdgeCrossing> &crossings) const {
+    if (segments[a].ring == segments[b].ring)
+      return;
+    if (segments[a].ring != 0)
+      std::swap(a, b);
+
+    const PolygonView &A = rings[0];
+    const PolygonView &B = rings[1];
+    const size_t i = segments[a].edge;
+    const size_t j = segments[b].edge;
+
+    EdgeCrossing crossing;
+    if (do_lines_intersect(A[i], A[(i + 1) % A.size()], B[j],
+                           B[(j + 1) % B.size()], crossing.point)) {
+      crossing.edgeA = i;
+      crossing.edgeB = j;
+      crossings.push_back(crossing);
+    }
+  }
+
+  /**< Schedule a swap if the adjacent pair properly crosses ahead. */
+  void check_pair(Status::iterator lower, Status::iterator upper) {
+    if (lower == status.end() || upper == status.end())
+      return;
+
+    const int a = lower->segment;
+    const int b = upper->segment;
+    const Segment &below = segments[a];
+    const Segment &above = segments[b];
+    if (below.ring == above.ring)
+      return; /**< Edges of a simple ring never cross each other. */
+
+    const int startSide = orientation(above.left, above.right, below.left);
+    const int endSide = orientation(above.left, above.right, below.right);
+    if (startSide * endSide >= 0)
+      return;
+    if (orientation(below.left, below.right, above.left) *
+            orientation(below.left, below.right, above.right) >=
+        0)
+      return; /**< Touching pairs are handled at the shared vertex. */
+
+    if (startSide > 0)
+      return; /**< Already swapped, the crossing lies behind the sweep. */
+
+    /**< Intersection of the supporting lines, clamped onto the segments. */
+    const double dx1 = below.right.x - below.left.x;
+    const double dy1 = below.right.y - below.left.y;
+    const double dx2 = above.right.x - above.left.x;
+    const double dy2 = above.right.y - above.left.y;
+    double t = ((above.left.x - below.left.x) * dy2 -
+                (above.left.y - below.left.y) * dx2) /
+               (dx1 * dy2 - dy1 * dx2);
+    t = std::min(1.0, std::max(0.0, t));
+
+    Point point;
+    point.x = below.left.x + t * dx1;
+    point.y = below.left.y + t * dy1;
+    if (point < sweepPoint)
+      point = sweepPoint; /**< Rounding must not move events backwards. */
+
+    events[point].swaps.push_back(std::make_pair(a, b));
+  }
+
+  void handle_swap(int lower, int upper,
+                   std::vector<EdgeCrossing> &crossings) {
+    if (position[lower] == status.end() || position[upper] == status.end())
+      return;
+
+    Status::iterator below = position[lower];
+    Status::iterator above = position[upper];
+    if (std::next(below) != above)
+      return; /**< Stale, rescheduled once they are adjacent again. */
+
+    below->segment = upper;
+    above->segment = lower;
+    std::swap(position[lower], position[upper]);
+    report(lower, upper, crossings);
+
+    if (below != status.begin())
+      check_pair(std::prev(below), below);
+    check_pair(above, std::next(above));
+  }
+
+  PolygonView rings[2]; /**< Both rings, by value. */
+};
+
+/**
+ * @brief Shamos-Hoey sweep looking for any two non adjacent edges of one ring
+ * that intersect. The status never needs reordering because the sweep stops
+ * at the first intersection, which is found no later than when the two
+ * edges become neighbours.
+ */
+class SimplicitySweep : public SegmentSweep {
+public:
+  explicit SimplicitySweep(const PolygonView &ring) : points(ring) {
+    add_ring(ring, 0);
+  }
+
+  bool run() {
+    std::vector<int> meeting;
+    while (!events.empty()) {
+      const Point point = events.begin()->first;
+      const std::vector<int> starts = events.begin()->second.starts;
+      events.erase(events.begin());
+
+      Status::iterator below, above;
+      remove_through(point, meeting, below, above);
+      meeting.insert(meeting.end(), starts.begin(), starts.end());
+
+      for (size_t i = 0; i < meeting.size(); ++i)
+        for (size_t j = i + 1; j < meeting.size(); ++j)
+          if (intersect(meeting[i], meeting[j]))
+            return true;
+
+      Status::iterator lowest, highest;
+      if (!insert_through(meeting, lowest, highest)) {
+        if (below != status.end() && above != status.end() &&
+            intersect(below->segment, above->segment))
+          return true;
+        continue;
+      }
+
+      if (lowest != status.begin() &&
+          intersect(std::prev(lowest)->segment, lowest->segment))
+        return true;
+      if (std::next(highest) != status.end() &&
+          intersect(highest->segment, std::next(highest)->segment))
+        return true;
+    }
+    return false;
+  }
+
+private:
+  /**< Same test as has_self_intersection_brute_force. */
+  bool intersect(int a, int b) const {
+    const size_t n = points.size();
+    const size_t i = segments[a].edge;
+    const size_t j = segments[b].edge;
+    if ((i == j) || ((i + 1) % n == j) || ((j + 1) % n == i))
+      return false; /**< Neighbouring edges share a vertex by design. */
+
+    Point intersection;
+    return do_lines_intersect(points[i], points[(i + 1) % n], points[j],
+                              points[(j + 1) % n], intersection);
+  }
+
+  const PolygonView points;
+};
+
+/**< Box of the edge from start to end. */
+inline BoundingBox edge_bounds(const Point &start, const Point &end) {
+  BoundingBox box;
+  box.minX = std::min(start.x, end.x);
+  box.maxX = std::max(start.x, end.x);
+  box.minY = std::min(start.y, end.y);
+  box.maxY = std::max(start.y, end.y);
+  return box;
+}
+
+/**
+ * @brief Collect the edges of a ring whose box meets a given box, no other
+ * edge can cross anything inside that box.
+ *
+ * @param ring Vertices of the ring.
+ * @param box The box, usually the bounds of the other ring.
+ * @param edges Output, indices of the first vertex of the kept edges.
+ */
+void edges_meeting(const PolygonView &ring, const BoundingBox &box,
+                   std::vector<size_t> &edges) {
+  edges.clear();
+  for (size_t i = 0; i < ring.size(); ++i)
+    if (edge_bounds(ring[i], ring[(i + 1) % ring.size()]).overlaps(box))
+      edges.push_back(i);
+}
+
+/**
+ * @brief Nested loop over the kept edges, pairs whose boxes miss are not
+ * passed to do_lines_intersect.
+ *
+ * @param ringA Vertices of the first ring.
+ * @param ringB Vertices of the second ring.
+ * @param edgesA Kept edges of ring A, ascending.
+ * @param edgesB Kept edges of ring B, ascending.
+ * @param crossings Output, filled ordered by (edgeA, edgeB).
+ * @param stats Counters of tested and rejected pairs, may be null.
+ */
+void find_kept_edge_crossings(const PolygonView &ringA,
+                              const PolygonView &ringB,
+                              const std::vector<size_t> &edgesA,
+                              const std::vector<size_t> &edgesB,
+                              std::vector<EdgeCrossing> &crossings,
+                              OperationStats *stats) {
+  std::vector<BoundingBox> boxesB(edgesB.size());
+  for (size_t k = 0; k < edgesB.size(); ++k)
+    boxesB[k] = edge_bounds(ringB[edgesB[k]],
+                            ringB[(edgesB[k] + 1) % ringB.size()]);
+
+  uint64_t rejected = 0;
+  EdgeCrossing crossing;
+  for (size_t i : edgesA) {
+    const Point &startA = ringA[i];
+    const Point &endA = ringA[(i + 1) % ringA.size()];
+    const BoundingBox boxA = edge_bounds(startA, endA);
+
+    for (size_t k = 0; k < edgesB.size(); ++k) {
+      if (!boxA.overlaps(boxesB[k])) {
+        rejected++;
+        continue;
+      }
+      const size_t j = edgesB[k];
+      if (do_lines_intersect(startA, endA, ringB[j],
+                             ringB[(j + 1) % ringB.size()], crossing.point)) {
+        crossing.edgeA = i;
+        crossing.edgeB = j;
+        crossings.push_back(crossing);
+      }
+    }
+  }
+
+  if (stats) {
+    stats->edgePairs += edgesA.size() * edgesB.size();
+    stats->edgePairsRejected += rejected;
+  }
+}
+
+bool precedes(const EdgeCrossing &a, const EdgeCrossing &b) {
+  if (a.edgeA != b.edgeA)
+    return a.edgeA < b.edgeA;
+  return a.edgeB < b.edgeB;
+}
+
+/**
+ * @brief Crossings between the kept edges, by the nested loop for few pairs
+ * and by the sweep otherwise.
+ *
+ * @param ringA Vertices of the first ring.
+ * @param ringB Vertices of the second ring.
+ * @param edgesA Kept edges of ring A, ascending.
+ * @param edgesB Kept edges of ring B, ascending.
+ * @param crossings Output, filled ordered by (edgeA, edgeB).
+ * @param stats Counters of tested and rejected pairs, may be null.
+ */
+void search_kept_edges(const PolygonView &ringA, const PolygonView &ringB,
+                       const std::vector<size_t> &edgesA,
+                       const std::vector<size_t> &edgesB,
+                       std::vector<EdgeCrossing> &crossings,
+                       OperationStats *stats) {
+  if (edgesA.size() * edgesB.size() <= brute_force_pair_limit) {
+    find_kept_edge_crossings(ringA, ringB, edgesA, edgesB, crossings, stats);
+    return;
+  }
+
+  CrossingSweep sweep(ringA, ringB, edgesA, edgesB);
+  sweep.run(crossings);
+  std::sort(crossings.begin(), crossings.end(), precedes);
+}
+
+/**
+ * @brief Crossings of a run of the kept edges of ring A. The edges of B are
+ * narrowed down to the box of the run first, consecutive edges of a ring lie
+ * close together so few of them are left.
+ *
+ * @param ringA Vertices of the first ring.
+ * @param ringB Vertices of the second ring.
+ * @param edgesA The run of kept edges of ring A, ascending.
+ * @param edgesB Kept edges of ring B, ascending.
+ * @param crossings Output, filled ordered by (edgeA, edgeB).
+ * @param stats Counters of tested and rejected pairs.
+ */
+void search_edge_range(const PolygonView &ringA, const PolygonView &ringB,
+                       const std::vector<size_t> &edgesA,
+                       const std::vector<size_t> &edgesB,
+                       std::vector<EdgeCrossing> &crossings,
+                       OperationStats &stats) {
+  BoundingBox box = edge_bounds(ringA[edgesA.front()],
+                                ringA[(edgesA.front() + 1) % ringA.size()]);
+  for (size_t i : edgesA) {
+    const BoundingBox edge =
+        edge_bounds(ringA[i], ringA[(i + 1) % ringA.size()]);
+    box.minX = std::min(box.minX, edge.minX);
+    box.maxX = std::max(box.maxX, edge.maxX);
+    box.minY = std::min(box.minY, edge.minY);
+    box.maxY = std::max(box.maxY, edge.maxY);
+  }
+
+  std::vector<size_t> nearB;
+  for (size_t j : edgesB)
+    if (edge_bounds(ringB[j], ringB[(j + 1) % ringB.size()]).overlaps(box))
+      nearB.push_back(j);
+
+  search_kept_edges(ringA, ringB, edgesA, nearB, crossings, &stats);
+}
+} // namespace
+
+/**< Nested loop over all edge pairs, O(n * m). */
+void find_edge_crossings_brute_force(const PolygonView &ringA,
+                                     const PolygonView &ringB,
+                                     std::vector<EdgeCrossing> &crossings) {
+  crossings.clear();
+  EdgeCrossing crossing;
+
+  for (size_t i = 0; i < ringA.size(); i++) {
+    for (size_t j = 0; j < ringB.size(); j++) {
+      if (do_lines_intersect(ringA[i], ringA[(i + 1) % ringA.size()],
+                             ringB[j], ringB[(j + 1) % ringB.size()],
+                             crossing.point)) {
+        crossing.edgeA = i;
+        crossing.edgeB = j;
+        crossings.push_back(crossing);
+      }
+    }
+  }
+}
+
+/**< Bentley-Ottmann sweep, see sweep_line.h. */
+void find_edge_crossings(const PolygonView &ringA, const PolygonView &ringB,
+                         std::vector<EdgeCrossing> &crossings,
+                         OperationStats *stats, ThreadPool *pool) {
+  crossings.clear();
+
+  /**< Only edges reaching into the other ring's box can cross it. */
+  std::vector<size_t> edgesA, edgesB;
+  edges_meeting(ringA, ringB.get_bounding_box(), edgesA);
+  edges_meeting(ringB, ringA.get_bounding_box(), edgesB);
+  if (stats) {
+    stats->edges += ringA.size() + ringB.size();
+    stats->edgesRejected +=
+        (ringA.size() - edgesA.size()) + (ringB.size() - edgesB.size());
+  }
+
+  const size_t ranges = edgesA.size() / crossing_range_size;
+  if (ranges < 2) {
+    search_kept_edges(ringA, ringB, edgesA, edgesB, crossings, stats);
+    return;
+  }
+
+  /**< Each run of A edges is searched on its own, the runs are joined in
+   * order so the result is the same as from a single search. */
+  std::vector<std::vector<EdgeCrossing>> found(ranges);
+  std::vector<OperationStats> counted(ranges);
+  auto search_range = [&](size_t r) {
+    const std::vector<size_t> run(edgesA.begin() + r * edgesA.size() / ranges,
+                                  edgesA.begin() +
+                                      (r + 1) * edgesA.size() / ranges);
+    search_edge_range(ringA, ringB, run, edgesB, found[r], counted[r]);
+  };
+
+  if (pool) {
+    TaskGroup group(*pool);
+    for (size_t r = 0; r < ranges; ++r)
+      group.run([&search_range, r]() { search_range(r); });
+    group.wait();
+  } else {
+    for (size_t r = 0; r < ranges; ++r)
+      search_range(r);
+  }
+
+  for (size_t r = 0; r < ranges; ++r) {
+    crossings.insert(crossings.end(), found[r].begin(), found[r].end());
+    if (stats)
+      *stats += counted[r];
+  }
+}
+
+/**< Nested loop over all non adjacent edge pairs, O(n^2). */
+bool has_self_intersection_brute_force(const PolygonView &ring) {
+  for (size_t i = 0; i < ring.size(); i++) {
+    for (size_t j = 0; j < ring.size(); j++) {
+      if ((i != j) && ((i + 1) % ring.size() != j) &&
+          ((j + 1) % ring.size() != i)) {
+        Point intersection;
+        if (do_lines_intersect(ring[i], ring[(i + 1) % ring.size()], ring[j],
+                               ring[(j + 1) % ring.size()], intersection))
+          return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+/**< Shamos-Hoey sweep, see sweep_line.h. */
+bool has_self_intersection(const PolygonView &ring) {
+  if (ring.size() * ring.size() <= brute_force_pair_limit)
+    return has_self_intersection_brute_force(ring);
+
+  SimplicitySweep sweep(ring);
+  return sweep.run();
+}
@@ -0,0 +1,84 @@
+#ifndef SWEEP_LINE_H
+#define SWEEP_LINE_H
+
+#include "polygon.h"
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+/**< Rings with more edges near the other ring are searched in runs of about
+ * this many consecutive edges, in parallel if a pool is given. The runs
+ * depend on the rings only, so the crossings and counters do not depend on
+ * the number of threads. */
+const size_t crossing_range_size = 16384;
+
+/**
+ * @brief A crossing between an edge of ring A and an edge of ring B.
+ */
+struct EdgeCrossing {
+  size_t edgeA; /**< Index of the first vertex of the edge in ring A. */
+  size_t edgeB; /**< Index of the first vertex of the edge in ring B. */
+  Point point;  /**< Intersection point as computed by do_lines_intersect. */
+};
+
+/**
+ * @brief Find every crossing between the edges of two closed rings with a
+ * Bentley-Ottmann sweep. Runs in O((n + m + k) log(n + m)) for n and m edges
+ * and k crossings. Edges whose box misses the other ring's box are dropped
+ * first, small inputs then fall back to the nested edge loop, which skips
+ * pairs of edges whose boxes miss.
+ *
+ * Each ring is expected to be simple (see Polygon::is_valid), only crossings
+ * between an edge of A and an edge of B are reported. A pair is reported iff
+ * do_lines_intersect reports it, so parallel overlapping edges are skipped.
+ *
+ * @param ringA Vertices of the first ring, the last vertex connects to the
+ * first.
+ * @param ringB Vertices of the second ring.
+ * @param crossings Output, cleared and filled ordered by (edgeA, edgeB).
+ * @param stats Counters of the dropped edges and skipped pairs are added to
+ * it if not null.
+ * @param pool Pool the runs of a large ring A are searched on, null to
+ * search them on the calling thread.
+ */
+void find_edge_crossings(const PolygonView &ringA, const PolygonView &ringB,
+                         std::vector<EdgeCrossing> &crossings,
+                         OperationStats *stats = nullptr,
+                         ThreadPool *pool = nullptr);
+
+/**
+ * @brief Reference implementation of find_edge_crossings that tests every
+ * pair of edges. Kept for cross-checking the sweep.
+ *
+ * @param ringA Vertices of the first ring.
+ * @param ringB Vertices of the second ring.
+ * @param crossings Output, cleared and filled ordered by (edgeA, edgeB).
+ */
+void find_edge_crossings_brute_force(const PolygonView &ringA,
+                                     const PolygonView &ringB,
+                                     std::vector<EdgeCrossing> &crossings);
+
+/**
+ * @brief Check whether two non adjacent edges of a closed ring intersect with
+ * a Shamos-Hoey sweep, stopping at the first intersection found. Runs in
+ * O(n log n), small rings fall back to the nested edge loop.
+ *
+ * @param ring Vertices of the ring, the last vertex connects to the first.
+ *
+ * @return True if the ring intersects itself.
+ */
+bool has_self_intersection(const PolygonView &ring);
+
+/**
+ * @brief Reference implementation of has_self_intersection that tests every
+ * pair of non adjacent edges. Kept for cross-checking the sweep.
+ *
+ * @param ring Vertices of the ring.
+ *
+ * @return True if the ring intersects itself.
+ */
+bool has_self_intersection_brute_force(const PolygonView &ring);
+
+#endif // SWEEP_LINE_H
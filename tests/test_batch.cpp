@@ -0,0 +1,121 @@
+/**
+ * @file test_batch.cpp
+ * @brief Runs of the batch processor: report order, failures and outputs.
+ */
+
+#include "batch.h"
+#include "test_support.h"
+
+#include <cmath>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+/**< A file of the test in the temporary directory. */
+std::string temporary(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / ("batch_" + name)).string();
+}
+
+/**< Lines of the report. */
+std::vector<std::string> lines_of(const std::string &text) {
+  std::vector<std::string> lines;
+  std::istringstream stream(text);
+  for (std::string line; std::getline(stream, line);)
+    lines.push_back(line);
+  return lines;
+}
+
+bool starts_with(const std::string &text, const std::string &prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+/**< Area of the polygon written to a file, -1 if it cannot be read. */
+double area_of(const std::string &filename) {
+  Polygon polygon;
+  if (!polygon.read_file(filename))
+    return -1.0;
+  return std::abs(polygon.get_signed_area());
+}
+
+/**< Jobs with good and bad lines, at one and several compute threads. */
+void test_run_batch() {
+  const std::string a = temporary("a.csv");
+  const std::string b = temporary("b.csv");
+  const std::string c = temporary("c.csv");
+  square(0.0, 0.0, 2.0).write_file(a);
+  square(1.0, 1.0, 2.0).write_file(b);
+  square(0.5, 0.5, 2.0).write_file(c);
+  const std::string missing = temporary("missing.csv");
+
+  for (unsigned int threads : {1u, 4u}) {
+    const int which = static_cast<int>(threads);
+    const std::string unionOut = temporary("union.csv");
+    const std::string intersectionOut = temporary("intersection.csv");
+    std::filesystem::remove(unionOut);
+    std::filesystem::remove(intersectionOut);
+
+    std::ostringstream manifestText;
+    manifestText << "union " << unionOut << " " << a << " " << b << "\n"
+                 << "# comment\n"
+                 << "intersection " << intersectionOut << " " << a << " " << b
+                 << " " << c << "\n"
+                 << "union " << temporary("never.csv") << " " << a << " "
+                 << missing << "\n"
+                 << "\n"
+                 << "xor " << temporary("never.csv") << " " << a << " " << b
+                 << "\n"
+                 << "union " << temporary("never.csv") << "\r\n";
+    for (int i = 0; i < 8; ++i)
+      manifestText << "union " << temporary("repeat.csv") << " " << a << " "
+                   << b << "\n";
+
+    const ParallelOptions before = Polygon::get_parallel_options();
+    std::istringstream manifest(manifestText.str());
+    std::ostringstream report;
+    BatchOptions options;
+    options.computeThreads = threads;
+    const BatchSummary summary = run_batch(manifest, report, options);
+
+    check(summary.jobs == 13 && summary.failed == 3, "summary", which);
+    check(Polygon::get_parallel_options().threads == before.threads,
+          "parallel options restored", which);
+
+    const std::vector<std::string> lines = lines_of(report.str());
+    const std::vector<std::string> expected = {
+        "job 1 (line 1) union -> ",
+        "job 2 (line 3) intersection -> ",
+        "job 3 (line 4) failed: cannot read " + missing,
+        "job 4 (line 6) failed: unknown operation 'xor'",
+        "job 5 (line 7) failed: expected <operation> <output> <input>"};
+    bool ordered = lines.size() == 14;
+    for (size_t i = 0; ordered && i < expected.size(); ++i)
+      ordered = starts_with(lines[i], expected[i]);
+    for (size_t i = expected.size(); ordered && i < 13; ++i)
+      ordered = starts_with(lines[i], "job " + std::to_string(i + 1) +
+                                          " (line " + std::to_string(i + 3) +
+                                          ") union -> ");
+    ordered = ordered && starts_with(lines.back(), "13 jobs, 3 failed");
+    check(ordered, "report in manifest order", which);
+
+    check(std::abs(area_of(unionOut) - 7.0) < 1e-9, "union output", which);
+    check(std::abs(area_of(intersectionOut) - 1.0) < 1e-9,
+          "intersection output", which);
+    std::filesystem::remove(unionOut);
+    std::filesystem::remove(intersectionOut);
+    std::filesystem::remove(temporary("repeat.csv"));
+  }
+
+  std::filesystem::remove(a);
+  std::filesystem::remove(b);
+  std::filesystem::remove(c);
+}
+} // namespace
+
+int main() {
+  test_run_batch();
+
+  return finish_tests();
+}
@@ -0,0 +1,153 @@
+/**
+ * @file test_point_in_polygon.cpp
+ * @brief Seeded cross-checks of the batched and indexed point
+ * classification against is_point_inside_polygon.
+ */
+
+#include "external.h"
+#include "point_in_polygon.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+/**< Comb of teeth with horizontal edges at every tooth, concave. */
+std::vector<Point> comb_ring(size_t teeth) {
+  std::vector<Point> ring = {{0.0, 0.0}, {2.0 * teeth, 0.0}};
+  for (size_t i = teeth; i-- > 0;) {
+    const double x = 2.0 * i;
+    ring.push_back({x + 2.0, 3.0});
+    ring.push_back({x + 1.0, 3.0});
+    ring.push_back({x + 1.0, 1.0});
+    ring.push_back({x, 1.0});
+  }
+  return ring;
+}
+
+/**< Queries on a grid over the box, so many fall on edges and vertices, the
+ * vertices themselves, edge midpoints and points along horizontal edges. */
+std::vector<Point> queries_for(std::mt19937 &random,
+                               const std::vector<Point> &ring) {
+  const BoundingBox box = Polygon::from_ring(ring).get_bounding_box();
+  std::uniform_real_distribution<double> unit(-0.1, 1.1);
+  std::vector<Point> queries;
+  for (size_t i = 0; i < 301; ++i) {
+    const double x = box.minX + unit(random) * (box.maxX - box.minX);
+    const double y = box.minY + unit(random) * (box.maxY - box.minY);
+    queries.push_back({std::round(x * 8.0) / 8.0, std::round(y * 8.0) / 8.0});
+  }
+  for (size_t i = 0; i < ring.size(); ++i) {
+    const Point &start = ring[i];
+    const Point &end = ring[(i + 1) % ring.size()];
+    queries.push_back(start);
+    queries.push_back({(start.x + end.x) / 2.0, (start.y + end.y) / 2.0});
+    if (start.y == end.y) {
+      queries.push_back({start.x + (end.x - start.x) / 4.0, start.y});
+      queries.push_back({std::max(start.x, end.x) + 0.5, start.y});
+    }
+  }
+  return queries;
+}
+
+/**< Random concave rings, some snapped so they carry horizontal edges. */
+std::vector<std::vector<Point>> test_rings() {
+  std::vector<std::vector<Point>> rings = {comb_ring(1), comb_ring(7)};
+  for (int seed = 0; seed < 300; ++seed) {
+    std::mt19937 random(seed);
+    rings.push_back(star_ring(random, 5 + random() % 120, {0.0, 0.0}, 10.0,
+                              (seed % 2 == 0) ? 2.0 : 0.0));
+  }
+  return rings;
+}
+
+/**< Vector lanes and scalar tail of classify_points against the scalar
+ * winding number test. */
+void test_classify_points() {
+  const std::vector<std::vector<Point>> rings = test_rings();
+  for (size_t r = 0; r < rings.size(); ++r) {
+    std::mt19937 random(static_cast<unsigned int>(r));
+    const std::vector<Point> &ring = rings[r];
+    const std::vector<Point> queries = queries_for(random, ring);
+
+    const EdgeTable edges{PolygonView(ring)};
+    std::vector<int8_t> codes(queries.size());
+    classify_points(edges, queries.data(), queries.size(), codes.data());
+    const Polygon polygon = Polygon::from_ring(ring);
+    std::vector<int8_t> cached(queries.size());
+    polygon.classify(queries.data(), queries.size(), cached.data());
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+      const int expected = is_point_inside_polygon(queries[i], ring);
+      mismatches += (codes[i] != expected) + (cached[i] != expected);
+    }
+    check(mismatches == 0, "classify_points", static_cast<int>(r));
+  }
+}
+
+/**< Heights of the slab boundaries of PreparedPolygon, found as the index
+ * finds them: one slab per edge over the widened edge bounds, fewer when
+ * the edges are tall. */
+std::vector<double> slab_boundaries(const EdgeTable &edges) {
+  const size_t n = edges.size();
+  const double minY = *std::min_element(edges.minY.begin(), edges.minY.end());
+  const double maxY = *std::max_element(edges.maxY.begin(), edges.maxY.end());
+  double edgeHeights = 0.0;
+  for (size_t i = 0; i < n; ++i)
+    edgeHeights += edges.maxY[i] - edges.minY[i];
+  size_t slabs = n;
+  if (edgeHeights > 2.0 * (maxY - minY))
+    slabs = std::max<size_t>(1, static_cast<size_t>(2.0 * n * (maxY - minY) /
+                                                    edgeHeights));
+
+  std::vector<double> boundaries;
+  for (size_t s = 0; s <= slabs; ++s)
+    boundaries.push_back(minY + (maxY - minY) * s / slabs);
+  return boundaries;
+}
+
+/**< The slab index against the scalar winding number test, with extra
+ * queries on and one ulp around every slab boundary. */
+void test_prepared_polygon() {
+  const std::vector<std::vector<Point>> rings = test_rings();
+  for (size_t r = 0; r < rings.size(); ++r) {
+    std::mt19937 random(static_cast<unsigned int>(r));
+    const std::vector<Point> &ring = rings[r];
+    std::vector<Point> queries = queries_for(random, ring);
+
+    const EdgeTable edges{PolygonView(ring)};
+    for (double y : slab_boundaries(edges)) {
+      for (const Point &vertex : ring) {
+        queries.push_back({vertex.x, y});
+        queries.push_back({vertex.x, std::nextafter(y, -INFINITY)});
+        queries.push_back({vertex.x, std::nextafter(y, INFINITY)});
+      }
+    }
+
+    const PreparedPolygon prepared{PolygonView(ring)};
+    const PreparedPolygon shared(Polygon::from_ring(ring));
+    std::vector<int8_t> codes(queries.size());
+    prepared.classify(queries.data(), queries.size(), codes.data());
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+      const int expected = is_point_inside_polygon(queries[i], ring);
+      mismatches += (codes[i] != expected) +
+                    (shared.classify(queries[i]) != expected);
+    }
+    check(mismatches == 0, "PreparedPolygon::classify", static_cast<int>(r));
+  }
+}
+} // namespace
+
+int main() {
+  test_classify_points();
+  test_prepared_polygon();
+
+  return finish_tests();
+}
@@ -0,0 +1,164 @@
+/**
+ * @file test_polygon_binary.cpp
+ * @brief Round trips through the binary container and rejection of
+ * damaged files.
+ */
+
+#include "polygon_binary.h"
+#include "test_support.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+/**< Byte offsets of header fields, see polygon_binary.h. */
+const size_t boxes_field = 32;
+const size_t coordinates_field = 40;
+
+/**< A file of the test in the temporary directory. */
+std::string temporary(const char *name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::string read_bytes(const std::string &filename) {
+  std::ifstream inputFile(filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(inputFile),
+                     std::istreambuf_iterator<char>());
+}
+
+void write_bytes(const std::string &filename, const std::string &bytes) {
+  std::ofstream outputFile(filename, std::ios::binary);
+  outputFile.write(bytes.data(), bytes.size());
+}
+
+/**< Little-endian fields of the file. */
+uint64_t load_field(const std::string &bytes, size_t at) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; --i)
+    value = (value << 8) | static_cast<unsigned char>(bytes[at + i]);
+  return value;
+}
+
+void store_field(std::string &bytes, size_t at, uint64_t value) {
+  for (int i = 0; i < 8; ++i)
+    bytes[at + i] = static_cast<char>(value >> (8 * i));
+}
+
+/**< Seeded rings of several sizes, one of them empty. */
+std::vector<std::vector<Point>> test_rings() {
+  std::mt19937 random(11);
+  std::vector<std::vector<Point>> rings;
+  for (size_t n : {3, 17, 0, 400, 5})
+    rings.push_back(n == 0 ? std::vector<Point>()
+                           : star_ring(random, n, {1.0, -2.0}, 1e3, 0.0));
+  return rings;
+}
+
+/**< Open a changed copy of a good file. */
+bool opens(const std::string &bytes) {
+  const std::string filename = temporary("polygon_binary_damaged.pgb");
+  write_bytes(filename, bytes);
+  PolygonFile file;
+  const bool opened = file.open(filename);
+  std::filesystem::remove(filename);
+  return opened;
+}
+
+/**< Both precisions read back as written, floats rounded once. */
+void test_round_trip() {
+  const std::vector<std::vector<Point>> rings = test_rings();
+  std::vector<PolygonView> views(rings.begin(), rings.end());
+  const std::string filename = temporary("polygon_binary_round_trip.pgb");
+
+  for (CoordinateType type : {CoordinateType::Float64,
+                              CoordinateType::Float32}) {
+    const int which = static_cast<int>(type);
+    check(write_polygon_binary(filename, views, type), "write", which);
+    check(is_polygon_binary(filename), "is_polygon_binary", which);
+
+    PolygonFile file;
+    check(file.open(filename), "open", which);
+    check(file.size() == rings.size(), "polygon count", which);
+    for (size_t p = 0; p < file.size() && p < rings.size(); ++p) {
+      const PolygonView view = file[p];
+      bool same = view.size() == rings[p].size();
+      for (size_t i = 0; same && i < view.size(); ++i) {
+        const Point &expected = rings[p][i];
+        same = (type == CoordinateType::Float64)
+                   ? view[i].x == expected.x && view[i].y == expected.y
+                   : view[i].x == static_cast<float>(expected.x) &&
+                         view[i].y == static_cast<float>(expected.y);
+      }
+      check(same, "vertices read back", which);
+    }
+    check(file.is_zero_copy() == (type == CoordinateType::Float64),
+          "zero copy", which);
+  }
+  std::filesystem::remove(filename);
+
+  const std::string text = temporary("polygon_binary_text.csv");
+  write_bytes(text, "0 0\n1 0\n1 1\n");
+  check(!is_polygon_binary(text), "text is not binary", 0);
+  std::filesystem::remove(text);
+}
+
+/**< Every kind of damage is rejected by open. */
+void test_damaged_files() {
+  const std::vector<std::vector<Point>> rings = test_rings();
+  const std::string filename = temporary("polygon_binary_good.pgb");
+  write_polygon_binary(filename,
+                       std::vector<PolygonView>(rings.begin(), rings.end()));
+  const std::string good = read_bytes(filename);
+  std::filesystem::remove(filename);
+  check(opens(good), "good file", 0);
+
+  check(!opens(good.substr(0, good.size() - 8)), "truncated coordinates", 0);
+  check(!opens(good.substr(0, 20)), "truncated header", 0);
+  check(!opens(std::string()), "empty file", 0);
+
+  std::string bytes = good;
+  bytes[0] = 'X';
+  check(!opens(bytes), "bad magic", 0);
+
+  bytes = good;
+  bytes[8] = 9;
+  check(!opens(bytes), "unknown version", 0);
+
+  bytes = good;
+  store_field(bytes, coordinates_field, good.size() + 8);
+  check(!opens(bytes), "coordinates outside the file", 0);
+
+  bytes = good;
+  store_field(bytes, boxes_field, uint64_t(1) << 60);
+  check(!opens(bytes), "boxes outside the file", 0);
+
+  /**< Last vertex offset past the coordinates. */
+  bytes = good;
+  const size_t lastOffset = load_field(good, boxes_field) - 8;
+  store_field(bytes, lastOffset, load_field(good, lastOffset) + 1);
+  check(!opens(bytes), "vertex offset outside the file", 0);
+
+  /**< minX of the first box moved, the vertices are left alone. */
+  bytes = good;
+  const size_t firstBox = load_field(good, boxes_field);
+  const double moved = -1e9;
+  uint64_t bits;
+  std::memcpy(&bits, &moved, sizeof(bits));
+  store_field(bytes, firstBox, bits);
+  check(!opens(bytes), "box not matching its vertices", 0);
+}
+} // namespace
+
+int main() {
+  test_round_trip();
+  test_damaged_files();
+
+  return finish_tests();
+}
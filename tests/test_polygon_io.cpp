@@ -0,0 +1,87 @@
+/**
+ * @file test_polygon_io.cpp
+ * @brief Parsing of the text format, line by line.
+ */
+
+#include "polygon_io.h"
+#include "test_support.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+/**< Parse a text and compare the vertex counts of its rings and the lines
+ * reported malformed. */
+void check_parse(const char *text, const std::vector<size_t> &ringSizes,
+                 const std::vector<size_t> &malformed, const char *what) {
+  std::vector<std::vector<Point>> rings;
+  ReadReport report;
+  parse_polygons(text, std::strlen(text), rings, report);
+
+  bool same = rings.size() == ringSizes.size() &&
+              report.malformedCount == malformed.size() &&
+              report.malformed == malformed;
+  for (size_t i = 0; same && i < rings.size(); ++i)
+    same = rings[i].size() == ringSizes[i];
+  check(same, what, 0);
+}
+
+/**< Every kind of line the format knows. */
+void test_parse_polygons() {
+  check_parse("0 0\n1 0\n1 1\n", {3}, {}, "plain vertices");
+  check_parse("0,0\n1\t0\n 1 , 1 \n", {3}, {}, "separators");
+  check_parse("0 0\r\n1 0\r\n1 1\r\n", {3}, {}, "CRLF line ends");
+  check_parse("0 0\n1 0\n1 1", {3}, {}, "missing final newline");
+  check_parse("# header\n0 0\n1 0\n# between\n1 1\n", {3}, {}, "comments");
+  check_parse("\n\n0 0\n1 0\n1 1\n\n\n2 2\n3 2\n3 3\n\n", {3, 3}, {},
+              "blank lines");
+  check_parse("1 0 0\n1 1 0\n1 1 1\n2 5 5\n2 6 5\n2 6 6\n", {3, 3}, {},
+              "id changes");
+  check_parse("a 0 0\na 1 0\na 1 1\n0 5\n1 5\n", {3, 2}, {},
+              "id to no id");
+  check_parse("0 0\n1 x\n1 0\n1 1\n", {3}, {2}, "malformed line");
+  check_parse("1 2 x\n0 0\n1 0\n1 1\n", {3}, {1},
+              "stray field on the first line");
+  check_parse("0 0\n1 0 0 0\n1 0\n1 1\n", {3}, {2}, "too many fields");
+  check_parse("0\n0 0\n1 0\n1 1\n", {3}, {1}, "too few fields");
+  check_parse("nan 0\n0 0\ninf 1\n1 0\n1 -infinity\n1 1\n", {3}, {1, 3, 5},
+              "non finite coordinates");
+  check_parse("+1 2e3\n-1.5 .25\n1e-3 0\n", {3}, {}, "number forms");
+
+  /**< The reported line numbers are capped, the count is not. */
+  std::string many;
+  for (int i = 0; i < 25; ++i)
+    many += "x y\n";
+  std::vector<std::vector<Point>> rings;
+  ReadReport report;
+  parse_polygons(many.data(), many.size(), rings, report);
+  check(rings.empty() && report.malformedCount == 25 &&
+            report.malformed.size() == 10 && report.lines == 25,
+        "malformed report", 0);
+}
+
+/**< Written text reads back to the same doubles. */
+void test_round_trip() {
+  const std::vector<Point> ring = {
+      {0.1, 0.2}, {1e300, -3.0}, {-0.0, 5e-324}, {123456.789, 1.0 / 3.0}};
+  std::string text;
+  format_points(text, ring.data(), ring.size());
+
+  std::vector<std::vector<Point>> rings;
+  ReadReport report;
+  parse_polygons(text.data(), text.size(), rings, report);
+  bool same = rings.size() == 1 && rings[0].size() == ring.size();
+  for (size_t i = 0; same && i < ring.size(); ++i)
+    same = rings[0][i].x == ring[i].x && rings[0][i].y == ring[i].y;
+  check(same, "format_points round trip", 0);
+}
+} // namespace
+
+int main() {
+  test_parse_polygons();
+  test_round_trip();
+
+  return finish_tests();
+}
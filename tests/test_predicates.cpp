@@ -0,0 +1,190 @@
+/**
+ * @file test_predicates.cpp
+ * @brief Seeded checks of the adaptive orientation and the segment tests
+ * against exact integer arithmetic, on near degenerate inputs around 1e6
+ * where the floating point determinant gets the sign wrong. A build that
+ * contracts predicates.cpp into fused multiply adds fails here.
+ */
+
+#include "external.h"
+#include "predicates.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace { /**< Internal helper functions */
+
+/**< Every coordinate of the tests lies in [2^18, 2^21), where doubles are
+ * multiples of 2^-35. Scaled by 2^35 they are integers below 2^56, the
+ * determinant of those is exact in 128 bits. */
+const double lowest = 262144.0;
+const double highest = 2097152.0;
+
+__int128 fixed(double value) {
+  check(value >= lowest && value < highest, "coordinate in range", 0);
+  return static_cast<int64_t>(std::ldexp(value, 35));
+}
+
+/**< Exact sign of the determinant of orient2d. */
+int exact_orientation(const Point &a, const Point &b, const Point &c) {
+  const __int128 det = (fixed(a.x) - fixed(c.x)) * (fixed(b.y) - fixed(c.y)) -
+                       (fixed(a.y) - fixed(c.y)) * (fixed(b.x) - fixed(c.x));
+  return (det > 0) - (det < 0);
+}
+
+int sign(double value) { return (value > 0.0) - (value < 0.0); }
+
+/**< The coordinate steps ulps doubles away, both ways. */
+double step(double value, int ulps) {
+  for (; ulps > 0; --ulps)
+    value = std::nextafter(value, highest);
+  for (; ulps < 0; ++ulps)
+    value = std::nextafter(value, lowest);
+  return value;
+}
+
+/**< Point near t along a -> b, moved by a few ulps off the line. */
+Point near_line(std::mt19937 &random, const Point &a, const Point &b,
+                double t) {
+  std::uniform_int_distribution<int> ulps(-2, 2);
+  return {step(a.x + t * (b.x - a.x), ulps(random)),
+          step(a.y + t * (b.y - a.y), ulps(random))};
+}
+
+/**< Contract of segments_meet_exact from exact signs: the segments share a
+ * point unless one lies strictly on one side of the other's line, both lie
+ * on one line or one is a single point. */
+bool exact_meet(const Point &p1, const Point &p2, const Point &p3,
+                const Point &p4) {
+  const int start1 = exact_orientation(p3, p4, p1);
+  const int end1 = exact_orientation(p3, p4, p2);
+  const int start3 = exact_orientation(p1, p2, p3);
+  const int end3 = exact_orientation(p1, p2, p4);
+  if ((start1 * end1 > 0) || (start3 * end3 > 0))
+    return false;
+  return !((start1 == 0 && end1 == 0) || (start3 == 0 && end3 == 0));
+}
+
+/**< Point inside the bounding box of a segment, up to rounding. */
+bool in_box(const Point &point, const Point &start, const Point &end) {
+  const double slack = 1e-6;
+  return point.x >= std::min(start.x, end.x) - slack &&
+         point.x <= std::max(start.x, end.x) + slack &&
+         point.y >= std::min(start.y, end.y) - slack &&
+         point.y <= std::max(start.y, end.y) + slack;
+}
+
+/**< Both tests agree with the exact one, and a meeting point lies on the
+ * first segment up to rounding. Where along the second one it lies is ill
+ * conditioned for nearly parallel segments. */
+void check_segments(const Point &p1, const Point &p2, const Point &p3,
+                    const Point &p4, const char *what, int which) {
+  const bool expected = exact_meet(p1, p2, p3, p4);
+  double fraction = -1.0;
+  check(segments_meet_exact(p1, p2, p3, p4, fraction) == expected, what,
+        which);
+  if (expected)
+    check(fraction >= 0.0 && fraction <= 1.0, "fraction in [0, 1]", which);
+
+  Point meet;
+  check(do_lines_intersect(p1, p2, p3, p4, meet) == expected,
+        "do_lines_intersect", which);
+  if (expected)
+    check(in_box(meet, p1, p2),
+          "intersection point on the segments", which);
+}
+
+/**< Lines through random points, queries a few ulps off them and a line
+ * between points one ulp apart. The rounded determinant is wrong for part
+ * of these, the adaptive one never. */
+void test_orientation() {
+  std::uniform_real_distribution<double> coordinate(600000.0, 900000.0);
+  std::uniform_real_distribution<double> along(-1.0, 2.0);
+  int roundedWrong = 0;
+  for (int seed = 0; seed < 20000; ++seed) {
+    std::mt19937 random(seed);
+    const Point a = {coordinate(random), coordinate(random)};
+    const Point b = (seed % 4 == 0)
+                        ? Point{step(a.x, 1), step(a.y, (seed % 3) - 1)}
+                        : Point{coordinate(random), coordinate(random)};
+    const Point c = near_line(random, a, b, along(random));
+
+    const int expected = exact_orientation(a, b, c);
+    const double detLeft = (a.x - c.x) * (b.y - c.y);
+    const double detRight = (a.y - c.y) * (b.x - c.x);
+    if (sign(detLeft - detRight) != expected)
+      roundedWrong++;
+
+    check(sign(orient2d_adaptive(a, b, c,
+                                 std::abs(detLeft) + std::abs(detRight))) ==
+              expected,
+          "orient2d_adaptive", seed);
+    check(sign(orient2d(a, b, c)) == expected, "orient2d", seed);
+    check(sign(orient2d(b, c, a)) == expected, "orient2d rotated", seed);
+    check(sign(orient2d(b, a, c)) == -expected, "orient2d swapped", seed);
+  }
+  check(roundedWrong > 0, "rounded determinant fails somewhere", 0);
+}
+
+/**< Segments nearly on one line, touching at an end and overlapping. */
+void test_segments() {
+  std::uniform_real_distribution<double> coordinate(600000.0, 900000.0);
+  std::uniform_real_distribution<double> along(-0.5, 1.5);
+  for (int seed = 0; seed < 20000; ++seed) {
+    std::mt19937 random(seed);
+    const Point p1 = {coordinate(random), coordinate(random)};
+    const Point p2 = {coordinate(random), coordinate(random)};
+    Point p3, p4;
+    switch (seed % 3) {
+    case 0: /**< Nearly collinear, crossing or overlapping. */
+      p3 = near_line(random, p1, p2, along(random));
+      p4 = near_line(random, p1, p2, along(random));
+      break;
+    case 1: /**< One end a few ulps from the other segment. */
+      p3 = near_line(random, p1, p2, along(random));
+      p4 = {coordinate(random), coordinate(random)};
+      break;
+    default: /**< Sharing an end. */
+      p3 = (seed % 2 == 0) ? p1 : p2;
+      p4 = {coordinate(random), coordinate(random)};
+      break;
+    }
+    check_segments(p1, p2, p3, p4, "segments_meet_exact", seed);
+    check_segments(p3, p4, p1, p2, "segments_meet_exact swapped", seed);
+  }
+
+  const Point a = {600000.0, 600000.0}, b = {800000.0, 800000.0};
+  const Point c = {700000.0, 700000.0}, d = {900000.0, 900000.0};
+  double fraction = -1.0;
+  Point meet;
+
+  check(!segments_meet_exact(a, d, c, b, fraction), "overlap on one line", 0);
+  check(!do_lines_intersect(a, d, c, b, meet), "overlap on one line", 1);
+  check(!segments_meet_exact(a, b, a, a, fraction), "single point", 0);
+
+  const Point e = {800000.0, 600000.0};
+  check(segments_meet_exact(a, b, b, e, fraction) && fraction == 1.0,
+        "shared end", 0);
+  check(do_lines_intersect(a, b, b, e, meet) && meet.x == b.x && meet.y == b.y,
+        "shared end", 1);
+  check(segments_meet_exact(a, b, e, c, fraction) && fraction == 0.5,
+        "end on the other segment", 0);
+
+  /**< One ulp off the other segment, on either side. */
+  const Point above = {c.x, step(c.y, 1)}, below = {c.x, step(c.y, -1)};
+  check(!segments_meet_exact(a, b, e, below, fraction), "one ulp below", 0);
+  check(!do_lines_intersect(a, b, e, below, meet), "one ulp below", 1);
+  check(segments_meet_exact(a, b, e, above, fraction), "one ulp above", 0);
+  check(do_lines_intersect(a, b, e, above, meet), "one ulp above", 1);
+}
+} // namespace
+
+int main() {
+  test_orientation();
+  test_segments();
+
+  return finish_tests();
+}
@@ -0,0 +1,150 @@
+/**
+ * @file test_result_cache.cpp
+ * @brief Hits, misses and eviction order of the result cache, colliding
+ * keys, and lookups after vertex edits.
+ */
+
+#include "result_cache.h"
+#include "test_support.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+/**< Key of a pair of polygons as the set operations build it. */
+ResultCache::Key key_of(const Polygon &A, const Polygon &B, SetOperation op) {
+  return {A.get_content_hash(), B.get_content_hash(), A.get_number_of_points(),
+          B.get_number_of_points(), op};
+}
+
+/**< Hit or miss of a pair. */
+bool held(ResultCache &cache, const Polygon &A, const Polygon &B) {
+  return cache.find(key_of(A, B, SetOperation::Union), PolygonView(A),
+                    PolygonView(B)) != nullptr;
+}
+
+/**< Union of a pair through the cache. */
+MultiPolygon cached_union(const Polygon &A, const Polygon &B) {
+  return Polygon::compute_boolean(A, B, SetOperation::Union);
+}
+
+/**< Hits return the stored result, the least recently used entry goes
+ * first, and a key of other operands is a miss. */
+void test_cache_entries() {
+  const std::vector<Polygon> operands = {square(0.0, 0.0, 1.0),
+                                         square(2.0, 0.0, 1.0),
+                                         square(4.0, 0.0, 1.0),
+                                         square(6.0, 0.0, 1.0)};
+  const Polygon &other = operands[0];
+  const auto result =
+      std::make_shared<const MultiPolygon>(square(0.0, 0.0, 2.0));
+
+  ResultCache cache(size_t(1) << 20);
+  check(!held(cache, operands[0], other), "miss before insert", 0);
+  cache.insert(key_of(operands[0], other, SetOperation::Union),
+               PolygonView(operands[0]), PolygonView(other), result);
+  check(cache.find(key_of(operands[0], other, SetOperation::Union),
+                   PolygonView(operands[0]),
+                   PolygonView(other)) == result,
+        "hit after insert", 0);
+  check(cache.find(key_of(operands[0], other, SetOperation::Intersection),
+                   PolygonView(operands[0]), PolygonView(other)) == nullptr,
+        "other operation misses", 0);
+
+  /**< Same hashes and sizes, other vertices, as after a hash collision. */
+  check(cache.find(key_of(operands[0], other, SetOperation::Union),
+                   PolygonView(operands[1]), PolygonView(other)) == nullptr,
+        "colliding key misses", 0);
+
+  /**< Room for three entries of the same size. */
+  const size_t entryBytes = cache.size_in_bytes();
+  cache.clear();
+  cache.set_capacity(3 * entryBytes);
+  for (size_t i = 0; i < 3; ++i)
+    check(cache.insert(key_of(operands[i], other, SetOperation::Union),
+                       PolygonView(operands[i]), PolygonView(other),
+                       result) == 0,
+          "insert without eviction", static_cast<int>(i));
+
+  /**< Using the oldest one makes the second the least recently used. */
+  check(held(cache, operands[0], other), "oldest held", 0);
+  check(cache.insert(key_of(operands[3], other, SetOperation::Union),
+                     PolygonView(operands[3]), PolygonView(other),
+                     result) == 1,
+        "fourth insert evicts one", 0);
+  check(held(cache, operands[0], other), "used entry kept", 0);
+  check(!held(cache, operands[1], other), "least recently used evicted", 1);
+  check(held(cache, operands[2], other), "newer entry kept", 2);
+  check(held(cache, operands[3], other), "new entry held", 3);
+
+  /**< Shrinking keeps the most recently used one. */
+  check(cache.set_capacity(entryBytes) == 2, "shrinking evicts two", 0);
+  check(held(cache, operands[3], other), "most recent kept", 3);
+  check(!held(cache, operands[0], other), "older evicted", 0);
+  check(cache.size_in_bytes() == entryBytes, "size after shrinking", 0);
+}
+
+/**< Every vertex edit changes the content hash, the edited polygon misses
+ * and gets its own result, undoing the edit finds the first one again. */
+void test_cache_after_edits() {
+  std::mt19937 random(25);
+  const std::vector<Point> ring =
+      star_ring(random, 24, {0.0, 0.0}, 4.0, 64.0);
+  Polygon A = Polygon::from_ring(ring);
+  const Polygon B = square(1.0, -1.0, 6.0);
+
+  ResultCacheOptions options;
+  options.enabled = true;
+  Polygon::set_result_cache_options(options);
+  Polygon::reset_stats();
+
+  const MultiPolygon first = cached_union(A, B);
+  check(same_rings(cached_union(A, B), first), "hit returns the result", 0);
+  check(Polygon::stats().cacheHits == 1 && Polygon::stats().cacheMisses == 1,
+        "one miss then one hit", 0);
+
+  for (int edit = 0; edit < 3; ++edit) {
+    switch (edit) {
+    case 0:
+      A.insert_vertex(2, {0.0, 0.0});
+      break;
+    case 1:
+      A.move_vertex(3, {ring[2].x * 0.9, ring[2].y * 0.9});
+      break;
+    default:
+      A.remove_vertex(5);
+    }
+
+    /**< The view overloads bypass the cache. */
+    const PolygonView edited(A);
+    const std::vector<Point> vertices(edited.begin(), edited.end());
+    const MultiPolygon expected = Polygon::compute_boolean(
+        PolygonView(vertices), PolygonView(B), SetOperation::Union);
+
+    Polygon::reset_stats();
+    check(same_rings(cached_union(A, B), expected), "result after an edit",
+          edit);
+    check(Polygon::stats().cacheMisses == 1 && Polygon::stats().cacheHits == 0,
+          "miss after an edit", edit);
+  }
+
+  /**< Undone in reverse, the ring is the first one again. */
+  A.insert_vertex(5, ring[4]);
+  A.move_vertex(3, ring[2]);
+  A.remove_vertex(2);
+  Polygon::reset_stats();
+  check(same_rings(cached_union(A, B), first), "result after undoing", 0);
+  check(Polygon::stats().cacheHits == 1, "hit after undoing", 0);
+
+  Polygon::set_result_cache_options(ResultCacheOptions());
+}
+} // namespace
+
+int main() {
+  test_cache_entries();
+  test_cache_after_edits();
+
+  return finish_tests();
+}
@@ -0,0 +1,306 @@
+/**
+ * @file test_set_operations.cpp
+ * @brief Results of the set operations and their reductions.
+ */
+
+#include "multi_polygon.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+/**< Area of a polygon, whichever way it runs. */
+double area_of(const Polygon &polygon) {
+  return std::abs(polygon.get_signed_area());
+}
+
+/**< Shoelace sum of a ring, positive if it runs counter clockwise. */
+double signed_area(const PolygonView &ring) {
+  double sum = 0.0;
+  for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+    sum += ring[j].x * ring[i].y - ring[i].x * ring[j].y;
+  return sum / 2.0;
+}
+
+/**< Close up to rounding, relative to scale. */
+bool near(double value, double expected, double scale) {
+  return std::abs(value - expected) <= 1e-9 * scale;
+}
+
+/**< |A u B| = |A| + |B| - |A n B| and |A - B| = |A| - |A n B| on seeded
+ * overlapping star rings, and the single ring operations agree with the
+ * sweep whenever it gives one ring. */
+void test_area_identities() {
+  for (int seed = 0; seed < 50; ++seed) {
+    std::mt19937 random(seed);
+    const Polygon A = Polygon::from_ring(
+        star_ring(random, 20 + seed, {0.0, 0.0}, 10.0, 0.0));
+    const Polygon B = Polygon::from_ring(
+        star_ring(random, 30, {seed % 7 - 3.0, 4.0}, 8.0, 0.0));
+    const MultiPolygon united =
+        Polygon::compute_boolean(A, B, SetOperation::Union);
+    const MultiPolygon common =
+        Polygon::compute_boolean(A, B, SetOperation::Intersection);
+    const MultiPolygon rest =
+        Polygon::compute_boolean(A, B, SetOperation::Difference);
+    const double scale = area_of(A) + area_of(B);
+
+    check(united.is_valid() && common.is_valid() && rest.is_valid(),
+          "valid rings", seed);
+    check(near(united.get_area(),
+               area_of(A) + area_of(B) - common.get_area(), scale),
+          "union area", seed);
+    check(near(rest.get_area(), area_of(A) - common.get_area(), scale),
+          "difference area", seed);
+
+    const Polygon single = Polygon::compute_union(A, B);
+    if (united.ring_count() == 1)
+      check(single.is_valid() && near(area_of(single), united.get_area(),
+                                       scale),
+            "single ring union", seed);
+    else
+      check(single.get_number_of_points() == 0, "several rings union",
+            seed);
+  }
+}
+
+/**< Touching, disjoint and identical inputs, a hole cut by a difference and
+ * a clockwise input. */
+void test_degenerate_inputs() {
+  const Polygon A = square(0.0, 0.0, 2.0);
+
+  /**< The shared edge disappears, its collinear ends with it. */
+  const Polygon beside = square(2.0, 0.0, 2.0);
+  const Polygon joined = Polygon::compute_union(A, beside);
+  check(joined.get_number_of_points() == 4 && area_of(joined) == 8.0,
+        "shared edge union", 0);
+  check(Polygon::compute_boolean(A, beside, SetOperation::Intersection)
+                .get_area() == 0.0,
+        "shared edge intersection", 0);
+  check(area_of(Polygon::compute_subtraction(A, beside)) == 4.0,
+        "shared edge difference", 0);
+
+  /**< Corners touching at one vertex enclose no area together. */
+  const Polygon corner = square(2.0, 2.0, 2.0);
+  check(Polygon::compute_boolean(A, corner, SetOperation::Union).get_area() ==
+            8.0,
+        "vertex touch union", 0);
+  check(Polygon::compute_boolean(A, corner, SetOperation::Intersection)
+                .get_area() == 0.0,
+        "vertex touch intersection", 0);
+  check(area_of(Polygon::compute_subtraction(A, corner)) == 4.0,
+        "vertex touch difference", 0);
+
+  /**< A square cut out of the middle leaves an outer ring and a hole. */
+  const Polygon frame = square(-1.0, -1.0, 4.0);
+  const MultiPolygon holed =
+      Polygon::compute_boolean(frame, A, SetOperation::Difference);
+  check(holed.ring_count() == 2 && holed.get_area() == 12.0,
+        "difference with a hole", 0);
+  check(holed.ring_count() == 2 && signed_area(holed.ring(0)) > 0.0 &&
+            signed_area(holed.ring(1)) < 0.0,
+        "outer ring counter clockwise, hole clockwise", 0);
+  check(Polygon::compute_subtraction(frame, A).get_number_of_points() == 0,
+        "hole has no single ring", 0);
+  check(Polygon::apply_ops_rings({frame, A}, SetOperation::Difference)
+                .ring_count() == 2,
+        "hole through apply_ops_rings", 0);
+
+  /**< Apart, the union has two parts and the difference is the first. */
+  const Polygon apart = square(5.0, 5.0, 1.0);
+  const MultiPolygon both =
+      Polygon::compute_boolean(A, apart, SetOperation::Union);
+  check(both.ring_count() == 2 && both.get_area() == 5.0, "disjoint union",
+        0);
+  check(Polygon::compute_union(A, apart).get_number_of_points() == 0,
+        "disjoint union has no single ring", 0);
+  check(Polygon::compute_boolean(A, apart, SetOperation::Intersection)
+                .ring_count() == 0,
+        "disjoint intersection", 0);
+  const Polygon kept = Polygon::compute_subtraction(A, apart);
+  check(kept.get_number_of_points() == 4 && area_of(kept) == 4.0,
+        "disjoint difference", 0);
+
+  /**< A polygon with itself. */
+  const Polygon same = Polygon::compute_union(A, A);
+  check(same.get_number_of_points() == 4 && area_of(same) == 4.0,
+        "identical union", 0);
+  check(Polygon::compute_intersection(A, A) == same,
+        "identical intersection", 0);
+  check(Polygon::compute_boolean(A, A, SetOperation::Difference)
+                .ring_count() == 0,
+        "identical difference", 0);
+
+  /**< The result runs counter clockwise however the input runs. */
+  std::mt19937 random(17);
+  std::vector<Point> ring = star_ring(random, 24, {1.0, 1.0}, 3.0, 0.0);
+  const Polygon counterClockwise = Polygon::from_ring(ring);
+  std::reverse(ring.begin(), ring.end());
+  const Polygon clockwise = Polygon::from_ring(ring);
+  for (SetOperation op : {SetOperation::Union, SetOperation::Intersection,
+                          SetOperation::Difference}) {
+    const MultiPolygon expected =
+        Polygon::compute_boolean(counterClockwise, A, op);
+    const MultiPolygon result = Polygon::compute_boolean(clockwise, A, op);
+    check(same_rings(result, expected) && result.ring_count() > 0 &&
+              signed_area(result.ring(0)) > 0.0,
+          "clockwise input", static_cast<int>(op));
+  }
+}
+
+/**< The convex intersection gives the ring the sweep gives, counter
+ * clockwise from the same vertex, whichever way the operands run. */
+void test_convex_shortcut() {
+  const Polygon A = square(0.0, 0.0, 2.0);
+  const Polygon B = Polygon::from_ring({{1.0, 0.5}, {3.0, 1.0}, {1.0, 1.5}});
+  const SetOperation op = SetOperation::Intersection;
+  Polygon::reset_stats();
+  const MultiPolygon shortcut = Polygon::compute_boolean(A, B, op);
+  check(Polygon::stats().convexOperations == 1, "convex shortcut taken", 0);
+  check(same_rings(shortcut, MultiPolygon::compute_operation(
+                                 MultiPolygon(A), MultiPolygon(B), op)),
+        "convex shortcut matches the sweep", 0);
+}
+
+/**< A thin L is not star shaped around its centroid, sorting its vertices
+ * by angle used to cut across it. */
+void test_concave_difference() {
+  const std::vector<Polygon> polygons = {square(0.0, 0.0, 10.0),
+                                         square(1.0, 1.0, 10.0)};
+  const Polygon result =
+      Polygon::apply_ops(polygons, SetOperation::Difference);
+  check(result.is_valid() && result.get_number_of_points() == 6 &&
+            area_of(result) == 19.0,
+        "L shaped difference", 0);
+  check(result == Polygon::compute_subtraction(polygons[0], polygons[1]),
+        "fold and pairwise agree", 0);
+}
+
+/**< Subtracting disjoint polygons in parallel, the union of the subtrahends
+ * is no single ring, gives the same ring as the sequential fold. */
+void test_multi_threaded_difference() {
+  const std::vector<Polygon> polygons = {square(0.0, 0.0, 10.0),
+                                         square(-1.0, -1.0, 3.0),
+                                         square(8.0, 8.0, 3.0)};
+  const Polygon expected =
+      Polygon::apply_ops(polygons, SetOperation::Difference);
+  check(expected.get_number_of_points() == 8, "sequential difference", 0);
+
+  for (unsigned int threads : {1u, 2u, 4u}) {
+    ParallelOptions options;
+    options.threads = threads;
+    options.grainSize = 1;
+    Polygon::set_parallel_options(options);
+    check(Polygon::apply_ops_multi_threaded(polygons,
+                                            SetOperation::Difference) ==
+              expected,
+          "multi threaded difference", static_cast<int>(threads));
+  }
+  Polygon::set_parallel_options(ParallelOptions());
+}
+
+/**< Xor gives an empty polygon on every single ring path and the rings of
+ * the symmetric difference on the sweep. */
+void test_xor() {
+  const std::vector<Polygon> polygons = {square(0.0, 0.0, 10.0),
+                                         square(5.0, 5.0, 10.0)};
+  const SetOperation op = SetOperation::Xor;
+  const OperationRequest request = {&polygons[0], &polygons[1], op};
+
+  check(Polygon::compute_operation(polygons[0], polygons[1], op)
+                .get_number_of_points() == 0,
+        "xor compute_operation", 0);
+  check(Polygon::apply_ops(polygons, op).get_number_of_points() == 0,
+        "xor apply_ops", 0);
+  check(Polygon::apply_ops_multi_threaded(polygons, op)
+                .get_number_of_points() == 0,
+        "xor apply_ops_multi_threaded", 0);
+  check(Polygon::compute_batch(&request, 1)[0].get_number_of_points() == 0,
+        "xor compute_batch", 0);
+  check(std::abs(Polygon::apply_ops_rings(polygons, op).get_area() - 150.0) <
+            1e-9,
+        "xor apply_ops_rings", 0);
+}
+
+/**< Empty intermediate results and unknown operations leave stdout to the
+ * results the batch processor writes there. */
+void test_quiet_stdout() {
+  std::ostringstream captured;
+  std::streambuf *const original = std::cout.rdbuf(captured.rdbuf());
+  const std::vector<Polygon> disjoint = {
+      square(0.0, 0.0, 1.0), square(5.0, 5.0, 1.0), square(0.0, 0.0, 1.0)};
+  const Polygon empty =
+      Polygon::apply_ops(disjoint, SetOperation::Intersection);
+  Polygon::compute_operation(disjoint[0], disjoint[1],
+                             static_cast<SetOperation>(42));
+  std::cout.rdbuf(original);
+
+  check(empty.get_number_of_points() == 0, "empty intersection", 0);
+  check(captured.str().empty(), "nothing printed to stdout", 0);
+}
+
+/**< The callback changes the thread count and runs a reduction of its own,
+ * which fetches the pool again from a thread of the batch. Changing the
+ * count from there and from the caller replaces the pool the batch runs on,
+ * which must neither block nor lose results. */
+void test_async_thread_changes() {
+  std::mt19937 random(22);
+  const Polygon A =
+      Polygon::from_ring(star_ring(random, 40000, {0.0, 0.0}, 10.0, 0.0));
+  const Polygon B = square(-2.0, -2.0, 4.0);
+  const Polygon expected =
+      Polygon::compute_operation(A, B, SetOperation::Union);
+  const std::vector<Polygon> tiles = {square(-2.0, -2.0, 2.0),
+                                      square(0.0, -2.0, 2.0),
+                                      square(-2.0, 0.0, 2.0)};
+
+  const std::vector<OperationRequest> requests(
+      6, OperationRequest{&A, &B, SetOperation::Union});
+  std::vector<Polygon> results(requests.size());
+  std::atomic<unsigned int> changes{0};
+  auto set_threads = [&changes]() {
+    ParallelOptions options;
+    options.threads = 2 + changes.fetch_add(1) % 3;
+    Polygon::set_parallel_options(options);
+  };
+
+  set_threads();
+  std::future<void> finished = Polygon::compute_batch_async(
+      requests.data(), requests.size(),
+      [&](size_t index, Polygon &&result) {
+        results[index] = std::move(result);
+        set_threads();
+        check(Polygon::compute_cascaded_union(tiles).is_valid(),
+              "union inside the callback", static_cast<int>(index));
+      });
+  while (finished.wait_for(std::chrono::milliseconds(1)) !=
+         std::future_status::ready)
+    set_threads();
+  finished.get();
+  Polygon::set_parallel_options(ParallelOptions());
+
+  for (size_t i = 0; i < results.size(); ++i)
+    check(results[i] == expected, "async result", static_cast<int>(i));
+}
+} // namespace
+
+int main() {
+  test_area_identities();
+  test_degenerate_inputs();
+  test_convex_shortcut();
+  test_concave_difference();
+  test_multi_threaded_difference();
+  test_xor();
+  test_quiet_stdout();
+  test_async_thread_changes();
+
+  return finish_tests();
+}
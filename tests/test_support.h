@@ -0,0 +1,121 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include "multi_polygon.h"
+#include "polygon.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * Checks and generators shared by the test programs. Each program runs all
+ * of its checks, printing every one that fails, and exits with 1 if there
+ * was one, so ctest reports the whole list at once.
+ */
+
+/**
+ * @brief Failed checks of the program so far.
+ *
+ * @return The counter.
+ */
+inline int &test_failures() {
+  static int failures = 0;
+  return failures;
+}
+
+/**
+ * @brief Report a failed check, the run goes on with the others.
+ *
+ * @param condition True if the check passed.
+ * @param what What was checked.
+ * @param which Seed or case number, to find the failing input again.
+ */
+inline void check(bool condition, const char *what, int which) {
+  if (condition)
+    return;
+  std::printf("FAILED: %s (case %d)\n", what, which);
+  test_failures()++;
+}
+
+/**
+ * @brief Print the summary of the program.
+ *
+ * @return Exit code for ctest, 0 if every check passed.
+ */
+inline int finish_tests() {
+  if (test_failures() != 0) {
+    std::printf("%d checks failed\n", test_failures());
+    return 1;
+  }
+  std::printf("All checks passed\n");
+  return 0;
+}
+
+/**
+ * @brief Ring around a center with one vertex per angle step and a random
+ * radius. Snapped to a grid of step 1/grid if grid is not 0, which brings
+ * touching and collinear edges between rings, and drawn again until the
+ * snapping leaves it simple.
+ *
+ * @param random Generator of the radii.
+ * @param n Number of vertices.
+ * @param center Center of the ring.
+ * @param radius Largest radius, the smallest is half of it.
+ * @param grid Snapping grid, 0 to keep the exact positions.
+ *
+ * @return The vertices, counter clockwise.
+ */
+inline std::vector<Point> star_ring(std::mt19937 &random, size_t n,
+                                    Point center, double radius, double grid) {
+  std::uniform_real_distribution<double> jitter(0.5, 1.0);
+  std::vector<Point> ring(n);
+  do {
+    for (size_t i = 0; i < n; ++i) {
+      const double angle = 2.0 * M_PI * static_cast<double>(i) / n;
+      const double r = radius * jitter(random);
+      ring[i] = {center.x + r * std::cos(angle),
+                 center.y + r * std::sin(angle)};
+      if (grid != 0.0) {
+        ring[i].x = std::round(ring[i].x * grid) / grid;
+        ring[i].y = std::round(ring[i].y * grid) / grid;
+      }
+    }
+  } while (grid != 0.0 && !Polygon::from_ring(ring).is_valid_brute_force());
+  return ring;
+}
+
+/**
+ * @brief Axis aligned square.
+ *
+ * @param x Left side.
+ * @param y Bottom side.
+ * @param size Length of the sides.
+ *
+ * @return The square.
+ */
+inline Polygon square(double x, double y, double size) {
+  return Polygon({{x, y}, {x + size, y}, {x + size, y + size}, {x, y + size}});
+}
+
+/**
+ * @brief Compare the rings of two results.
+ *
+ * @param a The first result.
+ * @param b The second result.
+ *
+ * @return True if both have the same rings with the same vertices in the
+ * same order.
+ */
+inline bool same_rings(const MultiPolygon &a, const MultiPolygon &b) {
+  const std::vector<Point> &pa = a.get_points(), &pb = b.get_points();
+  if (a.ring_count() != b.ring_count() || pa.size() != pb.size())
+    return false;
+  for (size_t i = 0; i < pa.size(); ++i)
+    if (pa[i].x != pb[i].x || pa[i].y != pb[i].y)
+      return false;
+  return true;
+}
+
+#endif // TEST_SUPPORT_H
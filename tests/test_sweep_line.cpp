@@ -0,0 +1,99 @@
+/**
+ * @file test_sweep_line.cpp
+ * @brief Seeded cross-checks of the Bentley-Ottmann and Shamos-Hoey sweeps
+ * against their brute force versions.
+ */
+
+#include "sweep_line.h"
+#include "test_support.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+/**< Random points in random order, most of these intersect themselves. */
+std::vector<Point> random_ring(std::mt19937 &random, size_t n, double grid) {
+  std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+  std::vector<Point> ring(n);
+  for (Point &point : ring) {
+    point = {coordinate(random), coordinate(random)};
+    point.x = std::round(point.x * grid) / grid;
+    point.y = std::round(point.y * grid) / grid;
+  }
+  return ring;
+}
+
+/**< Both searches report the same pairs at the same points. */
+bool same_crossings(const std::vector<EdgeCrossing> &a,
+                    const std::vector<EdgeCrossing> &b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i)
+    if (a[i].edgeA != b[i].edgeA || a[i].edgeB != b[i].edgeB ||
+        a[i].point.x != b[i].point.x || a[i].point.y != b[i].point.y)
+      return false;
+  return true;
+}
+
+/**< Sweep against the nested loop, small rings take the nested loop in both
+ * so they are kept to a few dozen edges above its cut off. */
+void test_edge_crossings() {
+  for (int seed = 0; seed < 200; ++seed) {
+    std::mt19937 random(seed);
+    const double grid = (seed % 3 == 0) ? 8.0 : 0.0;
+    const std::vector<Point> a =
+        star_ring(random, 20 + random() % 200, {0.0, 0.0}, 10.0, grid);
+    const std::vector<Point> b =
+        star_ring(random, 20 + random() % 200, {4.0, 3.0}, 10.0, grid);
+
+    std::vector<EdgeCrossing> sweep, brute;
+    find_edge_crossings(a, b, sweep);
+    find_edge_crossings_brute_force(a, b, brute);
+    check(same_crossings(sweep, brute), "find_edge_crossings", seed);
+  }
+
+  /**< Ring A long enough to be searched in runs. */
+  std::mt19937 random(7);
+  const std::vector<Point> a =
+      star_ring(random, 3 * crossing_range_size, {0.0, 0.0}, 10.0, 0.0);
+  const std::vector<Point> b = star_ring(random, 150, {3.0, 0.0}, 10.0, 0.0);
+  std::vector<EdgeCrossing> sweep, brute;
+  find_edge_crossings(a, b, sweep);
+  find_edge_crossings_brute_force(a, b, brute);
+  check(same_crossings(sweep, brute), "find_edge_crossings in runs", 7);
+}
+
+/**< Shamos-Hoey and is_valid against their nested loops. */
+void test_self_intersection() {
+  for (int seed = 0; seed < 400; ++seed) {
+    std::mt19937 random(seed);
+    std::vector<Point> ring;
+    if (seed % 2 == 0) {
+      ring = random_ring(random, 4 + random() % 60,
+                         (seed % 4 == 0) ? 1.0 : 64.0);
+    } else {
+      ring = star_ring(random, 20 + random() % 300, {0.0, 0.0}, 10.0,
+                       (seed % 3 == 0) ? 8.0 : 0.0);
+      /**< Pull one vertex across the ring, so some of these intersect. */
+      if (seed % 5 == 1)
+        ring[random() % ring.size()] = {0.0, 0.0};
+    }
+
+    check(has_self_intersection(ring) ==
+              has_self_intersection_brute_force(ring),
+          "has_self_intersection", seed);
+    const Polygon polygon = Polygon::from_ring(ring);
+    check(polygon.is_valid() == polygon.is_valid_brute_force(), "is_valid",
+          seed);
+  }
+}
+} // namespace
+
+int main() {
+  test_edge_crossings();
+  test_self_intersection();
+
+  return finish_tests();
+}
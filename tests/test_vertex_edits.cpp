@@ -0,0 +1,60 @@
+/**
+ * @file test_vertex_edits.cpp
+ * @brief Validity, bounds and area kept through vertex edits, checked
+ * against freshly built rings.
+ */
+
+#include "test_support.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace { /**< Internal helper functions */
+
+/**< Validity, bounds and area kept while editing against a fresh ring. */
+void test_vertex_edits() {
+  for (int seed = 0; seed < 40; ++seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> coordinate(-6.0, 6.0);
+    Polygon polygon = Polygon::from_ring(
+        star_ring(random, 4 + random() % 40, {0.0, 0.0}, 5.0, 0.0));
+    for (int edit = 0; edit < 100; ++edit) {
+      const size_t n = polygon.get_number_of_points();
+      const Point point = {std::round(coordinate(random) * 2.0) / 2.0,
+                           std::round(coordinate(random) * 2.0) / 2.0};
+      switch (random() % 3) {
+      case 0:
+        polygon.insert_vertex(random() % (n + 1), point);
+        break;
+      case 1:
+        polygon.move_vertex(random() % n, point);
+        break;
+      default:
+        if (n > 5)
+          polygon.remove_vertex(random() % n);
+      }
+
+      const PolygonView view(polygon);
+      const Polygon fresh =
+          Polygon::from_ring(std::vector<Point>(view.begin(), view.end()));
+      const BoundingBox kept = polygon.get_bounding_box();
+      const BoundingBox box = fresh.get_bounding_box();
+      check(polygon.is_valid() == fresh.is_valid_brute_force(),
+            "is_valid after an edit", seed);
+      check(kept.minX == box.minX && kept.maxX == box.maxX &&
+                kept.minY == box.minY && kept.maxY == box.maxY,
+            "bounds after an edit", seed);
+      check(std::abs(polygon.get_signed_area() - fresh.get_signed_area()) <
+                1e-9,
+            "area after an edit", seed);
+    }
+  }
+}
+} // namespace
+
+int main() {
+  test_vertex_edits();
+
+  return finish_tests();
+}
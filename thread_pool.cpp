@@ -0,0 +1,199 @@
+#include "thread_pool.h"
+
+#include <chrono>
+
+namespace { /**< Internal helper functions */
+
+thread_local const ThreadPool *currentPool = nullptr; /**< Worker's pool. */
+thread_local size_t currentQueue = 0; /**< Worker's deque in that pool. */
+
+std::mutex sharedMutex;                 /**< Guards both below. */
+std::shared_ptr<ThreadPool> sharedPool; /**< Last pool handed out. */
+
+/**< Replaced pools, kept until nobody else holds them, so that the last
+ * reference is never dropped on one of their own workers. */
+std::vector<std::shared_ptr<ThreadPool>> retiredPools;
+} // namespace
+
+/**< At least one deque, so a pool without workers can queue tasks. */
+ThreadPool::ThreadPool(unsigned int workers) {
+  const size_t count = (workers == 0) ? 1 : workers;
+  for (size_t i = 0; i < count; ++i)
+    queues.emplace_back(new Queue);
+
+  threads.reserve(workers);
+  for (unsigned int i = 0; i < workers; ++i)
+    threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+/**< Workers drain the deques before they see stopping. */
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &thread : threads)
+    thread.join();
+
+  /**< Without workers nobody else runs what is left. */
+  while (run_one()) {
+  }
+}
+
+unsigned int ThreadPool::size() const { return threads.size(); }
+
+/**< Own deque for workers, keeps forked subtasks local. */
+void ThreadPool::submit(std::function<void()> task) {
+  size_t index = own_queue();
+  if (index == queues.size())
+    index = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+  {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    queues[index]->tasks.push_back(std::move(task));
+  }
+  pending.fetch_add(1, std::memory_order_release);
+
+  /**< Taking the lock orders the count before a worker's check. */
+  { std::lock_guard<std::mutex> lock(sleepMutex); }
+  wake.notify_one();
+}
+
+/**< Help from any thread. */
+bool ThreadPool::run_one() {
+  std::function<void()> task;
+  if (!take(own_queue(), task))
+    return false;
+
+  task();
+  return true;
+}
+
+/**< LIFO on the own deque, FIFO when stealing. */
+bool ThreadPool::take(size_t self, std::function<void()> &task) {
+  if (pending.load(std::memory_order_acquire) == 0)
+    return false;
+
+  if (self < queues.size()) {
+    Queue &queue = *queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      pending.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  for (size_t offset = 1; offset <= queues.size(); ++offset) {
+    Queue &queue = *queues[(self + offset) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      pending.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**< Run tasks, sleep while there are none. */
+void ThreadPool::work(size_t index) {
+  currentPool = this;
+  currentQueue = index;
+
+  std::function<void()> task;
+  while (true) {
+    if (take(index, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wake.wait(lock, [this] {
+      return stopping || pending.load(std::memory_order_acquire) > 0;
+    });
+    if (stopping && pending.load(std::memory_order_acquire) == 0)
+      return;
+  }
+}
+
+size_t ThreadPool::own_queue() const {
+  return (currentPool == this) ? currentQueue : queues.size();
+}
+
+TaskGroup::TaskGroup(ThreadPool &pool) : pool(pool) {}
+
+TaskGroup::~TaskGroup() {
+  try {
+    wait();
+  } catch (...) {
+  }
+}
+
+/**< Counts the task and records its exception. */
+void TaskGroup::run(std::function<void()> task) {
+  remaining.fetch_add(1, std::memory_order_relaxed);
+  pool.submit([this, task]() {
+    try {
+      task();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(doneMutex);
+      if (!error)
+        error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(doneMutex);
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      done.notify_all();
+  });
+}
+
+/**< Helps while tasks are queued, sleeps while they only run elsewhere. */
+void TaskGroup::wait() {
+  while (remaining.load(std::memory_order_acquire) != 0) {
+    if (pool.run_one())
+      continue;
+
+    /**< Wake up now and then, a running task may fork more work. */
+    std::unique_lock<std::mutex> lock(doneMutex);
+    done.wait_for(lock, std::chrono::milliseconds(1), [this] {
+      return remaining.load(std::memory_order_acquire) == 0;
+    });
+  }
+
+  std::lock_guard<std::mutex> lock(doneMutex);
+  if (error) {
+    std::exception_ptr thrown = error;
+    error = nullptr;
+    std::rethrow_exception(thrown);
+  }
+}
+
+/**< Reuse the pool while the size matches. Unused retired pools are joined
+ * after the lock is released, their workers may be waiting for it. */
+std::shared_ptr<ThreadPool> shared_thread_pool(unsigned int workers) {
+  std::vector<std::shared_ptr<ThreadPool>> unused;
+  std::lock_guard<std::mutex> lock(sharedMutex);
+  if (!sharedPool || sharedPool->size() != workers) {
+    if (sharedPool)
+      retiredPools.push_back(std::move(sharedPool));
+    sharedPool = std::make_shared<ThreadPool>(workers);
+  }
+
+  /**< Only the list holds them, nobody can take a new reference. */
+  for (size_t i = 0; i < retiredPools.size();) {
+    if (retiredPools[i].use_count() == 1 &&
+        currentPool != retiredPools[i].get()) {
+      unused.push_back(std::move(retiredPools[i]));
+      retiredPools[i] = std::move(retiredPools.back());
+      retiredPools.pop_back();
+    } else {
+      ++i;
+    }
+  }
+  return sharedPool;
+}
@@ -0,0 +1,157 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads with one task deque each. A worker
+ * pushes and pops its own tasks at the back and steals from the front of the
+ * other deques when its own runs dry, so forked subtasks stay on the thread
+ * that created them unless another one is idle.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Start the workers.
+   *
+   * @param workers Number of worker threads, 0 leaves all work to the
+   * threads waiting on it (see TaskGroup::wait).
+   */
+  explicit ThreadPool(unsigned int workers);
+
+  /**
+   * @brief Run the remaining tasks and join the workers.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Get the number of worker threads.
+   *
+   * @return Number of workers.
+   */
+  unsigned int size() const;
+
+  /**
+   * @brief Queue a task, on the calling worker's own deque if it is one of
+   * ours, round robin otherwise.
+   *
+   * @param task The task, must not throw.
+   */
+  void submit(std::function<void()> task);
+
+  /**
+   * @brief Run one queued task on the calling thread if there is any.
+   *
+   * @return True if a task was run.
+   */
+  bool run_one();
+
+private:
+  /**< Task deque of one worker. */
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  /**
+   * @brief Take a task, from the back of the own deque first and from the
+   * front of the others after that.
+   *
+   * @param self Index of the own deque, or size of queues for none.
+   * @param task Output, the task taken.
+   *
+   * @return True if a task was found.
+   */
+  bool take(size_t self, std::function<void()> &task);
+
+  /**
+   * @brief Main loop of worker index.
+   */
+  void work(size_t index);
+
+  /**
+   * @brief Index of the calling thread's deque in this pool.
+   *
+   * @return The index, or queues.size() for other threads.
+   */
+  size_t own_queue() const;
+
+  std::vector<std::unique_ptr<Queue>> queues; /**< One per worker, min 1. */
+  std::vector<std::thread> threads;           /**< The workers. */
+  std::atomic<size_t> pending{0};    /**< Queued tasks not yet taken. */
+  std::atomic<size_t> nextQueue{0};  /**< Round robin for outsiders. */
+  std::mutex sleepMutex;             /**< Guards stopping, pairs wake. */
+  std::condition_variable wake;      /**< Signals new tasks or stop. */
+  bool stopping = false;             /**< Set by the destructor. */
+};
+
+/**
+ * @brief Tasks forked onto a pool that are joined together. The thread
+ * waiting on the group runs queued tasks itself until the group is done,
+ * so nested groups never block a worker and a pool without workers still
+ * makes progress.
+ */
+class TaskGroup {
+public:
+  /**
+   * @brief Create an empty group.
+   *
+   * @param pool Pool the tasks run on.
+   */
+  explicit TaskGroup(ThreadPool &pool);
+
+  /**
+   * @brief Wait for outstanding tasks, swallowing their exceptions.
+   */
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  /**
+   * @brief Fork a task.
+   *
+   * @param task The task, exceptions are rethrown by wait.
+   */
+  void run(std::function<void()> task);
+
+  /**
+   * @brief Help running tasks until every task of the group has finished.
+   * Rethrows the first exception one of them threw.
+   */
+  void wait();
+
+private:
+  ThreadPool &pool;                /**< Where the tasks run. */
+  std::atomic<size_t> remaining{0}; /**< Tasks not yet finished. */
+  std::mutex doneMutex;            /**< Pairs done and guards error. */
+  std::condition_variable done;    /**< Signals the last task finished. */
+  std::exception_ptr error;        /**< First exception of a task. */
+};
+
+/**
+ * @brief Get a process wide pool. The pool is shared by every caller asking
+ * for the same number of workers and replaced when the number changes, the
+ * old pool lives on until its last user releases it and is joined by a later
+ * call from a thread outside it. Tasks may therefore ask for another size
+ * while they run on the old pool.
+ *
+ * @param workers Number of worker threads.
+ *
+ * @return The pool.
+ */
+std::shared_ptr<ThreadPool> shared_thread_pool(unsigned int workers);
+
+#endif // THREAD_POOL_H